@@ -0,0 +1,161 @@
+#include "../src/game.c"
+#include "../../common/src/bench.c"
+
+/*  bullet sweep benchmark
+ *      sweeps a few thousand bullet segments against the asteroids through the grid,
+ *      and checks every result against a brute force pass over all asteroids
+ *
+ *      bench_bullets [results.json [baseline.json]], see bench_finish
+ */
+
+#define BULLETS_REPS 20
+#define BULLETS_DT (1.0f / 60)
+
+
+struct BulletsBench
+{
+    struct AsteroidQueue *aq;
+    struct AsteroidGrid *grid;
+    Vector2 *start;
+    Vector2 *end;
+    size_t *hit;
+    size_t len;
+};
+
+
+/* the first asteroid met by p0 p1, testing every one of them */
+size_t brute_sweep(struct AsteroidQueue *aq, Vector2 p0, Vector2 p1)
+{
+    size_t hit = aq->pool->len;
+    float t_hit = 0;
+    Vector2 mid = Vector2Scale(Vector2Add(p0, p1), 0.5f);
+
+    for (size_t j = 0; j < aq->pool->len; j++) {
+        float t;
+        Vector2 offset = asteroidgrid_image_offset(mid, aq->bodies->position[j]);
+        if (!asteroid_segment(aq, j, offset, p0, p1, &t)) continue;
+        if ((hit == aq->pool->len) || (t < t_hit)) hit = j, t_hit = t;
+    }
+    return hit;
+}
+
+
+void grid_sweeps(void *ctx)
+{
+    struct BulletsBench *bench = ctx;
+    for (size_t b = 0; b < bench->len; b++) {
+        bench->hit[b] = asteroidgrid_sweep(
+            bench->grid, bench->aq, bench->start[b], bench->end[b]
+        );
+    }
+}
+
+
+void brute_sweeps(void *ctx)
+{
+    struct BulletsBench *bench = ctx;
+    for (size_t b = 0; b < bench->len; b++) {
+        bench->hit[b] = brute_sweep(bench->aq, bench->start[b], bench->end[b]);
+    }
+}
+
+
+/* the grid and brute force sweeps, into results[0] and results[1] under names;
+ * false if they disagree
+ */
+bool bullets_bench
+(
+    struct ShapeLibrary *shapes, size_t num_asteroids, size_t num_bullets,
+    const char *const *names, struct BenchResult *results
+)
+{
+    struct BulletsBench bench = {
+        .aq = asteroidqueue_create(num_asteroids, shapes),
+        .grid = asteroidgrid_create(num_asteroids, 1),
+        .start = malloc(num_bullets * sizeof(Vector2)),
+        .end = malloc(num_bullets * sizeof(Vector2)),
+        .hit = malloc(num_bullets * sizeof(size_t)),
+        .len = num_bullets
+    };
+    size_t *expected = malloc(num_bullets * sizeof(size_t));
+    if (
+        !bench.aq || !bench.grid || !bench.start || !bench.end || !bench.hit ||
+        !expected
+    ) {
+        fprintf(stderr, "bullets: allocation failed\n");
+        exit(1);
+    }
+
+    unsigned int rng = rng_seed(1);
+    for (size_t i = 0; i < num_asteroids; i++) {
+        struct Asteroid ast = { 0 };
+        asteroid_randomise(&ast, shapes, &rng);
+        asteroidqueue_insert(bench.aq, ast);
+    }
+    asteroidgrid_build(bench.grid, bench.aq, BULLETS_DT);
+
+    /* bullets from anywhere, in any direction, up to four steps' travel */
+    for (size_t b = 0; b < num_bullets; b++) {
+        float angle = (rng_next(&rng) % 360) * (2 * PI) / 360;
+        float reach = BULLET_VELOCITY * BULLETS_DT * (1 + rng_next(&rng) % 4);
+        bench.start[b] = (Vector2) {
+            rng_next(&rng) % WORLD_WIDTH, rng_next(&rng) % WORLD_HEIGHT
+        };
+        bench.end[b] = Vector2Add(
+            bench.start[b], (Vector2) { reach * cosf(angle), reach * sinf(angle) }
+        );
+    }
+
+    brute_sweeps(&bench);
+    size_t hits = 0;
+    for (size_t b = 0; b < num_bullets; b++) {
+        expected[b] = bench.hit[b];
+        hits += (expected[b] < num_asteroids);
+    }
+
+    grid_sweeps(&bench);
+    size_t mismatched = 0;
+    for (size_t b = 0; b < num_bullets; b++) {
+        mismatched += (bench.hit[b] != expected[b]);
+    }
+
+    printf(
+        "%zu asteroids, %zu bullets, %zu hits, %zu mismatched\n",
+        num_asteroids, num_bullets, hits, mismatched
+    );
+    size_t reps = BULLETS_REPS;
+    size_t n = num_bullets;
+    results[0] = bench_run(names[0], grid_sweeps, &bench, n, reps);
+    results[1] = bench_run(names[1], brute_sweeps, &bench, n, reps);
+    bench_report(results[0]);
+    bench_report(results[1]);
+
+    asteroidqueue_destroy(bench.aq);
+    asteroidgrid_destroy(bench.grid);
+    free(bench.start), free(bench.end);
+    free(bench.hit), free(expected);
+
+    return !mismatched;
+}
+
+
+int main(int argc, char **argv)
+{
+    struct ShapeLibrary *shapes = shapelibrary_create(SHAPELIBRARY_PROTOTYPES);
+    if (!shapes) return 1;
+
+    struct BenchResult results[4];
+    bool ok = bullets_bench(
+        shapes, ASTEROIDS_INITIAL, 5000,
+        (const char *[]) { "  sweep grid initial", "  sweep brute force initial" },
+        results
+    );
+    ok = bullets_bench(
+        shapes, 2000, 5000,
+        (const char *[]) { "  sweep grid 2000", "  sweep brute force 2000" },
+        results + 2
+    ) && ok;
+
+    shapelibrary_destroy(shapes);
+    return (ok && bench_finish(argc, argv, results, 4)) ? 0 : 1;
+}
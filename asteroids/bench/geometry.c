@@ -0,0 +1,185 @@
+#include "../src/game.c"
+#include "../../common/src/bench.c"
+
+/*  geometry kernel benchmark
+ *      the predicates and polygon moments from geometry.c over large random inputs:
+ *      points and segments scattered over the window, and asteroid outlines from the
+ *      shape library placed close enough that about half the neighbouring pairs touch
+ *
+ *      bench_geometry [results.json [baseline.json]], see bench_finish
+ */
+
+#define GEOMETRY_POINTS (1 << 20)
+#define GEOMETRY_POLYGONS (1 << 16)
+#define GEOMETRY_SPREAD 64
+#define GEOMETRY_REPS 20
+
+
+struct GeometryBench
+{
+    Vector2 *points;
+    Vector2 *segments;
+    Vector2 (*polygons)[ASTEROID_VERTICES_MAX];
+    size_t *num_corners;
+    size_t hits;
+    float sum;
+};
+
+
+void bench_point_on_triangle(void *ctx)
+{
+    struct GeometryBench *bench = ctx;
+    for (size_t i = 0; i < GEOMETRY_POINTS; i++) {
+        Vector2 *v = bench->polygons[i % GEOMETRY_POLYGONS];
+        bench->hits += point_on_triangle(bench->points[i], v[0], v[1], v[2]);
+    }
+}
+
+
+void bench_point_on_segment(void *ctx)
+{
+    struct GeometryBench *bench = ctx;
+    for (size_t i = 0; i < GEOMETRY_POINTS; i++) {
+        Vector2 *s = bench->segments + 2*i;
+        bench->hits += point_on_segment(bench->points[i], s[0], s[1]);
+    }
+}
+
+
+void bench_segment_on_segment(void *ctx)
+{
+    struct GeometryBench *bench = ctx;
+    for (size_t i = 0; i < GEOMETRY_POINTS; i++) {
+        Vector2 *s = bench->segments + 2*i;
+        Vector2 *t = bench->segments + 2*((i + 1) % GEOMETRY_POINTS);
+        bench->hits += segment_on_segment(s[0], s[1], t[0], t[1]);
+    }
+}
+
+
+void bench_polygon_is_axis_separate(void *ctx)
+{
+    struct GeometryBench *bench = ctx;
+    for (size_t i = 0; i < GEOMETRY_POLYGONS; i++) {
+        size_t j = (i + 1) % GEOMETRY_POLYGONS;
+        bench->hits += polygon_is_axis_separate(
+            bench->polygons[i], bench->num_corners[i],
+            bench->polygons[j], bench->num_corners[j]
+        );
+    }
+}
+
+
+void bench_polygon_area_moment_0(void *ctx)
+{
+    struct GeometryBench *bench = ctx;
+    for (size_t i = 0; i < GEOMETRY_POLYGONS; i++) {
+        bench->sum += polygon_area_moment_0(bench->polygons[i], bench->num_corners[i]);
+    }
+}
+
+
+void bench_polygon_area_moment_1(void *ctx)
+{
+    struct GeometryBench *bench = ctx;
+    for (size_t i = 0; i < GEOMETRY_POLYGONS; i++) {
+        Vector2 m = polygon_area_moment_1(bench->polygons[i], bench->num_corners[i]);
+        bench->sum += m.x + m.y;
+    }
+}
+
+
+void bench_polygon_area_moment_2(void *ctx)
+{
+    struct GeometryBench *bench = ctx;
+    for (size_t i = 0; i < GEOMETRY_POLYGONS; i++) {
+        bench->sum += polygon_area_moment_2(bench->polygons[i], bench->num_corners[i]);
+    }
+}
+
+
+void geometry_setup(struct GeometryBench *bench, struct ShapeLibrary *shapes)
+{
+    unsigned int rng = rng_seed(1);
+
+    for (size_t i = 0; i < GEOMETRY_POINTS; i++) {
+        bench->points[i] = (Vector2) {
+            rng_next(&rng) % WINDOW_WIDTH, rng_next(&rng) % WINDOW_HEIGHT
+        };
+    }
+
+    /* short segments, so point and segment tests are not all misses */
+    for (size_t i = 0; i < GEOMETRY_POINTS; i++) {
+        Vector2 p = bench->points[rng_next(&rng) % GEOMETRY_POINTS];
+        float dx = (int) (rng_next(&rng) % 65) - 32.0f;
+        float dy = (int) (rng_next(&rng) % 65) - 32.0f;
+        bench->segments[2*i] = p;
+        bench->segments[2*i + 1] = (Vector2) { p.x + dx, p.y + dy };
+    }
+
+    size_t num_prototypes = NUM_ASTEROID_LEVELS * shapes->per_level;
+    for (size_t i = 0; i < GEOMETRY_POLYGONS; i++) {
+        struct AsteroidPrototype *proto =
+            shapes->prototypes + rng_next(&rng) % num_prototypes;
+        Vector2 centre = {
+            rng_next(&rng) % GEOMETRY_SPREAD, rng_next(&rng) % GEOMETRY_SPREAD
+        };
+
+        bench->num_corners[i] = proto->num_corners;
+        for (size_t k = 0; k < proto->num_corners; k++) {
+            bench->polygons[i][k] = Vector2Add(proto->corners[k], centre);
+        }
+    }
+}
+
+
+int main(int argc, char **argv)
+{
+    struct ShapeLibrary *shapes = shapelibrary_create(SHAPELIBRARY_PROTOTYPES);
+    struct GeometryBench bench = {
+        .points = malloc(GEOMETRY_POINTS * sizeof(Vector2)),
+        .segments = malloc(2 * GEOMETRY_POINTS * sizeof(Vector2)),
+        .polygons = malloc(GEOMETRY_POLYGONS * sizeof(*bench.polygons)),
+        .num_corners = malloc(GEOMETRY_POLYGONS * sizeof(size_t))
+    };
+    if (
+        !shapes || !bench.points || !bench.segments || !bench.polygons ||
+        !bench.num_corners
+    ) {
+        fprintf(stderr, "geometry: allocation failed\n");
+        return 1;
+    }
+
+    geometry_setup(&bench, shapes);
+
+    size_t np = GEOMETRY_POINTS, ng = GEOMETRY_POLYGONS, reps = GEOMETRY_REPS;
+    struct BenchResult results[] = {
+        bench_run("  point_on_triangle", bench_point_on_triangle, &bench, np, reps),
+        bench_run("  point_on_segment", bench_point_on_segment, &bench, np, reps),
+        bench_run("  segment_on_segment", bench_segment_on_segment, &bench, np, reps),
+        bench_run(
+            "  polygon_is_axis_separate", bench_polygon_is_axis_separate, &bench, ng,
+            reps
+        ),
+        bench_run(
+            "  polygon_area_moment_0", bench_polygon_area_moment_0, &bench, ng, reps
+        ),
+        bench_run(
+            "  polygon_area_moment_1", bench_polygon_area_moment_1, &bench, ng, reps
+        ),
+        bench_run(
+            "  polygon_area_moment_2", bench_polygon_area_moment_2, &bench, ng, reps
+        )
+    };
+    size_t n = sizeof(results) / sizeof(results[0]);
+
+    printf("geometry, %zu points and segments, %zu polygons\n", np, ng);
+    for (size_t i = 0; i < n; i++) bench_report(results[i]);
+    printf("  (%zu hits, sum %g)\n", bench.hits, bench.sum);
+
+    free(bench.points), free(bench.segments);
+    free(bench.polygons), free(bench.num_corners);
+    shapelibrary_destroy(shapes);
+
+    return !bench_finish(argc, argv, results, n);
+}
@@ -0,0 +1,127 @@
+#include "../src/game.c"
+#include "../../common/src/bench.c"
+
+/*  integration kernel benchmark
+ *      checks the batched physics_integrate_wrap against the scalar path over many
+ *      steps, then times both over the whole queue
+ *
+ *      bench_integrate [results.json [baseline.json]], see bench_finish
+ */
+
+#define INTEGRATE_REPS 50
+#define INTEGRATE_CHECK_STEPS 600
+#define INTEGRATE_DT (1.0f / 60)
+
+
+void scalar_update(void *ctx)
+{
+    struct AsteroidQueue *aq = ctx;
+    struct PhysicsWorld *w = aq->bodies;
+    physics_integrate_wrap_scalar(
+        w->position, w->prev_position, w->velocity, w->radius, w->rotation, w->spin,
+        0, w->len, INTEGRATE_DT, w->size
+    );
+}
+
+
+void batch_update(void *ctx)
+{
+    struct AsteroidQueue *aq = ctx;
+    physics_world_step(aq->bodies, INTEGRATE_DT);
+}
+
+
+/* largest difference in centre or rotation between two queues */
+float integrate_error(struct AsteroidQueue *a, struct AsteroidQueue *b)
+{
+    struct PhysicsWorld *u = a->bodies, *v = b->bodies;
+    float error = 0;
+    for (size_t i = 0; i < a->pool->len; i++) {
+        error = fmaxf(error, fabsf(u->position[i].x - v->position[i].x));
+        error = fmaxf(error, fabsf(u->position[i].y - v->position[i].y));
+        error = fmaxf(error, fabsf(u->rotation[i] - v->rotation[i]));
+    }
+    return error;
+}
+
+
+/* the scalar and batched kernels over n asteroids, into results[0] and results[1]
+ * under names; false if they disagree
+ */
+bool integrate_bench
+(
+    struct ShapeLibrary *shapes, size_t n, const char *const *names,
+    struct BenchResult *results
+)
+{
+    struct AsteroidQueue *scalar = asteroidqueue_create(n, shapes);
+    struct AsteroidQueue *batch = asteroidqueue_create(n, shapes);
+    if (!scalar || !batch) {
+        fprintf(stderr, "integrate: allocation failed for %zu asteroids\n", n);
+        exit(1);
+    }
+
+    unsigned int rng = rng_seed(1);
+    for (size_t i = 0; i < n; i++) {
+        struct Asteroid ast = { 0 };
+        asteroid_randomise(&ast, shapes, &rng);
+        asteroidqueue_insert(scalar, ast);
+        asteroidqueue_insert(batch, ast);
+    }
+
+    for (size_t step = 0; step < INTEGRATE_CHECK_STEPS; step++) {
+        scalar_update(scalar);
+        batch_update(batch);
+    }
+    float error = integrate_error(scalar, batch);
+
+    printf(
+        "%zu asteroids, max error %g after %d steps\n",
+        n, error, INTEGRATE_CHECK_STEPS
+    );
+    size_t reps = INTEGRATE_REPS;
+    results[0] = bench_run(names[0], scalar_update, scalar, n, reps);
+    results[1] = bench_run(names[1], batch_update, batch, n, reps);
+    bench_report(results[0]);
+    bench_report(results[1]);
+    printf("  speedup %.2fx\n", results[0].best / results[1].best);
+
+    asteroidqueue_destroy(scalar);
+    asteroidqueue_destroy(batch);
+
+    if (error > PHYSICS_INTEGRATE_TOLERANCE) {
+        fprintf(
+            stderr, "integrate: error %g exceeds %g\n",
+            error, PHYSICS_INTEGRATE_TOLERANCE
+        );
+        return false;
+    }
+    return true;
+}
+
+
+int main(int argc, char **argv)
+{
+#if defined(__AVX__)
+    printf("physics_integrate_wrap: AVX\n");
+#elif defined(__SSE2__)
+    printf("physics_integrate_wrap: SSE2\n");
+#else
+    printf("physics_integrate_wrap: scalar\n");
+#endif
+
+    struct ShapeLibrary *shapes = shapelibrary_create(SHAPELIBRARY_PROTOTYPES);
+    if (!shapes) return 1;
+
+    struct BenchResult results[4];
+    bool ok = integrate_bench(
+        shapes, 1003, (const char *[]) { "  scalar 1k", "  batch 1k" }, results
+    );
+    ok = integrate_bench(
+        shapes, 100000, (const char *[]) { "  scalar 100k", "  batch 100k" },
+        results + 2
+    ) && ok;
+
+    shapelibrary_destroy(shapes);
+    return (ok && bench_finish(argc, argv, results, 4)) ? 0 : 1;
+}
@@ -0,0 +1,255 @@
+#include "../src/game.c"
+#include "../../common/src/bench.c"
+
+/*  asteroid storage layout benchmark
+ *      compares the per-step passes which only read centre, velocity and radius
+ *      (integration, and binning into the broadphase grid) between the array of
+ *      records AsteroidQueue was before the split and the structure-of-arrays
+ *      AsteroidQueue, and times spawning a whole queue from the shape library
+ *
+ *      integration is a whole-range pass on both sides doing the same work: an inline
+ *      loop over the records, the scalar kernel over the arrays in one call, and the
+ *      batched one (see common/src/integrate.c) as the game runs it
+ *
+ *      bench_layout [results.json [baseline.json]], see bench_finish
+ */
+
+#define LAYOUT_REPS 20
+#define LAYOUT_KERNELS 6
+#define LAYOUT_DT (1.0f / 60)
+
+
+/* the asteroid record as it was before the split, with the previous centre the
+ * fixed timestep added, so both layouts integrate the same fields
+ */
+struct AsteroidRecord
+{
+    Vector2 corners[ASTEROID_VERTICES_MAX];
+    Vector2 centre;
+    Vector2 prev_centre;
+    Vector2 velocity;
+    float radius;
+    float mass;
+    float inv_mass;
+    float moi;
+    float inv_moi;
+    float rotation;
+    float spin;
+    float hitpoints;
+    enum ASTEROID_LEVEL level;
+    bool collision;
+    Color colour;
+};
+
+
+/* reference array-of-structs storage, as AsteroidQueue was before the split */
+struct AsteroidArray
+{
+    struct AsteroidRecord *asteroids;
+    size_t len;
+};
+
+
+struct LayoutBench
+{
+    struct ShapeLibrary *shapes;
+    struct AsteroidArray aos;
+    struct AsteroidQueue *soa;
+    struct AsteroidGrid *grid;
+    unsigned int rng;
+};
+
+
+/* physics_integrate_wrap_scalar's loop, over the records */
+void aos_update(void *ctx)
+{
+    struct AsteroidArray *arr = &((struct LayoutBench *) ctx)->aos;
+
+    for (size_t i = 0; i < arr->len; i++) {
+        struct AsteroidRecord *ast = arr->asteroids + i;
+        float buffer = ast->radius;
+        ast->prev_centre = ast->centre;
+        ast->rotation += ast->spin * LAYOUT_DT;
+        ast->centre = vector2_wrap(
+            Vector2Add(ast->centre, Vector2Scale(ast->velocity, LAYOUT_DT)),
+            (const Vector2) { -buffer, -buffer },
+            (const Vector2) { WORLD_WIDTH + buffer, WORLD_HEIGHT + buffer }
+        );
+    }
+}
+
+
+void soa_update(void *ctx)
+{
+    struct PhysicsWorld *w = ((struct LayoutBench *) ctx)->soa->bodies;
+    physics_integrate_wrap_scalar(
+        w->position, w->prev_position, w->velocity, w->radius, w->rotation, w->spin,
+        0, w->len, LAYOUT_DT, w->size
+    );
+}
+
+
+void soa_update_batch(void *ctx)
+{
+    physics_world_step(((struct LayoutBench *) ctx)->soa->bodies, LAYOUT_DT);
+}
+
+
+/* asteroidgrid_build, reading from the array of structs */
+void aos_build(void *ctx)
+{
+    struct LayoutBench *bench = ctx;
+    struct AsteroidArray *arr = &bench->aos;
+    struct AsteroidGrid *grid = bench->grid;
+
+    float radius = ASTEROIDLEVEL_RADIUS[NUM_ASTEROID_LEVELS - 1];
+    for (size_t i = 0; i < arr->len; i++) {
+        struct AsteroidRecord *a = arr->asteroids + i;
+        float swept = a->radius + 0.5f * LAYOUT_DT * Vector2Length(a->velocity);
+        if (swept > radius) radius = swept;
+    }
+
+    float cell_min = 2 * radius * (1 + EPSILON);
+    size_t cols = WORLD_WIDTH / cell_min, rows = WORLD_HEIGHT / cell_min;
+    if ((cols < 1) || (rows < 1) || (cols * rows != grid->num_cells)) return;
+
+    for (size_t c = 0; c <= grid->num_cells; c++) grid->cell_start[c] = 0;
+
+    for (size_t i = 0; i < arr->len; i++) {
+        struct AsteroidRecord *a = arr->asteroids + i;
+        Vector2 swept = Vector2Subtract(
+            a->centre, Vector2Scale(a->velocity, 0.5f * LAYOUT_DT)
+        );
+        grid->cell_of[i] = asteroidgrid_cell(grid, swept);
+        grid->cell_start[grid->cell_of[i] + 1]++;
+    }
+    for (size_t c = 0; c < grid->num_cells; c++) {
+        grid->cell_start[c + 1] += grid->cell_start[c];
+    }
+    for (size_t i = 0; i < arr->len; i++) {
+        grid->entries[grid->cell_start[grid->cell_of[i]]++] = i;
+    }
+    for (size_t c = grid->num_cells; c > 0; c--) {
+        grid->cell_start[c] = grid->cell_start[c - 1];
+    }
+    grid->cell_start[0] = 0;
+}
+
+
+void soa_build(void *ctx)
+{
+    struct LayoutBench *bench = ctx;
+    asteroidgrid_build(bench->grid, bench->soa, LAYOUT_DT);
+}
+
+
+/* n fresh asteroids into an empty queue, as a wave spawning in one frame */
+void soa_spawn(void *ctx)
+{
+    struct LayoutBench *bench = ctx;
+    struct AsteroidQueue *aq = asteroidqueue_create(bench->aos.len, bench->shapes);
+    if (!aq) return;
+
+    for (size_t i = 0; i < bench->aos.len; i++) {
+        struct Asteroid a;
+        asteroid_randomise(&a, bench->shapes, &bench->rng);
+        asteroidqueue_insert(aq, a);
+    }
+    asteroidqueue_destroy(aq);
+}
+
+
+/* each kernel over n asteroids, into results under names */
+void layout_bench
+(
+    struct ShapeLibrary *shapes, size_t n, const char *const *names,
+    struct BenchResult *results
+)
+{
+    static void (*const kernels[LAYOUT_KERNELS])(void *) = {
+        aos_update, soa_update, soa_update_batch, aos_build, soa_build, soa_spawn
+    };
+
+    struct LayoutBench bench = {
+        .shapes = shapes,
+        .aos = { .asteroids = malloc(n * sizeof(struct AsteroidRecord)), .len = n },
+        .soa = asteroidqueue_create(n, shapes),
+        .grid = asteroidgrid_create(n, 1),
+        .rng = rng_seed(1)
+    };
+    if (!bench.aos.asteroids || !bench.soa || !bench.grid) {
+        fprintf(stderr, "layout: allocation failed for %zu asteroids\n", n);
+        exit(1);
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        struct Asteroid a;
+        asteroid_randomise(&a, shapes, &bench.rng);
+        asteroidqueue_insert(bench.soa, a);
+
+        const struct AsteroidPrototype *proto = shapes->prototypes + a.prototype;
+        struct AsteroidRecord *r = bench.aos.asteroids + i;
+        *r = (struct AsteroidRecord) {
+            .centre = a.centre,
+            .prev_centre = a.centre,
+            .velocity = a.velocity,
+            .radius = a.radius,
+            .mass = proto->mass,
+            .inv_mass = proto->inv_mass,
+            .moi = proto->moi,
+            .inv_moi = proto->inv_moi,
+            .rotation = a.rotation,
+            .spin = a.spin,
+            .hitpoints = a.hitpoints,
+            .level = proto->level,
+            .collision = a.collision,
+            .colour = a.colour
+        };
+        for (size_t k = 0; k < proto->num_corners; k++) {
+            r->corners[k] = proto->corners[k];
+        }
+    }
+    asteroidgrid_build(bench.grid, bench.soa, LAYOUT_DT);
+
+    printf("%zu asteroids\n", n);
+    for (size_t k = 0; k < LAYOUT_KERNELS; k++) {
+        results[k] = bench_run(names[k], kernels[k], &bench, n, LAYOUT_REPS);
+        bench_report(results[k]);
+    }
+
+    free(bench.aos.asteroids);
+    asteroidqueue_destroy(bench.soa);
+    asteroidgrid_destroy(bench.grid);
+}
+
+
+int main(int argc, char **argv)
+{
+    static const size_t sizes[] = { 10000, 100000 };
+    static const char *const names[][LAYOUT_KERNELS] = {
+        {
+            "  update  array-of-structs 10k", "  update  struct-of-arrays 10k",
+            "  update  struct-of-arrays batch 10k",
+            "  binning array-of-structs 10k", "  binning struct-of-arrays 10k",
+            "  spawn   struct-of-arrays 10k"
+        },
+        {
+            "  update  array-of-structs 100k", "  update  struct-of-arrays 100k",
+            "  update  struct-of-arrays batch 100k",
+            "  binning array-of-structs 100k", "  binning struct-of-arrays 100k",
+            "  spawn   struct-of-arrays 100k"
+        }
+    };
+    size_t num_sizes = sizeof(sizes) / sizeof(sizes[0]);
+
+    struct ShapeLibrary *shapes = shapelibrary_create(SHAPELIBRARY_PROTOTYPES);
+    if (!shapes) return 1;
+
+    struct BenchResult results[sizeof(sizes) / sizeof(sizes[0]) * LAYOUT_KERNELS];
+    for (size_t s = 0; s < num_sizes; s++) {
+        layout_bench(shapes, sizes[s], names[s], results + s * LAYOUT_KERNELS);
+    }
+
+    shapelibrary_destroy(shapes);
+    return !bench_finish(argc, argv, results, num_sizes * LAYOUT_KERNELS);
+}
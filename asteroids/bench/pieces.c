@@ -0,0 +1,196 @@
+#include "../src/game.c"
+#include "../../common/src/bench.c"
+
+/*  convex piece narrowphase benchmark
+ *      pairs of the largest asteroids placed from half to just over their summed radii
+ *      apart, at random turns: once with only convex prototypes, once with only
+ *      concave ones, which the narrowphase tests piece by piece, and once with a
+ *      concave and a convex one, either way round
+ *
+ *      each pair's result is checked against a brute force overlap test of the two
+ *      whole outlines (crossing edges, or one holding a corner of the other), and any
+ *      difference fails the bench. the timed kernel runs the narrowphase on every pair
+ *      with its sat cache cleared, so each test is a full one
+ *
+ *      bench_pieces [results.json [baseline.json]], see bench_finish
+ */
+
+#define PIECES_PAIRS 4096
+#define PIECES_REPS 20
+
+
+/* which prototypes a set's pairs are made of */
+enum PIECES_SET
+{
+    PIECES_CONVEX,
+    PIECES_CONCAVE,
+    PIECES_MIXED,
+    NUM_PIECES_SETS
+};
+
+
+struct PiecesBench
+{
+    struct AsteroidQueue *aq;
+    size_t hits;
+};
+
+
+/* whether p is inside the outline, by the parity of the edges a ray along x crosses */
+bool pieces_point_inside(Vector2 p, Vector2 *v, size_t n)
+{
+    bool inside = false;
+    for (size_t k = 0; k < n; k++) {
+        Vector2 a = v[k], b = v[(k + 1) % n];
+        if ((a.y > p.y) == (b.y > p.y)) continue;
+        float x = a.x + (p.y - a.y) * (b.x - a.x) / (b.y - a.y);
+        if (p.x < x) inside = !inside;
+    }
+    return inside;
+}
+
+
+/* whether the whole outlines of asteroids i and j overlap */
+bool pieces_brute_overlap(struct AsteroidQueue *aq, size_t i, size_t j)
+{
+    Vector2 *v1 = aq->world[i].v, *v2 = aq->world[j].v;
+    size_t n1 = asteroid_num_corners(aq, i), n2 = asteroid_num_corners(aq, j);
+
+    for (size_t k = 0; k < n1; k++) {
+        for (size_t m = 0; m < n2; m++) {
+            if (segment_on_segment(v1[k], v1[(k + 1) % n1], v2[m], v2[(m + 1) % n2])) {
+                return true;
+            }
+        }
+    }
+    return pieces_point_inside(v1[0], v2, n2) || pieces_point_inside(v2[0], v1, n1);
+}
+
+
+void pieces_contacts(void *ctx)
+{
+    struct PiecesBench *bench = ctx;
+    struct AsteroidQueue *aq = bench->aq;
+    struct PolygonContact contacts[ASTEROID_CONTACTS_MAX];
+    struct SatCacheStats stats = { 0 };
+
+    for (size_t i = 0; i < aq->pool->len; i += 2) {
+        satcache_clear(aq->satcache + i);
+        bench->hits += asteroid_contact(
+            aq, i, i + 1, (Vector2) { 0, 0 }, contacts, &stats
+        );
+    }
+}
+
+
+/* PIECES_PAIRS pairs of level 2 prototypes from the set; returns the narrowphase
+ * result for each pair which disagrees with the brute force one
+ */
+size_t pieces_setup
+(
+    struct PiecesBench *bench, const struct ShapeLibrary *shapes, enum PIECES_SET set
+)
+{
+    static const char *names[NUM_PIECES_SETS] = { "convex", "concave", "mixed" };
+
+    /* candidates[1] the concave prototypes, candidates[0] the convex ones */
+    size_t candidates[2][SHAPELIBRARY_PROTOTYPES], num[2] = { 0, 0 };
+    for (size_t k = 0; k < shapes->per_level; k++) {
+        size_t p = shapelibrary_index(shapes, LEVEL2, k);
+        size_t concave = shapes->prototypes[p].num_pieces > 1;
+        candidates[concave][num[concave]++] = p;
+    }
+    bool wanted[2] = { set != PIECES_CONCAVE, set != PIECES_CONVEX };
+    if ((wanted[0] && !num[0]) || (wanted[1] && !num[1])) {
+        fprintf(stderr, "pieces: no prototypes for the %s pairs\n", names[set]);
+        exit(1);
+    }
+
+    unsigned int rng = rng_seed(1);
+    for (size_t k = 0; k < PIECES_PAIRS; k++) {
+        struct Asteroid a[2];
+        for (size_t e = 0; e < 2; e++) {
+            /* mixed pairs alternate which of the two is the concave one */
+            size_t concave = (set == PIECES_MIXED) ? (k + e) % 2 : set;
+            asteroid_clear(a + e);
+            a[e].prototype = candidates[concave][rng_next(&rng) % num[concave]];
+            a[e].radius = shapes->prototypes[a[e].prototype].radius;
+            a[e].rotation = (rng_next(&rng) % 360) * (2 * PI) / 360;
+        }
+
+        float angle = (rng_next(&rng) % 360) * (2 * PI) / 360;
+        float apart = (a[0].radius + a[1].radius) * (50 + rng_next(&rng) % 60) / 100;
+        a[0].centre = (Vector2) {
+            rng_next(&rng) % WORLD_WIDTH, rng_next(&rng) % WORLD_HEIGHT
+        };
+        a[1].centre = Vector2Add(
+            a[0].centre, (Vector2) { apart * cosf(angle), apart * sinf(angle) }
+        );
+        for (size_t e = 0; e < 2; e++) asteroidqueue_insert(bench->aq, a[e]);
+    }
+
+    struct AsteroidQueue *aq = bench->aq;
+    struct PolygonContact contacts[ASTEROID_CONTACTS_MAX];
+    struct SatCacheStats stats = { 0 };
+    size_t mismatched = 0, touching = 0;
+    for (size_t i = 0; i < aq->pool->len; i += 2) {
+        bool found = asteroid_contact(
+            aq, i, i + 1, (Vector2) { 0, 0 }, contacts, &stats
+        );
+        bool expected = pieces_brute_overlap(aq, i, i + 1);
+        mismatched += (found != expected);
+        touching += expected;
+    }
+
+    printf(
+        "  %-7s %zu convex and %zu concave prototypes, %d pairs, %zu touching, "
+        "%zu mismatched\n", names[set], (wanted[0]) ? num[0] : 0,
+        (wanted[1]) ? num[1] : 0, PIECES_PAIRS, touching, mismatched
+    );
+    return mismatched;
+}
+
+
+int main(int argc, char **argv)
+{
+    struct ShapeLibrary *shapes = shapelibrary_create(SHAPELIBRARY_PROTOTYPES);
+    if (!shapes) return 1;
+
+    printf("pieces, pairs of level 2 asteroids about to touch\n");
+    static const char *names[NUM_PIECES_SETS] = {
+        "  contact convex", "  contact concave", "  contact mixed"
+    };
+    struct BenchResult results[NUM_PIECES_SETS];
+    size_t mismatched = 0;
+    for (size_t set = 0; set < NUM_PIECES_SETS; set++) {
+        struct PiecesBench bench = {
+            .aq = asteroidqueue_create(2 * PIECES_PAIRS, shapes)
+        };
+        if (!bench.aq) {
+            fprintf(stderr, "pieces: allocation failed\n");
+            return 1;
+        }
+
+        mismatched += pieces_setup(&bench, shapes, set);
+        results[set] = bench_run(
+            names[set], pieces_contacts, &bench, PIECES_PAIRS, PIECES_REPS
+        );
+        asteroidqueue_destroy(bench.aq);
+    }
+
+    size_t n = sizeof(results) / sizeof(results[0]);
+    for (size_t i = 0; i < n; i++) bench_report(results[i]);
+    printf(
+        "  concave / convex %.2f, mixed / convex %.2f\n",
+        results[PIECES_CONCAVE].best / results[PIECES_CONVEX].best,
+        results[PIECES_MIXED].best / results[PIECES_CONVEX].best
+    );
+
+    shapelibrary_destroy(shapes);
+
+    if (mismatched) {
+        fprintf(stderr, "pieces: %zu pairs disagree with brute force\n", mismatched);
+        return 1;
+    }
+    return !bench_finish(argc, argv, results, n);
+}
@@ -0,0 +1,201 @@
+#include "../src/game.c"
+#include "../../common/src/bench.c"
+
+/*  contact solver benchmark
+ *      a packed cluster of small asteroids, pulled towards its centre every step so
+ *      the contacts stay loaded, is settled for a while and then measured: the
+ *      residual is the mean, over the last steps, of how far the normal speeds at the
+ *      contact points are left from their targets once the solve is done
+ *
+ *      each iteration count is run warm started, as the game runs, and cold, with
+ *      the cached impulses dropped before every solve; it fails if warm starting at
+ *      SOLVER_WARM_ITERATIONS is not at least as close as starting cold at
+ *      PHYSICS_ITERATIONS. the timed kernel is a whole collision step
+ *
+ *      bench_solver [results.json [baseline.json]], see bench_finish
+ */
+
+#define SOLVER_SIDE 24
+#define SOLVER_PULL 0.5f
+#define SOLVER_SETTLE_STEPS 600
+#define SOLVER_MEASURE_STEPS 60
+#define SOLVER_WARM_ITERATIONS 2
+#define SOLVER_REPS 20
+#define SOLVER_DT (1.0f / 60)
+
+
+struct SolverBench
+{
+    struct AsteroidQueue *aq;
+    struct AsteroidGrid *grid;
+    bool cold;
+};
+
+
+/* SOLVER_SIDE x SOLVER_SIDE of the smallest asteroids, at rest and a little closer
+ * than their bounding circles allow, around the middle of the world
+ */
+void solver_setup(struct SolverBench *bench, struct ShapeLibrary *shapes)
+{
+    float spacing = 1.6f * ASTEROIDLEVEL_RADIUS[0];
+    Vector2 corner = {
+        (WORLD_WIDTH - SOLVER_SIDE * spacing) / 2,
+        (WORLD_HEIGHT - SOLVER_SIDE * spacing) / 2
+    };
+
+    for (size_t row = 0; row < SOLVER_SIDE; row++) {
+        for (size_t col = 0; col < SOLVER_SIDE; col++) {
+            size_t prototype = shapelibrary_index(
+                shapes, 0, row * SOLVER_SIDE + col
+            );
+            struct Asteroid a = {
+                .prototype = prototype,
+                .centre = {
+                    corner.x + (col + 0.5f * (row % 2)) * spacing,
+                    corner.y + row * spacing
+                },
+                .radius = shapes->prototypes[prototype].radius,
+                .hitpoints = 100,
+                .colour = WHITE
+            };
+            asteroidqueue_insert(bench->aq, a);
+        }
+    }
+    asteroidgrid_build(bench->grid, bench->aq, 0);
+}
+
+
+/* one step: pull every asteroid towards the centre, move, then collide */
+void solver_step(void *ctx)
+{
+    struct SolverBench *bench = ctx;
+    struct PhysicsWorld *w = bench->aq->bodies;
+    Vector2 centre = { WORLD_WIDTH / 2.0f, WORLD_HEIGHT / 2.0f };
+
+    for (size_t i = 0; i < w->len; i++) {
+        Vector2 pull = Vector2Scale(
+            Vector2Subtract(centre, w->position[i]), SOLVER_PULL * SOLVER_DT
+        );
+        w->velocity[i] = Vector2Add(w->velocity[i], pull);
+    }
+
+    asteroidqueue_update(bench->aq, SOLVER_DT);
+    asteroidgrid_build(bench->grid, bench->aq, SOLVER_DT);
+    if (bench->cold) physics_world_cache(w, NULL, 0);
+    asteroidgrid_collide(bench->grid, bench->aq, NULL, SOLVER_DT);
+}
+
+
+/* mean over the points of the last solve of the gap between the normal speed and
+ * its target: either side of it while the point pushes, short of it when it does not
+ */
+float solver_residual(struct SolverBench *bench)
+{
+    struct PhysicsWorld *w = bench->aq->bodies;
+    size_t num_points = 0;
+    float residual = 0;
+
+    for (size_t k = 0; k < w->num_cached; k++) {
+        const struct PhysicsManifold *m = w->cache + k;
+        for (size_t q = 0; q < m->num_points; q++) {
+            const struct PhysicsPoint *p = w->points + k*PHYSICS_MANIFOLD_POINTS + q;
+            Vector2 dv = Vector2Subtract(
+                Vector2Add(
+                    w->velocity[m->b],
+                    Vector2Scale((Vector2) { -p->rb.y, p->rb.x }, w->spin[m->b])
+                ),
+                Vector2Add(
+                    w->velocity[m->a],
+                    Vector2Scale((Vector2) { -p->ra.y, p->ra.x }, w->spin[m->a])
+                )
+            );
+            float gap = vector2_dot(dv, m->normal) - p->bias;
+            residual += (m->impulse[q] > 0) ? fabsf(gap) : fmaxf(-gap, 0);
+            num_points++;
+        }
+    }
+
+    return (num_points) ? residual / num_points : 0;
+}
+
+
+/* settle a fresh cluster with the given iterations, then measure and time it */
+float solver_run
+(
+    struct ShapeLibrary *shapes, size_t iterations, bool cold, struct BenchResult *res
+)
+{
+    struct SolverBench bench = {
+        .aq = asteroidqueue_create(SOLVER_SIDE * SOLVER_SIDE, shapes),
+        .grid = asteroidgrid_create(SOLVER_SIDE * SOLVER_SIDE, 1),
+        .cold = cold
+    };
+    if (!bench.aq || !bench.grid) {
+        fprintf(stderr, "solver: allocation failed\n");
+        exit(1);
+    }
+    bench.aq->bodies->solver.iterations = iterations;
+    bench.aq->bodies->solver.restitution = 0;
+
+    solver_setup(&bench, shapes);
+    for (size_t step = 0; step < SOLVER_SETTLE_STEPS; step++) solver_step(&bench);
+
+    float residual = 0;
+    for (size_t step = 0; step < SOLVER_MEASURE_STEPS; step++) {
+        solver_step(&bench);
+        residual += solver_residual(&bench);
+    }
+    residual /= SOLVER_MEASURE_STEPS;
+
+    size_t contacts = bench.aq->bodies->num_cached;
+    printf(
+        "  %-4s %2zu iterations  %4zu contacts  residual %8.4f\n",
+        (cold) ? "cold" : "warm", iterations, contacts, residual
+    );
+    if (res) {
+        *res = bench_run(
+            (cold) ? "  collide cold" : "  collide warm", solver_step, &bench,
+            (contacts) ? contacts : 1, SOLVER_REPS
+        );
+    }
+
+    asteroidqueue_destroy(bench.aq);
+    asteroidgrid_destroy(bench.grid);
+    return residual;
+}
+
+
+int main(int argc, char **argv)
+{
+    struct ShapeLibrary *shapes = shapelibrary_create(SHAPELIBRARY_PROTOTYPES);
+    if (!shapes) return 1;
+
+    printf(
+        "solver, %d asteroids pulled together, after %d steps\n",
+        SOLVER_SIDE * SOLVER_SIDE, SOLVER_SETTLE_STEPS
+    );
+    /* timed at the default iterations */
+    struct BenchResult results[2];
+    float warm = 0, cold = 0;
+    for (size_t iterations = 1; iterations <= PHYSICS_ITERATIONS; iterations *= 2) {
+        bool timed = (iterations == PHYSICS_ITERATIONS);
+        struct BenchResult *res = (timed) ? results : NULL;
+        float r_warm = solver_run(shapes, iterations, false, res);
+        float r_cold = solver_run(shapes, iterations, true, (timed) ? res + 1 : NULL);
+        if (iterations == SOLVER_WARM_ITERATIONS) warm = r_warm;
+        if (timed) cold = r_cold;
+    }
+    size_t n = sizeof(results) / sizeof(results[0]);
+    for (size_t i = 0; i < n; i++) bench_report(results[i]);
+
+    shapelibrary_destroy(shapes);
+
+    if (warm > cold) {
+        fprintf(
+            stderr, "solver: warm started at %d iterations, residual %g exceeds %g "
+            "cold at %d\n", SOLVER_WARM_ITERATIONS, warm, cold, PHYSICS_ITERATIONS
+        );
+        return 1;
+    }
+    return !bench_finish(argc, argv, results, n);
+}
@@ -0,0 +1,85 @@
+#include "../src/game.c"
+#include "../../common/src/bench.c"
+
+/*  thread count benchmark
+ *      a crowded world is stepped with random input on 1, 2, 4 and 8 threads, from
+ *      the same seed and for the same number of steps; it fails unless every thread
+ *      count ends in the same state, bit for bit, as one thread. the timed kernel is
+ *      THREADS_STEPS whole steps
+ *
+ *      bench_threads [results.json [baseline.json]], see bench_finish
+ */
+
+#define THREADS_MAX 8
+#define THREADS_ASTEROIDS 1500
+#define THREADS_SEED 7
+#define THREADS_STEPS 50
+#define THREADS_REPS 5
+#define THREADS_DT (1.0f / 60)
+
+
+struct ThreadsBench
+{
+    struct State *state;
+    struct InputProvider input;
+};
+
+
+void threads_kernel(void *ctx)
+{
+    struct ThreadsBench *bench = ctx;
+    for (size_t step = 0; step < THREADS_STEPS; step++) {
+        state_update(bench->state, input_poll(&bench->input), THREADS_DT);
+    }
+}
+
+
+int main(int argc, char **argv)
+{
+    static const char *const names[] = {
+        "  step 1 thread", "  step 2 threads", "  step 4 threads", "  step 8 threads"
+    };
+    size_t n = sizeof(names) / sizeof(names[0]);
+
+    struct BenchResult results[sizeof(names) / sizeof(names[0])];
+    unsigned long long hashes[sizeof(names) / sizeof(names[0])];
+
+    printf(
+        "threads, %d asteroids, seed %d, %d steps per run\n", THREADS_ASTEROIDS,
+        THREADS_SEED, THREADS_STEPS
+    );
+    for (size_t k = 0, threads = 1; threads <= THREADS_MAX; k++, threads *= 2) {
+        struct ThreadsBench bench = {
+            .state = state_create(THREADS_ASTEROIDS, threads),
+            .input = input_random(THREADS_SEED)
+        };
+        if (!bench.state) {
+            fprintf(stderr, "threads: allocation failed\n");
+            return 1;
+        }
+        state_initialise(bench.state, THREADS_ASTEROIDS, THREADS_SEED);
+
+        /* bench_run makes the same number of calls whatever the thread count */
+        results[k] = bench_run(
+            names[k], threads_kernel, &bench, THREADS_STEPS, THREADS_REPS
+        );
+        hashes[k] = asteroidqueue_hash(bench.state->asteroids);
+        printf(
+            "  %zu workers, %zu asteroids left, hash %016llx\n",
+            bench.state->jobs->num_workers, bench.state->asteroids->pool->len,
+            hashes[k]
+        );
+        state_destroy(bench.state);
+    }
+    for (size_t k = 0; k < n; k++) bench_report(results[k]);
+
+    for (size_t k = 1; k < n; k++) {
+        if (hashes[k] == hashes[0]) continue;
+        fprintf(
+            stderr, "threads: %s ended at %016llx, one thread at %016llx\n",
+            names[k] + 2, hashes[k], hashes[0]
+        );
+        return 1;
+    }
+    return !bench_finish(argc, argv, results, n);
+}
@@ -1,55 +1,107 @@
 #include <float.h>
 #include <raylib.h>
 #include <raymath.h>
-
-enum ASTEROID_LEVEL
-{
-    LEVEL0 = 0,
-    LEVEL1,
-    LEVEL2,
-    NUM_ASTEROID_LEVELS
-};
-
-
-static const size_t ASTEROIDLEVEL_NUM_CORNERS[NUM_ASTEROID_LEVELS] = { 3, 4, 6 };
-static const Color  ASTEROIDLEVEL_COLOUR[NUM_ASTEROID_LEVELS] = {
-    { 255, 255, 255, 255 },
-    { 255, 255, 255, 255 },
-    { 255, 255, 255, 255 }
-};
-static const float ASTEROIDLEVEL_RADIUS[NUM_ASTEROID_LEVELS] = { 12.0f, 18.0f, 24.0f };
-static const float ASTEROIDLEVEL_MASS[NUM_ASTEROID_LEVELS] = { 144.0f, 324.0f, 576.0f };
-static const float ASTEROIDLEVEL_MOI[NUM_ASTEROID_LEVELS] = {
-    12.0f * 12.0f * 144.0f / (3 + 1),
-    18.0f * 18.0f * 324.0f / (4 + 1),
-    24.0f * 24.0f * 324.0f / (6 + 1)
-};
-
+#include <string.h>
 
 struct Asteroid
 {
-    Vector2 corners[ASTEROID_VERTICES_MAX];
+    size_t prototype;
     Vector2 centre;
     Vector2 velocity;
     float radius;
-    float mass;
-    float inv_mass;
-    float moi;
-    float inv_moi;
     float rotation;
     float spin;
     float hitpoints;
-    enum ASTEROID_LEVEL level;
     bool collision;
     Color colour;
 };
 
 
+/*  structure-of-arrays storage
+ *      the kinematic fields read by every integration and broadphase pass are the
+ *      bodies of a miniphys world (see common/src/physics.h), which keeps them in
+ *      contiguous arrays and steps them; the outline and mass properties are shared
+ *      through the shape library (prototype[] holds the index) and the per-asteroid
+ *      state touched by the narrowphase and drawing lives apart in material[]
+ *
+ *      body i is asteroid i: the world's bodies are created, destroyed and compacted
+ *      in step with the pool, so their dense indices always agree
+ *
+ *      the body radius duplicates the prototype's, so the hot passes need not chase
+ *      the index
+ *
+ *      struct Asteroid remains the record an asteroid is built in before insertion
+ */
+struct AsteroidMaterial
+{
+    float hitpoints;
+    bool collision;
+    Color colour;
+};
+
+
+/*  narrowphase with a separating axis cache
+ *      pairs which stayed apart are usually still separated by the axis that separated
+ *      them last step, so that axis is remembered per pair (on the lower-indexed
+ *      asteroid, keyed by the partner's id) and tried alone before running full SAT
+ *
+ *      axes are stored as body edges, so they remain meaningful as both asteroids turn
+ *
+ *      concave asteroids are tested piece by piece (see the shape library): a pair of
+ *      pieces is skipped while their circles are apart, and otherwise is tested as
+ *      two convex polygons, so each touching pair of pieces is a contact of its own.
+ *      their features carry the pieces from ASTEROID_FEATURE_PIECES up, keeping them
+ *      apart for the solver's warm start. the cache keeps only outline edges, tested
+ *      against the whole outlines, as a piece's edge need not separate them
+ */
+#define SATCACHE_WAYS 4
+#define SATCACHE_PARTNER_EDGE 0x80
+#define ASTEROID_CONTACTS_MAX (ASTEROID_PIECES_MAX * ASTEROID_PIECES_MAX)
+#define ASTEROID_FEATURE_PIECES 25
+#define ASTEROID_RESTITUTION 1
+#define ASTEROID_REST_SPEED 2
+#define ASTEROID_SLOP 0.5f
+
+
+struct AsteroidSatCache
+{
+    unsigned int partner[SATCACHE_WAYS];
+    unsigned char axis[SATCACHE_WAYS];
+    unsigned char next;
+};
+
+
+/* world-space corners and piece centres, transformed once per step and read by
+ * everything after it
+ */
+struct AsteroidVertices
+{
+    Vector2 v[ASTEROID_VERTICES_MAX];
+    Vector2 centres[ASTEROID_PIECES_MAX];
+};
+
+
+struct SatCacheStats
+{
+    size_t tests;
+    size_t hits;
+};
+
+
 struct AsteroidQueue
 {
-    struct Asteroid *asteroids;
-    size_t len;
-    size_t max;
+    struct PhysicsWorld *bodies;
+
+    unsigned int *prototype;
+    struct AsteroidMaterial *material;
+
+    struct AsteroidVertices *world;
+
+    struct AsteroidSatCache *satcache;
+    struct SatCacheStats satcache_stats;
+
+    struct Pool *pool;
+    const struct ShapeLibrary *shapes;
 };
 
 
@@ -57,279 +109,489 @@ void asteroid_clear(struct Asteroid *ast)
 {
     if (!ast) return;
 
-    for (size_t i = 0; i < ASTEROID_VERTICES_MAX; i++) {
-        ast->corners[i] = (Vector2) { 0, 0 };
-    }
+    ast->prototype = 0;
     ast->centre= (Vector2) { 0, 0 };
     ast->velocity = (Vector2) { 0, 0 };
     ast->radius = 0;
-    ast->mass = 0;
-    ast->inv_mass = 0;
-    ast->moi = 0;
-    ast->inv_moi = 0;
     ast->rotation = 0;
     ast->spin = 0;
     ast->hitpoints = 0;
-    ast->level = LEVEL0;
 
     ast->collision = false;
     ast->colour = WHITE;
 }
 
 
-size_t asteroid_num_corners(struct Asteroid *ast)
+const struct AsteroidPrototype *asteroid_prototype(struct AsteroidQueue *aq, size_t i)
 {
-    return ASTEROIDLEVEL_NUM_CORNERS[ast->level];
+    return aq->shapes->prototypes + aq->prototype[i];
 }
 
 
-float asteroid_radius(struct Asteroid *ast)
+size_t asteroid_num_corners(struct AsteroidQueue *aq, size_t i)
 {
-    return ast->radius;
+    return asteroid_prototype(aq, i)->num_corners;
 }
 
 
-/* world position of ast's ith corner */
-Vector2 asteroid_vertex(struct Asteroid *ast, size_t i)
+float asteroid_radius(struct AsteroidQueue *aq, size_t i)
 {
-    return Vector2Add(
-        ast->centre,
-        Vector2Rotate(ast->corners[i % asteroid_num_corners(ast)], ast->rotation)
-    );
+    return aq->bodies->radius[i];
 }
 
 
-Color asteroid_colour(struct Asteroid *ast)
+/* world position of asteroid i's kth corner, as of the last asteroid_transform */
+Vector2 asteroid_vertex(struct AsteroidQueue *aq, size_t i, size_t k)
 {
-    return ast->colour;
+    return aq->world[i].v[k % asteroid_num_corners(aq, i)];
 }
 
 
-bool asteroid_alive(struct Asteroid *ast)
+/* rotate and translate the local corners into the world vertex cache, one sin/cos */
+void asteroid_transform(struct AsteroidQueue *aq, size_t i)
 {
-    if (!ast) return false;
-    return (0 < ast->hitpoints);
+    struct PhysicsWorld *w = aq->bodies;
+    float c = cosf(w->rotation[i]), s = sinf(w->rotation[i]);
+    Vector2 centre = w->position[i];
+    const struct AsteroidPrototype *proto = asteroid_prototype(aq, i);
+    const Vector2 *corners = proto->corners;
+
+    for (size_t k = 0; k < proto->num_corners; k++) {
+        aq->world[i].v[k] = (Vector2) {
+            centre.x + c*corners[k].x - s*corners[k].y,
+            centre.y + s*corners[k].x + c*corners[k].y
+        };
+    }
+
+    /* every asteroid's, convex ones included: a concave partner culls against them */
+    for (size_t p = 0; p < proto->num_pieces; p++) {
+        Vector2 local = proto->pieces[p].centre;
+        aq->world[i].centres[p] = (Vector2) {
+            centre.x + c*local.x - s*local.y, centre.y + s*local.x + c*local.y
+        };
+    }
 }
 
 
-void asteroid_initialise(struct Asteroid *ast, Vector2 *vertices, size_t n)
+Color asteroid_colour(struct AsteroidQueue *aq, size_t i)
 {
-    if (!ast || !vertices || !n) return;
-
-    /* centroid and effective positions of corners */
-    Vector2 centre = polygon_area_moment_1(vertices, n);
-    for (size_t i = 0; i < n; i++) {
-        ast->corners[i] = vector2_diff(vertices[i], centre);
-        if (Vector2Length(ast->corners[i]) > ast->radius) {
-            ast->radius = Vector2Length(ast->corners[i]);
-        }
-    }
+    return aq->material[i].colour;
+}
 
-    /* area and mass */
-    float area = polygon_area_moment_0(ast->corners, n);
-    ast->mass = area * ASTEROID_DENSITY;
-    ast->inv_mass = 1 / ast->mass;
 
-    /* moment of inertia */
-    ast->moi = polygon_area_moment_2(ast->corners, n) * ASTEROID_DENSITY;
-    ast->inv_moi = 1 / ast->moi;
+bool asteroid_alive(struct AsteroidQueue *aq, size_t i)
+{
+    return aq && pool_alive(aq->pool, i);
 }
 
 
-void asteroid_randomise(struct Asteroid *ast)
+/* a random prototype and placement, drawn from rng */
+void asteroid_randomise
+(
+    struct Asteroid *ast, const struct ShapeLibrary *shapes, unsigned int *rng
+)
 {
-    if (!ast) return;
+    if (!ast || !shapes || !rng) return;
 
     asteroid_clear(ast);
-    ast->level = random() % NUM_ASTEROID_LEVELS;
-
-    size_t num_corners = ASTEROIDLEVEL_NUM_CORNERS[ast->level];
-    Vector2 corners[num_corners];
-
-    float radius = ASTEROIDLEVEL_RADIUS[ast->level];
-    float angle_step = (2 * PI) / num_corners;
-    float angle_delta = 0;
-    for (size_t i = 0; i < num_corners; i++) {
-        angle_delta = (random()%(2*num_corners)) * angle_step / (2.0f*num_corners);
-        corners[i] = (Vector2) {
-            radius * cos(i*angle_step + angle_delta),
-            radius * sin(i*angle_step + angle_delta)
-        };
+    enum ASTEROID_LEVEL level = rng_next(rng) % NUM_ASTEROID_LEVELS;
+    ast->prototype = shapelibrary_index(shapes, level, rng_next(rng));
+    ast->radius = shapes->prototypes[ast->prototype].radius;
+
+    /* one draw per statement, so the sequence does not depend on evaluation order */
+    float x = rng_next(rng) % WORLD_WIDTH;
+    float y = rng_next(rng) % WORLD_HEIGHT;
+    ast->centre = (Vector2) { x, y };
+
+    int vx = (int) (rng_next(rng) % 12);
+    vx -= (int) (rng_next(rng) % 6);
+    int vy = (int) (rng_next(rng) % 12);
+    vy -= (int) (rng_next(rng) % 6);
+    ast->velocity = (Vector2) { 3*vx, 3*vy };
+
+    ast->rotation = (rng_next(rng) % 360) * (2 * PI) / 360;
+    //ast->spin = 1.0f * (rng_next(rng) % 360) * (2 * PI) / ((level + 1) * 360);
+    ast->hitpoints = 100 * (level + 1) * (level + 1);
+}
+
+
+void satcache_clear(struct AsteroidSatCache *cache)
+{
+    *cache = (struct AsteroidSatCache) { 0 };
+}
+
+
+/* way holding partner's axis, or SATCACHE_WAYS if none */
+size_t satcache_find(struct AsteroidSatCache *cache, unsigned int partner)
+{
+    for (size_t w = 0; w < SATCACHE_WAYS; w++) {
+        if (cache->partner[w] == partner + 1) return w;
     }
-    asteroid_initialise(ast, corners, num_corners);
+    return SATCACHE_WAYS;
+}
 
-    ast->centre= (Vector2) { random() % WINDOW_WIDTH, random() % WINDOW_HEIGHT };
-    ast->velocity = (Vector2) {
-        3*((random()%12) - (random()%6)),
-        3*((random()%12) - (random()%6))
-    };
-    ast->rotation = (random() % 360) * (2 * PI) / 360;
-    //ast->spin = 1.0f * (random() % 360) * (2 * PI) / ((ast->level + 1) * 360);
-    ast->hitpoints = 100 * (ast->level + 1) * (ast->level + 1);
+
+void satcache_store
+(
+    struct AsteroidSatCache *cache, unsigned int partner, unsigned char axis
+)
+{
+    size_t w = satcache_find(cache, partner);
+    if (w == SATCACHE_WAYS) {
+        w = cache->next;
+        cache->next = (cache->next + 1) % SATCACHE_WAYS;
+    }
+    cache->partner[w] = partner + 1, cache->axis[w] = axis;
 }
 
 
-/* calculate
- *      the collision axis (one of the normals to an edge) in local coordinates
- *          given directed from ast2 to ast1
- *      the collision point in global coordinates
+/* the corners of piece p of asteroid i, displaced by offset, returns how many */
+size_t asteroid_piece_vertices
+(
+    struct AsteroidQueue *aq, size_t i, size_t p, Vector2 offset, Vector2 *vertices
+)
+{
+    const struct AsteroidPiece *piece = asteroid_prototype(aq, i)->pieces + p;
+    for (size_t k = 0; k < piece->num_corners; k++) {
+        vertices[k] = Vector2Add(aq->world[i].v[piece->corners[k]], offset);
+    }
+    return piece->num_corners;
+}
+
+
+/*  contacts between asteroids i and j, the latter displaced by offset (its nearest
+ *  image across the world edges), up to ASTEROID_CONTACTS_MAX; normals point from i
+ *  to j. returns how many, none if the pair is separated or only grazes
+ *
+ *  only i's sat cache is touched, so pairs with different i can be tested in parallel
  */
-void asteroid_collision_data
+size_t asteroid_contact
 (
-    struct Asteroid *ast1, struct Asteroid *ast2,
-    struct Vector2 *axis, struct Vector2 *point
+    struct AsteroidQueue *aq, size_t i, size_t j, Vector2 offset,
+    struct PolygonContact *contacts, struct SatCacheStats *stats
 )
 {
-    Vector2 v0, v1, pt;
-    Vector2 dr = Vector2Subtract(ast2->centre, ast1->centre);
-    *axis = Vector2Zero(), *point = Vector2Zero();
-
-    v1 = asteroid_vertex(ast1, 0);
-    for (size_t i = 0; i < asteroid_num_corners(ast1); i++) {
-        v0 = v1;
-        v1 = asteroid_vertex(ast1, i + 1);
-        for (size_t j = 0; j < asteroid_num_corners(ast2); j++) {
-            pt = asteroid_vertex(ast2, j);
-            if (!point_on_segment(pt, v0, v1)) continue;
-
-            *axis = Vector2Normalize(vector2_perp(Vector2Subtract(v0, v1)));
-            if (vector2_dot(*axis, dr)) *axis = Vector2Scale(*axis, -1);
-            *point = pt;
-            return;
+    const struct AsteroidPrototype *proto1 = asteroid_prototype(aq, i);
+    const struct AsteroidPrototype *proto2 = asteroid_prototype(aq, j);
+    size_t n1 = proto1->num_corners, n2 = proto2->num_corners;
+    Vector2 *vertices1 = aq->world[i].v, vertices2[ASTEROID_VERTICES_MAX];
+    for (size_t k = 0; k < n2; k++) {
+        vertices2[k] = Vector2Add(aq->world[j].v[k], offset);
+    }
+    bool convex = (proto1->num_pieces == 1) && (proto2->num_pieces == 1);
+
+    struct AsteroidSatCache *cache = aq->satcache + i;
+    size_t way = satcache_find(cache, aq->pool->slot[j]);
+
+    stats->tests++;
+    if (way < SATCACHE_WAYS) {
+        unsigned char axis = cache->axis[way];
+        size_t edge = axis & ~SATCACHE_PARTNER_EDGE;
+        bool on_2 = (axis & SATCACHE_PARTNER_EDGE);
+
+        /* an axis left by a partner since replaced may not be an edge at all */
+        float sep = -1;
+        bool valid = (edge < ((on_2) ? n2 : n1));
+        if (valid && convex) {
+            sep = (on_2)
+                ? polygon_edge_separation(vertices2, n2, edge, vertices1, n1)
+                : polygon_edge_separation(vertices1, n1, edge, vertices2, n2);
+        } else if (valid) {
+            sep = (on_2)
+                ? polygon_axis_separation(vertices2, n2, edge, vertices1, n1)
+                : polygon_axis_separation(vertices1, n1, edge, vertices2, n2);
+        }
+
+        if (sep > 0) {
+            stats->hits++;
+            return 0;
+        }
+    }
+
+    if (convex) {
+        if (polygon_contact(vertices1, n1, vertices2, n2, contacts)) {
+            return (contacts->num_points) ? 1 : 0;
         }
+        satcache_store(
+            cache, aq->pool->slot[j],
+            contacts->axis_edge | ((contacts->axis_on_2) ? SATCACHE_PARTNER_EDGE : 0)
+        );
+        return 0;
     }
 
-    v1 = asteroid_vertex(ast2, 0);
-    for (size_t j = 0; j < asteroid_num_corners(ast2); j++) {
-        v0 = v1;
-        v1 = asteroid_vertex(ast2, j + 1);
-        for (size_t i = 0; i < asteroid_num_corners(ast1); i++) {
-            pt = asteroid_vertex(ast1, i);
-            if (!point_on_segment(pt, v0, v1)) continue;
-
-            *axis = Vector2Normalize(vector2_perp(Vector2Subtract(v0, v1)));
-            if (vector2_dot(*axis, dr)) *axis = Vector2Scale(*axis, -1);
-            *point = pt;
-            return;
+    /* piece by piece, remembering the first outline edge found to separate them */
+    size_t num = 0;
+    bool touching = false, separated = false;
+    unsigned char axis = 0;
+    for (size_t p = 0; p < proto1->num_pieces; p++) {
+        const struct AsteroidPiece *piece1 = proto1->pieces + p;
+        Vector2 centre1 = aq->world[i].centres[p];
+        Vector2 piece_vertices1[ASTEROID_VERTICES_MAX];
+        size_t m1 = asteroid_piece_vertices(
+            aq, i, p, (Vector2) { 0, 0 }, piece_vertices1
+        );
+
+        for (size_t q = 0; q < proto2->num_pieces; q++) {
+            const struct AsteroidPiece *piece2 = proto2->pieces + q;
+            Vector2 d = Vector2Subtract(
+                Vector2Add(aq->world[j].centres[q], offset), centre1
+            );
+            float reach = piece1->radius + piece2->radius;
+            if (Vector2LengthSqr(d) > reach * reach) continue;
+
+            Vector2 piece_vertices2[ASTEROID_VERTICES_MAX];
+            size_t m2 = asteroid_piece_vertices(aq, j, q, offset, piece_vertices2);
+            struct PolygonContact *contact = contacts + num;
+
+            if (polygon_contact(piece_vertices1, m1, piece_vertices2, m2, contact)) {
+                touching = true;
+                if (!contact->num_points) continue;
+
+                unsigned int pieces = p * ASTEROID_PIECES_MAX + q;
+                for (size_t k = 0; k < contact->num_points; k++) {
+                    contact->features[k] |= pieces << ASTEROID_FEATURE_PIECES;
+                }
+                num++;
+                continue;
+            }
+            if (separated) continue;
+
+            bool on_2 = contact->axis_on_2;
+            const struct AsteroidPrototype *proto = (on_2) ? proto2 : proto1;
+            size_t edge = asteroidprototype_piece_edge(
+                proto, (on_2) ? q : p, contact->axis_edge
+            );
+            if (edge == proto->num_corners) continue;
+
+            float sep = (on_2)
+                ? polygon_axis_separation(vertices2, n2, edge, vertices1, n1)
+                : polygon_axis_separation(vertices1, n1, edge, vertices2, n2);
+            if (sep > 0) {
+                separated = true;
+                axis = edge | ((on_2) ? SATCACHE_PARTNER_EDGE : 0);
+            }
         }
     }
+
+    if (!touching && separated) satcache_store(cache, aq->pool->slot[j], axis);
+    return num;
 }
 
 
-void asteroid_collide(struct Asteroid *ast1, struct Asteroid *ast2)
+/*  narrowphase for asteroids i and j over the last step of length dt, the latter
+ *  displaced by offset; reads only positions, so it can run ahead of (and in
+ *  parallel with) resolution
+ *
+ *  pairs are swept while their bounding circles overlap: the polygons are tested at
+ *  sub-steps from when the circles first touch (or the start of the step, if they
+ *  already do) until they part, each short enough that neither can pass through the
+ *  other, and the first contact found is returned with toi its fraction of the
+ *  step; offset is then moved so j sits relative to i as it did at that time. at
+ *  ordinary speeds the single sub-step is the end of the step
+ *
+ *  returns how many contacts the pair has, none if it does not touch
+ */
+size_t asteroid_detect
+(
+    struct AsteroidQueue *aq, size_t i, size_t j, Vector2 *offset, float dt,
+    float *toi, struct PolygonContact *contacts, struct SatCacheStats *stats
+)
 {
-    /* early exit if too far apart */
-    float dr = Vector2Length(Vector2Subtract(ast1->centre, ast2->centre));
-    if (dr > (asteroid_radius(ast1) + asteroid_radius(ast2))*(1 + EPSILON)) return;
+    struct PhysicsWorld *w = aq->bodies;
+    float r_i = asteroid_radius(aq, i), r_j = asteroid_radius(aq, j);
+    float reach = (r_i + r_j)*(1 + EPSILON);
 
-    /* calculate collision axis and point */
-    Vector2 n, P;
-    asteroid_collision_data(ast1, ast2, &n, &P);
+    /* separation at the end and the start of the step, and j's motion relative to i */
+    Vector2 d1 = Vector2Subtract(Vector2Add(w->position[j], *offset), w->position[i]);
+    Vector2 dv = Vector2Scale(Vector2Subtract(w->velocity[j], w->velocity[i]), dt);
+    Vector2 d0 = Vector2Subtract(d1, dv);
 
-    /* early exit if no collision axis */
-    if (Vector2Equals(n, Vector2Zero())) return;
+    /* early exit if too far apart to have met at any time in the step */
+    float travel = Vector2Length(dv);
+    if (Vector2Length(d1) > reach + travel) return 0;
 
-    /* distances from centres to collision point */
-    Vector2 r1_P = Vector2Subtract(P, ast1->centre);
-    Vector2 r2_P = Vector2Subtract(P, ast2->centre);
-
-    /* tangential vector at collision point */
-    Vector2 t1_P = vector2_perp(r1_P);
-    Vector2 t2_P = vector2_perp(r2_P);
+    /* when, if ever, the circles overlap during the step; a pair overlapping at the
+     * start is swept from there until they part
+     */
+    float t_begin = 0, t_end = 1;
+    float a = vector2_dot(dv, dv), b = vector2_dot(d0, dv);
+    float c = vector2_dot(d0, d0) - reach * reach;
+    float disc = b*b - a*c;
+    if (c > 0) {
+        if ((a <= 0) || (b >= 0) || (disc < 0)) return 0;
+
+        t_begin = (-b - sqrtf(disc)) / a;
+        if (t_begin > 1) return 0;
+    }
+    if (a > 0) t_end = fminf((-b + sqrtf(fmaxf(disc, 0))) / a, 1);
 
-    /* rotational velocity */
-    Vector2 w1_P = Vector2Scale(t1_P, ast1->spin);
-    Vector2 w2_P = Vector2Scale(t2_P, ast2->spin);
+    /* sub-steps move j no more than a quarter of the smaller radius against i; j
+     * moves at most 2 reach while the circles overlap, so there are no more than
+     * 1 + 8 (r_i + r_j) / min(r_i, r_j) of them, 25 between the largest and smallest
+     * levels, however fast the pair
+     */
+    float step = 0.25f * fminf(r_i, r_j);
+    size_t steps = 1 + (size_t) (travel * (t_end - t_begin) / step);
 
-    /* net velocities at collision point */
-    Vector2 v1_P = Vector2Add(w1_P, ast1->velocity);
-    Vector2 v2_P = Vector2Add(w2_P, ast2->velocity);
+    /* a pair still approaching at the end is tested there last, one which only
+     * passed close is tested at the middle of each sub-step
+     */
+    float shift = (t_end < 1) ? 0.5f : 0;
+    Vector2 end = *offset;
+    for (size_t k = 1; k <= steps; k++) {
+        float t = t_begin + (t_end - t_begin) * (k - shift) / steps;
+        if ((k == steps) && !shift) t = t_end;
+        Vector2 at = Vector2Subtract(end, Vector2Scale(dv, 1 - t));
+
+        /* early exit if separated, or only grazing */
+        size_t num = asteroid_contact(aq, i, j, at, contacts, stats);
+        if (!num) continue;
+
+        *offset = at, *toi = t;
+        return num;
+    }
+    return 0;
+}
 
-    /* relative velocity at collision points */
-    Vector2 v_12 = Vector2Subtract(v2_P, v1_P);
 
-    /* early exit if velocity on collision axis is negative */
-    if (vector2_dot(n, v_12) <= 0) return;
+/* after an impulse partway through the step, with dt_left of it to go: carry i on
+ * from where it was then with its new velocity, rather than its old one
+ */
+void asteroid_redirect
+(
+    struct AsteroidQueue *aq, size_t i, Vector2 velocity_old, float dt_left
+)
+{
+    struct PhysicsWorld *w = aq->bodies;
+    Vector2 dv = Vector2Subtract(w->velocity[i], velocity_old);
+    w->position[i] = Vector2Add(w->position[i], Vector2Scale(dv, dt_left));
+    asteroid_transform(aq, i);
+}
 
-    ast1->collision = true, ast2->collision = true;
-    ast1->colour = GREEN, ast2->colour = RED;
 
-    /* j is the magic scalar */
-    float j_numer = -2 * vector2_dot(n, v_12);
-    float j_denom = (
-        vector2_dot(n, n) * (ast1->inv_mass + ast2->inv_mass) +
-        (ast1->inv_moi) * vector2_dot(t1_P, n) * vector2_dot(t1_P, n) +
-        (ast2->inv_moi) * vector2_dot(t2_P, n) * vector2_dot(t2_P, n)
-    );
-    float j = (iszero(j_denom)) ? 0 : j_numer / j_denom;
-
-    ast1->velocity = Vector2Add(ast1->velocity, Vector2Scale(n, j * ast1->inv_mass));
-    ast2->velocity = Vector2Add(ast2->velocity, Vector2Scale(n, -j * ast2->inv_mass));
-
-    /*
-     *
-     *  firstly if the relative normal velocity is positive, they are separating and do
-     *  not collide.
-     *
-     *  secondly the correct equations for the linear and angular velocities v, w are
-     *  given in terms of the impulse j, calculated from inverse mass and m.o.i
-     *
-     *  v_f,A = v_i,A + (j / M_A)n
-     *  v_f,B = v_i,B - (j / M_B)n
-     *
-     *  w_f,A = w_i,A + (r*_AP) . (jn) / I
-     *  w_f,B = w_i,A - (r*_BP) . (jn) / I
-     *
-     *  j = -(1+e) v_i,AB.n / (n.n( 1/M_A + 1/M_B) + (r*_AP.n)^2/I_A + (r*_BP.n)/I_B)
-     *
-     */
+/* a detected contact between asteroids i and j, the latter displaced by offset, as
+ * the physics world's solver takes it
+ */
+struct PhysicsManifold asteroid_manifold
+(
+    size_t i, size_t j, Vector2 offset, const struct PolygonContact *contact
+)
+{
+    struct PhysicsManifold m = {
+        .a = i, .b = j, .offset = offset, .normal = contact->normal,
+        .num_points = contact->num_points
+    };
+    for (size_t k = 0; k < contact->num_points; k++) {
+        m.points[k] = contact->points[k];
+        m.depths[k] = contact->depths[k];
+        m.features[k] = contact->features[k];
+    }
+    return m;
 }
 
 
-void asteroid_draw(struct Asteroid *ast)
+/* mark a pair the solver pushed apart */
+void asteroid_touch(struct AsteroidQueue *aq, size_t i, size_t j)
 {
-    if (!ast || !asteroid_alive(ast)) return;
+    struct AsteroidMaterial *mat1 = aq->material + i, *mat2 = aq->material + j;
+    mat1->collision = true, mat2->collision = true;
+    mat1->colour = GREEN, mat2->colour = RED;
+}
+
 
-    size_t num_corners = ASTEROIDLEVEL_NUM_CORNERS[ast->level];
-    Vector2 vertex0 = ast->centre;
-    Vector2 vertex1 = { 0, 0 }, vertex2 = Vector2Add(vertex0, ast->corners[0]);
+/* whether the segment p0 p1 touches asteroid i, displaced by offset; if so t is the
+ * fraction along the segment of the first point inside
+ */
+bool asteroid_segment
+(
+    struct AsteroidQueue *aq, size_t i, Vector2 offset, Vector2 p0, Vector2 p1,
+    float *t
+)
+{
+    /* early exit if the segment passes outside the bounding circle */
+    Vector2 c = Vector2Add(aq->bodies->position[i], offset);
+    Vector2 d = Vector2Subtract(p1, p0);
+    float len2 = Vector2LengthSqr(d);
+    float s = (len2 > 0) ? vector2_dot(Vector2Subtract(c, p0), d) / len2 : 0;
+    s = (s < 0) ? 0 : ((s > 1) ? 1 : s);
+
+    float r = asteroid_radius(aq, i);
+    Vector2 closest = Vector2Add(p0, Vector2Scale(d, s));
+    if (Vector2LengthSqr(Vector2Subtract(closest, c)) > r * r) return false;
+
+    size_t n = asteroid_num_corners(aq, i);
+    Vector2 v[ASTEROID_VERTICES_MAX];
+    for (size_t k = 0; k < n; k++) v[k] = Vector2Add(aq->world[i].v[k], offset);
+
+    /* starting inside, as a fan over each convex piece */
+    const struct AsteroidPrototype *proto = asteroid_prototype(aq, i);
+    for (size_t p = 0; p < proto->num_pieces; p++) {
+        const struct AsteroidPiece *piece = proto->pieces + p;
+        const unsigned char *c = piece->corners;
+        for (size_t k = 1; k + 1 < piece->num_corners; k++) {
+            if (point_on_triangle(p0, v[c[0]], v[c[k]], v[c[k + 1]])) {
+                *t = 0;
+                return true;
+            }
+        }
+    }
 
-    DrawCircle(vertex0.x, vertex0.y, 1, RED);
+    /* otherwise entering through the nearest crossed edge */
+    bool hit = false;
+    for (size_t k = 0; k < n; k++) {
+        Vector2 q0 = v[k], q1 = v[(k + 1) % n];
+        if (!segment_on_segment(p0, p1, q0, q1)) continue;
 
-    for (size_t i = 0; i < num_corners; i++) {
-        vertex1 = vertex2;
-        vertex2 = Vector2Add(vertex0, ast->corners[(i + 1) % num_corners]);
-        DrawLineV(vertex1, vertex2, asteroid_colour(ast));
+        float a = segment_intersection(p0, p1, q0, q1);
+        if (!hit || (a < *t)) *t = a;
+        hit = true;
     }
 
-    DrawLineV(vertex0, Vector2Add(vertex0, ast->velocity), BLUE);
+    return hit;
 }
 
 
-void asteroid_update(struct Asteroid *ast, float dt)
+/* draw alpha of the way from the previous step to the current one
+ * only the translation is interpolated, the cached vertices keep the current rotation
+ * drawn displaced by offset, to the image of the asteroid in view
+ */
+void asteroid_draw
+(
+    struct AsteroidQueue *aq, size_t i, Vector2 offset, float alpha,
+    struct RenderBatch *batch
+)
 {
-    ast->colour = WHITE;
-    ast->collision = false;
+    if (!asteroid_alive(aq, i)) return;
+    struct PhysicsWorld *w = aq->bodies;
 
-    size_t num_corners = ASTEROIDLEVEL_NUM_CORNERS[ast->level];
-    float delta_angle = ast->spin * dt;
-    float buffer = asteroid_radius(ast);
+    size_t num_corners = asteroid_num_corners(aq, i);
+    Vector2 vertex0 = Vector2Add(
+        vector2_interpolate(w->prev_position[i], w->position[i], alpha), offset
+    );
+    Vector2 shift = Vector2Subtract(vertex0, w->position[i]);
 
-    for (size_t i = 0; i < num_corners; i++) {
-        ast->corners[i] = Vector2Rotate(ast->corners[i], delta_angle);
+    Vector2 outline[ASTEROID_VERTICES_MAX];
+    for (size_t k = 0; k < num_corners; k++) {
+        outline[k] = Vector2Add(asteroid_vertex(aq, i, k), shift);
     }
+    renderbatch_outline(batch, outline, num_corners, asteroid_colour(aq, i));
 
-    ast->rotation += delta_angle;
-    ast->centre= vector2_wrap(
-        Vector2Add(ast->centre, Vector2Scale(ast->velocity, dt)),
-        (const Vector2) {
-            -1.0f * buffer,
-            -1.0f * buffer
-        },
-        (const Vector2) {
-            WINDOW_WIDTH + buffer,
-            WINDOW_HEIGHT + buffer
-        }
+    if (!batch->debug) return;
+    renderbatch_point(batch, vertex0, RENDERBATCH_POINT_SIZE, RED);
+    renderbatch_line(batch, vertex0, Vector2Add(vertex0, w->velocity[i]), BLUE);
+}
+
+
+void asteroid_update(struct AsteroidQueue *aq, size_t i, float dt)
+{
+    aq->material[i].colour = WHITE;
+    aq->material[i].collision = false;
+
+    /* corners stay in the body frame, rotation is applied by asteroid_transform */
+    struct PhysicsWorld *w = aq->bodies;
+    physics_integrate_wrap_scalar(
+        w->position, w->prev_position, w->velocity, w->radius, w->rotation, w->spin,
+        i, i + 1, dt, w->size
     );
 }
 
@@ -337,26 +599,64 @@ void asteroid_update(struct Asteroid *ast, float dt)
 void asteroidqueue_destroy(struct AsteroidQueue *aq)
 {
     if (!aq) return;
-    if (aq->asteroids) free(aq->asteroids);
+    if (aq->bodies) physics_world_destroy(aq->bodies);
+    if (aq->prototype) free(aq->prototype);
+    if (aq->material) free(aq->material);
+    if (aq->world) free(aq->world);
+    if (aq->satcache) free(aq->satcache);
+    if (aq->pool) pool_destroy(aq->pool);
     free(aq);
 }
 
 
-struct AsteroidQueue *asteroidqueue_create(size_t max)
+/* resize the queue's own arrays to max entries, ahead of the pool */
+bool asteroidqueue_resize(struct AsteroidQueue *aq, size_t max)
+{
+    return (
+        physics_world_reserve(aq->bodies, max) &&
+        pool_realloc((void **) &aq->prototype, max * sizeof(unsigned int)) &&
+        pool_realloc((void **) &aq->material, max * sizeof(struct AsteroidMaterial)) &&
+        pool_realloc((void **) &aq->world, max * sizeof(struct AsteroidVertices)) &&
+        pool_realloc((void **) &aq->satcache, max * sizeof(struct AsteroidSatCache))
+    );
+}
+
+
+/* room for n more asteroids, growing every array with the pool */
+bool asteroidqueue_reserve(struct AsteroidQueue *aq, size_t n)
+{
+    if (aq->pool->len + n <= aq->pool->max) return true;
+
+    size_t max = pool_capacity(aq->pool, n);
+    return asteroidqueue_resize(aq, max) && pool_grow(aq->pool, max);
+}
+
+
+/* a queue with room for max asteroids to begin with, it grows as needed; shapes
+ * must outlive it
+ */
+struct AsteroidQueue *asteroidqueue_create
+(
+    size_t max, const struct ShapeLibrary *shapes
+)
 {
     struct AsteroidQueue *aq = malloc(sizeof(struct AsteroidQueue));
     if (!aq) return NULL;
 
-    aq->asteroids = malloc(max * sizeof(struct Asteroid));
-    if (!aq->asteroids) {
+    *aq = (struct AsteroidQueue) { .shapes = shapes };
+    aq->pool = pool_create(0);
+    aq->bodies = physics_world_create(
+        max, (const Vector2) { WORLD_WIDTH, WORLD_HEIGHT }
+    );
+    if (!aq->pool || !aq->bodies || !asteroidqueue_reserve(aq, max)) {
         asteroidqueue_destroy(aq);
         return NULL;
     }
 
-    for (size_t i = 0; i < max; i++) asteroid_clear(aq->asteroids + i);
-
-    aq->len = 0;
-    aq->max = max;
+    /* elastic, as asteroids have always bounced, but clusters come to rest */
+    aq->bodies->solver.restitution = ASTEROID_RESTITUTION;
+    aq->bodies->solver.rest_speed = ASTEROID_REST_SPEED;
+    aq->bodies->solver.slop = ASTEROID_SLOP;
 
     return aq;
 }
@@ -365,51 +665,213 @@ struct AsteroidQueue *asteroidqueue_create(size_t max)
 void asteroidqueue_apply
 (
     struct AsteroidQueue *aq,
-    void (*func)(struct Asteroid *)
+    void (*func)(struct AsteroidQueue *, size_t)
 )
 {
     if (!aq || !func) return;
-    for (size_t i = 0; i < aq->len; i++) func(aq->asteroids + i);
+    for (size_t i = 0; i < aq->pool->len; i++) func(aq, i);
 }
 
 
-void asteroidqueue_insert(struct AsteroidQueue *aq, struct Asteroid a)
+/* scatter a built asteroid into the queue's arrays, returns POOL_HANDLE_NONE only if
+ * the queue could not grow
+ */
+struct PoolHandle asteroidqueue_insert(struct AsteroidQueue *aq, struct Asteroid a)
 {
-    if (!aq || (aq->len >= aq->max)) return;
-    aq->asteroids[aq->len++] = a;
+    if (!aq || !asteroidqueue_reserve(aq, 1)) return POOL_HANDLE_NONE;
+
+    size_t i = aq->pool->len;
+    struct PoolHandle handle = pool_insert(aq->pool);
+
+    const struct AsteroidPrototype *proto = aq->shapes->prototypes + a.prototype;
+    physics_body_create(aq->bodies, &(struct PhysicsBody) {
+        .position = a.centre,
+        .velocity = a.velocity,
+        .mass = proto->mass,
+        .rotation = a.rotation,
+        .spin = a.spin,
+        .moi = proto->moi,
+        .radius = a.radius
+    });
+
+    aq->prototype[i] = a.prototype;
+
+    /* field by field over zeroes, so the padding keyframes write is zero too */
+    memset(aq->material + i, 0, sizeof(struct AsteroidMaterial));
+    aq->material[i].hitpoints = a.hitpoints;
+    aq->material[i].collision = a.collision;
+    aq->material[i].colour = a.colour;
+
+    /* partners key the cache by slot: a stale axis after reuse is still a valid
+     * separation test, so it only costs a miss
+     */
+    satcache_clear(aq->satcache + i);
+
+    /* the slots past the prototype's corners and pieces are never transformed, but
+     * keyframes write them, so they are zeroed for replays to be reproducible
+     */
+    aq->world[i] = (struct AsteroidVertices) { 0 };
+    asteroid_transform(aq, i);
+    return handle;
 }
 
 
+/* i is skipped from now on and dropped at the next asteroidqueue_compact */
 void asteroidqueue_remove(struct AsteroidQueue *aq, size_t i)
 {
-    if (!aq || i >= aq->len) return;
-    aq->asteroids[i] = aq->asteroids[--aq->len];
+    if (!aq) return;
+    pool_remove(aq->pool, i);
+    physics_body_destroy(aq->bodies, i);
 }
 
 
-void asteroidqueue_draw(struct AsteroidQueue *aq)
+void asteroidqueue_move(void *ctx, size_t from, size_t to)
 {
-    asteroidqueue_apply(aq, asteroid_draw);
+    struct AsteroidQueue *aq = ctx;
+
+    aq->prototype[to] = aq->prototype[from];
+    aq->material[to] = aq->material[from];
+    aq->world[to] = aq->world[from];
+    aq->satcache[to] = aq->satcache[from];
 }
 
 
-void asteroidqueue_update(struct AsteroidQueue *aq, float dt)
+/* drop removed asteroids, once per step after every pass has run; the bodies close
+ * the same gaps in the same order
+ */
+void asteroidqueue_compact(struct AsteroidQueue *aq)
 {
-    size_t i = 0;
-    struct Asteroid *curr = aq->asteroids + 0;
-    struct Asteroid *next = NULL;
-    while ((i < aq->len) && asteroid_alive(curr)) {
-        asteroid_update(curr, dt);
+    if (!aq) return;
+    pool_compact(aq->pool, asteroidqueue_move, aq);
+    physics_world_compact(aq->bodies);
+}
 
-        if (!asteroid_alive(aq->asteroids + i)) asteroidqueue_remove(aq, i);
-        else curr = aq->asteroids + (++i);
-    }
 
-    for (size_t i = 0; i < aq->len; i++) {
-        curr = aq->asteroids + i;
-        for (size_t j = i+1; j < aq->len; j++) {
-            next = aq->asteroids + j;
-            asteroid_collide(curr, next);
+/* fnv-1a over the asteroids' positions, velocities and rotations, so runs which
+ * should agree can be checked bit for bit
+ */
+unsigned long long asteroidqueue_hash(struct AsteroidQueue *aq)
+{
+    unsigned long long hash = 14695981039346656037ull;
+    struct PhysicsWorld *w = aq->bodies;
+    const void *fields[] = { w->position, w->velocity, w->rotation };
+    size_t sizes[] = { sizeof(Vector2), sizeof(Vector2), sizeof(float) };
+
+    for (size_t f = 0; f < 3; f++) {
+        const unsigned char *bytes = fields[f];
+        for (size_t b = 0; b < aq->pool->len * sizes[f]; b++) {
+            hash = (hash ^ bytes[b]) * 1099511628211ull;
         }
     }
+    return hash;
+}
+
+
+/* the live and dead entries of the queue as of the last step, for a keyframe */
+bool asteroidqueue_write(struct AsteroidQueue *aq, FILE *f)
+{
+    struct PhysicsWorld *w = aq->bodies;
+    size_t len = aq->pool->len;
+    return (
+        pool_write(aq->pool, f) &&
+        serial_write(f, w->position, len * sizeof(Vector2)) &&
+        serial_write(f, w->velocity, len * sizeof(Vector2)) &&
+        serial_write(f, w->radius, len * sizeof(float)) &&
+        serial_write(f, w->rotation, len * sizeof(float)) &&
+        serial_write(f, w->spin, len * sizeof(float)) &&
+        serial_write(f, w->prev_position, len * sizeof(Vector2)) &&
+        serial_write(f, aq->prototype, len * sizeof(unsigned int)) &&
+        serial_write(f, aq->material, len * sizeof(struct AsteroidMaterial)) &&
+        serial_write(f, aq->world, len * sizeof(struct AsteroidVertices)) &&
+        serial_write(f, aq->satcache, len * sizeof(struct AsteroidSatCache)) &&
+        serial_write(f, &w->solver, sizeof(struct PhysicsSolver)) &&
+        serial_write(f, &w->num_cached, sizeof(size_t)) &&
+        serial_write(f, w->cache, w->num_cached * sizeof(struct PhysicsManifold))
+    );
+}
+
+
+/* replace the queue's contents with a keyframe's; the sat cache never changes a
+ * result, but is restored too so its hit rate carries on as in the recorded run.
+ * the bodies take their liveness from the pool and their mass from the prototypes,
+ * and the solver's settings and cached contacts are restored, as the cache warm
+ * starts the next solve. false for a keyframe with an index out of range, as well
+ * as one cut short
+ */
+bool asteroidqueue_read(struct AsteroidQueue *aq, FILE *f)
+{
+    if (!pool_read(aq->pool, f) || !asteroidqueue_resize(aq, aq->pool->max)) {
+        return false;
+    }
+
+    struct PhysicsWorld *w = aq->bodies;
+    size_t len = aq->pool->len;
+    if (!(
+        serial_read(f, w->position, len * sizeof(Vector2)) &&
+        serial_read(f, w->velocity, len * sizeof(Vector2)) &&
+        serial_read(f, w->radius, len * sizeof(float)) &&
+        serial_read(f, w->rotation, len * sizeof(float)) &&
+        serial_read(f, w->spin, len * sizeof(float)) &&
+        serial_read(f, w->prev_position, len * sizeof(Vector2)) &&
+        serial_read(f, aq->prototype, len * sizeof(unsigned int)) &&
+        serial_read(f, aq->material, len * sizeof(struct AsteroidMaterial)) &&
+        serial_read(f, aq->world, len * sizeof(struct AsteroidVertices)) &&
+        serial_read(f, aq->satcache, len * sizeof(struct AsteroidSatCache))
+    )) return false;
+
+    /* prototypes and sat cache ways must be ones this build has */
+    size_t num_prototypes = aq->shapes->per_level * NUM_ASTEROID_LEVELS;
+    for (size_t i = 0; i < len; i++) {
+        if (aq->prototype[i] >= num_prototypes) return false;
+        if (aq->satcache[i].next >= SATCACHE_WAYS) return false;
+    }
+
+    size_t num_cached;
+    if (
+        !serial_read(f, &w->solver, sizeof(struct PhysicsSolver)) ||
+        !serial_read(f, &num_cached, sizeof(size_t))
+    ) return false;
+    struct PhysicsManifold *cache = malloc(
+        (num_cached + 1) * sizeof(struct PhysicsManifold)
+    );
+    bool ok = (
+        cache && serial_read(f, cache, num_cached * sizeof(struct PhysicsManifold))
+    );
+    for (size_t k = 0; ok && (k < num_cached); k++) {
+        const struct PhysicsManifold *m = cache + k, *prev = m - 1;
+        ok = (
+            (m->a < m->b) && (m->b < len) &&
+            (m->num_points <= PHYSICS_MANIFOLD_POINTS) &&
+            (!k || (prev->a < m->a) || ((prev->a == m->a) && (prev->b <= m->b)))
+        );
+    }
+    ok = ok && physics_world_cache(w, cache, num_cached);
+    free(cache);
+    if (!ok) return false;
+
+    w->len = len, w->num_dead = aq->pool->num_dead;
+    for (size_t i = 0; i < len; i++) {
+        const struct AsteroidPrototype *proto = asteroid_prototype(aq, i);
+        w->alive[i] = aq->pool->alive[i];
+        w->inv_mass[i] = proto->inv_mass;
+        w->inv_moi[i] = proto->inv_moi;
+    }
+    return true;
+}
+
+
+/* integrate and refresh the vertex cache, pairs are collided by the grid broadphase */
+void asteroidqueue_update(struct AsteroidQueue *aq, float dt)
+{
+    aq->satcache_stats = (struct SatCacheStats) { 0 };
+
+    for (size_t i = 0; i < aq->pool->len; i++) {
+        aq->material[i].colour = WHITE;
+        aq->material[i].collision = false;
+    }
+
+    /* the same step as asteroid_update, vectorised over the queue */
+    physics_world_step(aq->bodies, dt);
+
+    asteroidqueue_apply(aq, asteroid_transform);
 }
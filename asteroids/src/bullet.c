@@ -1,6 +1,7 @@
 struct Bullet
 {
     Vector2 position;
+    Vector2 previous;
     Vector2 velocity;
     float lifetime;
 };
@@ -9,8 +10,7 @@ struct Bullet
 struct BulletQueue
 {
     struct Bullet *bullets;
-    size_t len;
-    size_t max;
+    struct Pool *pool;
 };
 
 
@@ -24,25 +24,28 @@ bool bullet_alive(struct Bullet *b)
 void bullet_clear(struct Bullet *b)
 {
     b->position = (Vector2) { 0, 0 };
+    b->previous = (Vector2) { 0, 0 };
     b->velocity = (Vector2) { 0, 0 };
     b->lifetime = 0;
 }
 
 
-void bullet_draw(struct Bullet *b)
+/* drawn at p, its position in view */
+void bullet_draw(struct Bullet *b, Vector2 p, struct RenderBatch *batch)
 {
     if (!b || !bullet_alive(b)) return;
-    DrawCircle(b->position.x, b->position.y, 2, WHITE);
+    renderbatch_point(batch, p, 2 * RENDERBATCH_POINT_SIZE, WHITE);
 }
 
 
 void bullet_update(struct Bullet *b, float dt)
 {
     if (!b || !bullet_alive(b)) return;
+    b->previous = b->position;
     b->position = vector2_wrap(
         Vector2Add(b->position, Vector2Scale(b->velocity, dt)),
         (Vector2) { 0, 0 },
-        (Vector2) { WINDOW_WIDTH, WINDOW_HEIGHT }
+        (Vector2) { WORLD_WIDTH, WORLD_HEIGHT }
     );
     b->lifetime -= dt;
 }
@@ -52,26 +55,40 @@ void bulletqueue_destroy(struct BulletQueue *bq)
 {
     if (!bq) return;
     if (bq->bullets) free(bq->bullets);
+    if (bq->pool) pool_destroy(bq->pool);
     free(bq);
 }
 
 
+bool bulletqueue_resize(struct BulletQueue *bq, size_t max)
+{
+    return pool_realloc((void **) &bq->bullets, max * sizeof(struct Bullet));
+}
+
+
+/* room for n more bullets */
+bool bulletqueue_reserve(struct BulletQueue *bq, size_t n)
+{
+    if (bq->pool->len + n <= bq->pool->max) return true;
+
+    size_t max = pool_capacity(bq->pool, n);
+    return bulletqueue_resize(bq, max) && pool_grow(bq->pool, max);
+}
+
+
+/* a queue with room for max bullets to begin with, it grows as needed */
 struct BulletQueue *bulletqueue_create(size_t max)
 {
     struct BulletQueue *bq = malloc(sizeof(struct BulletQueue));
     if (!bq) return NULL;
 
-    bq->bullets = malloc(max * sizeof(struct Bullet));
-    if (!bq->bullets) {
+    *bq = (struct BulletQueue) { 0 };
+    bq->pool = pool_create(0);
+    if (!bq->pool || !bulletqueue_reserve(bq, max)) {
         bulletqueue_destroy(bq);
         return NULL;
     }
 
-    for (size_t i = 0; i < max; i++) bullet_clear(bq->bullets + i);
-
-    bq->len = 0;
-    bq->max = max;
-
     return bq;
 }
 
@@ -83,37 +100,120 @@ void bulletqueue_apply
 )
 {
     if (!bq || !func) return;
-    for (size_t i = 0; i < bq->len; i++) func(bq->bullets + i);
+    for (size_t i = 0; i < bq->pool->len; i++) {
+        if (pool_alive(bq->pool, i)) func(bq->bullets + i);
+    }
 }
 
 
-void bulletqueue_insert(struct BulletQueue *bq, struct Bullet b)
+/* returns POOL_HANDLE_NONE only if the queue could not grow */
+struct PoolHandle bulletqueue_insert(struct BulletQueue *bq, struct Bullet b)
 {
-    if (!bq || (bq->len >= bq->max)) return;
-    bq->bullets[bq->len++] = b;
+    if (!bq || !bulletqueue_reserve(bq, 1)) return POOL_HANDLE_NONE;
+
+    bq->bullets[bq->pool->len] = b;
+    return pool_insert(bq->pool);
 }
 
 
+/* i is skipped from now on and dropped at the next bulletqueue_compact */
 void bulletqueue_remove(struct BulletQueue *bq, size_t i)
 {
-    if (!bq || i >= bq->len) return;
-    bq->bullets[i] = bq->bullets[--bq->len];
+    if (!bq) return;
+    pool_remove(bq->pool, i);
 }
 
 
-void bulletqueue_draw(struct BulletQueue *bq)
+void bulletqueue_move(void *ctx, size_t from, size_t to)
 {
-    bulletqueue_apply(bq, bullet_draw);
+    struct BulletQueue *bq = ctx;
+    bq->bullets[to] = bq->bullets[from];
+}
+
+
+/* drop removed bullets, once per step after every pass has run */
+void bulletqueue_compact(struct BulletQueue *bq)
+{
+    if (!bq) return;
+    pool_compact(bq->pool, bulletqueue_move, bq);
+}
+
+
+bool bulletqueue_write(struct BulletQueue *bq, FILE *f)
+{
+    return (
+        pool_write(bq->pool, f) &&
+        serial_write(f, bq->bullets, bq->pool->len * sizeof(struct Bullet))
+    );
+}
+
+
+bool bulletqueue_read(struct BulletQueue *bq, FILE *f)
+{
+    return (
+        pool_read(bq->pool, f) &&
+        bulletqueue_resize(bq, bq->pool->max) &&
+        serial_read(f, bq->bullets, bq->pool->len * sizeof(struct Bullet))
+    );
+}
+
+
+/* bullets are few and not in the grid, so each is tested against view directly, at
+ * its image nearest the view's centre
+ */
+void bulletqueue_draw
+(
+    struct BulletQueue *bq, Rectangle view, float alpha, struct RenderBatch *batch
+)
+{
+    if (!bq || !batch) return;
+
+    Vector2 centre = { view.x + view.width / 2, view.y + view.height / 2 };
+    for (size_t i = 0; i < bq->pool->len; i++) {
+        if (!pool_alive(bq->pool, i)) continue;
+
+        struct Bullet *b = bq->bullets + i;
+        Vector2 p = vector2_interpolate(b->previous, b->position, alpha);
+        p = Vector2Add(p, asteroidgrid_image_offset(centre, p));
+        if (!circle_on_rectangle(p, RENDERBATCH_POINT_SIZE, view)) continue;
+        bullet_draw(b, p, batch);
+    }
 }
 
 
 void bulletqueue_update(struct BulletQueue *bq, float dt)
 {
-    size_t i = 0;
-    while ((i < bq->len) && bullet_alive(bq->bullets + i)) {
-        bullet_update(bq->bullets + i, dt);
+    for (size_t i = 0; i < bq->pool->len; i++) {
+        if (!pool_alive(bq->pool, i)) continue;
 
+        bullet_update(bq->bullets + i, dt);
         if (!bullet_alive(bq->bullets + i)) bulletqueue_remove(bq, i);
-        else i++;
+    }
+}
+
+
+/* sweep each bullet over its last step, so fast bullets cannot tunnel through small
+ * asteroids; the first asteroid met takes BULLET_DAMAGE and the bullet is spent
+ */
+void bulletqueue_collide
+(
+    struct BulletQueue *bq, struct AsteroidGrid *grid, struct AsteroidQueue *aq,
+    float dt
+)
+{
+    if (!bq || !grid || !aq) return;
+
+    for (size_t i = 0; i < bq->pool->len; i++) {
+        if (!pool_alive(bq->pool, i)) continue;
+
+        struct Bullet *b = bq->bullets + i;
+        Vector2 end = Vector2Add(b->previous, Vector2Scale(b->velocity, dt));
+
+        size_t hit = asteroidgrid_sweep(grid, aq, b->previous, end);
+        if (hit == aq->pool->len) continue;
+
+        aq->material[hit].hitpoints -= BULLET_DAMAGE;
+        if (aq->material[hit].hitpoints <= 0) asteroidqueue_remove(aq, hit);
+        bulletqueue_remove(bq, i);
     }
 }
@@ -0,0 +1,54 @@
+#include <math.h>
+#include <raylib.h>
+#include <raymath.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+#define WINDOW_WIDTH  800
+#define WINDOW_HEIGHT 600
+
+/* the torus everything wraps around, a whole number of screens each way; the camera
+ * follows the player across it. stress builds widen it, see asteroids-stress
+ */
+#ifndef WORLD_WIDTH
+#define WORLD_WIDTH (4 * WINDOW_WIDTH)
+#endif
+#ifndef WORLD_HEIGHT
+#define WORLD_HEIGHT (4 * WINDOW_HEIGHT)
+#endif
+#define WORLD_SCREENS ((WORLD_WIDTH / WINDOW_WIDTH) * (WORLD_HEIGHT / WINDOW_HEIGHT))
+
+#define BULLET_LIFTIME 1
+#define BULLET_VELOCITY 300
+#define BULLETQUEUE_CAPACITY 128
+#define BULLET_DAMAGE 100
+#define ASTEROIDS_PER_SCREEN 24
+#define ASTEROIDS_INITIAL (ASTEROIDS_PER_SCREEN * WORLD_SCREENS)
+#define ASTEROIDQUEUE_CAPACITY ASTEROIDS_INITIAL
+
+#define ASTEROID_VERTICES_MAX 6
+#define ASTEROID_PIECES_MAX (ASTEROID_VERTICES_MAX - 2)
+#define ASTEROID_DENSITY 1
+
+
+#include "../../common/src/timestep.c"
+#include "../../common/src/jobs.c"
+#include "../../common/src/physics.h"
+#include "rng.c"
+#include "serial.c"
+#include "geometry.c"
+#include "input.c"
+#include "timing.c"
+#include "profile.c"
+#include "render.c"
+#include "pool.c"
+#include "shape.c"
+#include "asteroid.c"
+#include "grid.c"
+#include "bullet.c"
+#include "player.c"
+#include "state.c"
+#include "replay.c"
@@ -0,0 +1,534 @@
+static inline Vector2 vector2_wrap(Vector2 vec, const Vector2 min, const Vector2 max)
+{
+    Vector2 res = vec;
+    if (res.x < min.x) res.x = max.x;
+    if (res.y < min.y) res.y = max.y;
+    if (res.x > max.x) res.x = min.x;
+    if (res.y > max.y) res.y = min.y;
+    return res;
+}
+
+
+/* render position between two steps, snapping instead of sweeping across a wrap */
+static inline Vector2 vector2_interpolate(Vector2 prev, Vector2 curr, float alpha)
+{
+    Vector2 d = Vector2Subtract(curr, prev);
+    if ((fabsf(d.x) > WORLD_WIDTH / 2.0f) || (fabsf(d.y) > WORLD_HEIGHT / 2.0f)) {
+        return curr;
+    }
+    return Vector2Add(prev, Vector2Scale(d, alpha));
+}
+
+
+static inline float vector2_dot(Vector2 v1, Vector2 v2)
+{
+    return (v1.x*v2.x) + (v1.y*v2.y);
+}
+
+
+static inline float vector2_cross(Vector2 v1, Vector2 v2)
+{
+    return (v1.x*v2.y) - (v1.y*v2.x);
+}
+
+
+static inline Vector2 vector2_perp(Vector2 v)
+{
+    return (Vector2) { -v.y, v.x };
+}
+
+
+static inline Vector2 vector2_diff(Vector2 v1, Vector2 v2)
+{
+    return (Vector2) { v1.x - v2.x, v1.y - v2.y };
+}
+
+
+static inline bool point_on_triangle(Vector2 p, Vector2 v0, Vector2 v1, Vector2 v2)
+{
+    /* inverts the matrix implied by the wi = (vi - v0)
+     * checks for image in the unit simplex
+     */
+
+    Vector2 w1 = Vector2Subtract(v1, v0);
+    Vector2 w2 = Vector2Subtract(v2, v0);
+    Vector2 q = Vector2Subtract(p, v0);
+
+    float det = (w1.x * w2.y) - (w2.x * w1.y);
+    if (fabsf(det) < EPSILON) return false;
+
+    float invdet = 1/det;
+    float x = ((w2.y*q.x) - (w2.x*q.y)) * invdet;
+    float y = ((w1.x*q.y) - (w1.y*q.x)) * invdet;
+
+    return (x >= 0) && (y >= 0) && ((x + y) <= 1);
+}
+
+
+static inline bool point_on_segment(Vector2 p, Vector2 v0, Vector2 v1)
+{
+    /* t is projection of q = (p - v0) onto dv = (v1 - v0)
+     * s is area of rectangle q dv 
+     * check for t in [0, |dv|^2]
+     * check for s^2 in [0, |dv|^2] (implies tolerance of 1px on either side)
+     */
+
+    Vector2 dv = Vector2Subtract(v1, v0);
+    Vector2 q = Vector2Subtract(p, v0);
+    float norm_dv2 = Vector2LengthSqr(dv);
+    float t = vector2_dot(q, dv);
+    float s = vector2_cross(q, dv);
+
+    return (t >= 0) && (t <= norm_dv2) && (s*s <= norm_dv2*(1 + EPSILON));
+}
+
+
+static inline bool segment_on_segment(Vector2 p0, Vector2 p1, Vector2 q0, Vector2 q1)
+{
+    /* solve the system (K : p0 + a*dp) == (L : q0 + b*dq)
+     * check that the solution has a, b in [0, 1]
+     */
+
+    Vector2 dp = Vector2Subtract(p1, p0);
+    Vector2 dq = Vector2Subtract(q1, q0);
+    Vector2 r = Vector2Subtract(q0, p0);
+
+    float s = vector2_cross(r, dq);
+    float t = vector2_cross(r, dp);
+    float u = vector2_cross(dp, dq);
+    
+    if (u < 0) { s = -s, t = -t, u = -u; }
+    return ((s >= 0) && (t >= 0) && (s <= u) && (t <= u));
+}
+
+
+/* whether the box around a circle overlaps rect, conservative at the corners */
+static inline bool circle_on_rectangle(Vector2 c, float r, Rectangle rect)
+{
+    return (
+        (c.x + r >= rect.x) && (c.x - r <= rect.x + rect.width) &&
+        (c.y + r >= rect.y) && (c.y - r <= rect.y + rect.height)
+    );
+}
+
+
+/* fraction a along p0 p1 where it meets the line through q0 q1, for segments already
+ * known to intersect (as by segment_on_segment); 0 if they are parallel
+ */
+static inline float segment_intersection(Vector2 p0, Vector2 p1, Vector2 q0, Vector2 q1)
+{
+    Vector2 dp = Vector2Subtract(p1, p0);
+    Vector2 dq = Vector2Subtract(q1, q0);
+    float u = vector2_cross(dp, dq);
+
+    if (fabsf(u) < EPSILON) return 0;
+    return vector2_cross(Vector2Subtract(q0, p0), dq) / u;
+}
+
+
+/*  separating axis theorem
+ *      convex polygons, anticlockwise (positive signed area) vertex lists
+ *      two polygons are disjoint iff some edge normal of one of them separates them
+ */
+
+
+/* outward unit normal of edge i */
+static inline Vector2 polygon_edge_normal(Vector2 *vertices, size_t n, size_t i)
+{
+    Vector2 edge = Vector2Subtract(vertices[(i+1) % n], vertices[i]);
+    return Vector2Normalize((Vector2) { edge.y, -edge.x });
+}
+
+
+/* distance polygon 2 lies beyond edge i of polygon 1, negative if it reaches behind */
+static inline float polygon_edge_separation
+(
+    Vector2 *vertices1, size_t n1, size_t i, Vector2 *vertices2, size_t n2
+)
+{
+    Vector2 norm = polygon_edge_normal(vertices1, n1, i);
+    float base = vector2_dot(norm, vertices1[i]);
+
+    float min = vector2_dot(norm, vertices2[0]);
+    for (size_t j = 1; j < n2; j++) {
+        float proj = vector2_dot(norm, vertices2[j]);
+        if (proj < min) min = proj;
+    }
+
+    return min - base;
+}
+
+
+/* largest edge separation of polygon 2 from polygon 1, and the edge achieving it */
+static inline float polygon_max_separation
+(
+    Vector2 *vertices1, size_t n1, Vector2 *vertices2, size_t n2, size_t *edge
+)
+{
+    float best = -INFINITY;
+    for (size_t i = 0; i < n1; i++) {
+        float sep = polygon_edge_separation(vertices1, n1, i, vertices2, n2);
+        if (sep > best) best = sep, *edge = i;
+        if (best > 0) break;
+    }
+    return best;
+}
+
+
+static inline bool polygon_is_axis_separate
+(
+    Vector2 *vertices1, size_t n1, Vector2 *vertices2, size_t n2
+)
+{
+    size_t edge = 0;
+    return (polygon_max_separation(vertices1, n1, vertices2, n2, &edge) > 0);
+}
+
+
+static inline bool polygon_on_polygon
+(
+    Vector2 *vertices1, size_t n1, Vector2 *vertices2, size_t n2
+)
+{
+    return (
+        !polygon_is_axis_separate(vertices1, n1, vertices2, n2) &&
+        !polygon_is_axis_separate(vertices2, n2, vertices1, n1)
+    );
+}
+
+
+/* gap between the projections of polygon 1 and polygon 2 onto the outward normal of
+ * polygon 1's edge i, negative if they overlap; unlike polygon_edge_separation it
+ * holds for outlines which are not convex, as a test on one axis
+ */
+static inline float polygon_axis_separation
+(
+    Vector2 *vertices1, size_t n1, size_t i, Vector2 *vertices2, size_t n2
+)
+{
+    Vector2 norm = polygon_edge_normal(vertices1, n1, i);
+
+    float max = vector2_dot(norm, vertices1[0]);
+    for (size_t k = 1; k < n1; k++) max = fmaxf(max, vector2_dot(norm, vertices1[k]));
+
+    float min = vector2_dot(norm, vertices2[0]);
+    for (size_t k = 1; k < n2; k++) min = fminf(min, vector2_dot(norm, vertices2[k]));
+
+    return min - max;
+}
+
+
+/* axis_edge, axis_on_2: the separating edge if disjoint, else the reference edge;
+ * features: each point's reference edge, incident edge and end, which stay the same
+ * from step to step for polygons resting on each other
+ */
+struct PolygonContact
+{
+    Vector2 normal;
+    Vector2 points[2];
+    float depths[2];
+    unsigned int features[2];
+    size_t num_points;
+    float depth;
+    size_t axis_edge;
+    bool axis_on_2;
+};
+
+
+/* keep the part of segment p0 p1 with dot(norm, p) <= base, returns points kept */
+static inline size_t segment_clip(Vector2 *p, Vector2 norm, float base)
+{
+    Vector2 out[2];
+    size_t num = 0;
+
+    float d0 = vector2_dot(norm, p[0]) - base;
+    float d1 = vector2_dot(norm, p[1]) - base;
+
+    if (d0 <= 0) out[num++] = p[0];
+    if (d1 <= 0) out[num++] = p[1];
+    if ((d0 * d1 < 0) && (num < 2)) {
+        Vector2 dp = Vector2Subtract(p[1], p[0]);
+        out[num++] = Vector2Add(p[0], Vector2Scale(dp, d0/(d0 - d1)));
+    }
+
+    for (size_t k = 0; k < num; k++) p[k] = out[k];
+    return num;
+}
+
+
+/*  contact between two overlapping convex polygons
+ *      the reference face is the edge of least penetration, found over both polygons;
+ *      the most anti-parallel edge of the other polygon is clipped to the reference
+ *      face's side planes, and the clipped points behind the face are the contacts
+ *
+ *      contact->normal points from polygon 1 to polygon 2, depths are non-negative
+ *      returns false if some axis separates the polygons, true otherwise (contact
+ *      points can still be empty in degenerate, grazing configurations)
+ */
+static inline bool polygon_contact
+(
+    Vector2 *vertices1, size_t n1, Vector2 *vertices2, size_t n2,
+    struct PolygonContact *contact
+)
+{
+    size_t edge1 = 0, edge2 = 0;
+    contact->num_points = 0;
+
+    float sep1 = polygon_max_separation(vertices1, n1, vertices2, n2, &edge1);
+    contact->axis_edge = edge1, contact->axis_on_2 = false;
+    if (sep1 > 0) return false;
+
+    float sep2 = polygon_max_separation(vertices2, n2, vertices1, n1, &edge2);
+    if (sep2 > 0) {
+        contact->axis_edge = edge2, contact->axis_on_2 = true;
+        return false;
+    }
+
+    /* prefer polygon 1 as reference unless polygon 2 is clearly better */
+    bool flip = (sep2 > sep1 + 1e-3f);
+    Vector2 *ref = (flip) ? vertices2 : vertices1;
+    Vector2 *inc = (flip) ? vertices1 : vertices2;
+    size_t n_ref = (flip) ? n2 : n1, n_inc = (flip) ? n1 : n2;
+    size_t edge = (flip) ? edge2 : edge1;
+
+    Vector2 norm = polygon_edge_normal(ref, n_ref, edge);
+    Vector2 r0 = ref[edge], r1 = ref[(edge+1) % n_ref];
+
+    size_t inc_edge = 0;
+    float min_dot = INFINITY;
+    for (size_t j = 0; j < n_inc; j++) {
+        float d = vector2_dot(norm, polygon_edge_normal(inc, n_inc, j));
+        if (d < min_dot) min_dot = d, inc_edge = j;
+    }
+    Vector2 points[2] = { inc[inc_edge], inc[(inc_edge+1) % n_inc] };
+
+    Vector2 tangent = Vector2Normalize(Vector2Subtract(r1, r0));
+    float lo = vector2_dot(tangent, r0), hi = vector2_dot(tangent, r1);
+    size_t num = segment_clip(points, Vector2Negate(tangent), -lo);
+    if (num == 2) {
+        num = segment_clip(points, tangent, hi);
+    }
+
+    float base = vector2_dot(norm, r0);
+    contact->normal = norm, contact->depth = 0;
+    contact->axis_edge = edge, contact->axis_on_2 = flip;
+    for (size_t k = 0; k < num; k++) {
+        float depth = base - vector2_dot(norm, points[k]);
+        if (depth < 0) continue;
+
+        contact->points[contact->num_points] = points[k];
+        contact->depths[contact->num_points] = depth;
+        contact->features[contact->num_points++] = (
+            (flip << 24) | (edge << 16) | (inc_edge << 8) | k
+        );
+        if (depth > contact->depth) contact->depth = depth;
+    }
+    if (flip) contact->normal = Vector2Negate(norm);
+
+    return true;
+}
+
+
+static inline float polygon_area_moment_0(Vector2 *vertices, size_t n)
+{
+    if (!vertices || !n) return 0;
+
+    float area = 0;
+    Vector2 curr = { 0 }, next = vertices[0];
+    for (size_t i = 0; i < n; i++) {
+        curr = next, next = vertices[(i+1) % n];
+        area += vector2_cross(curr, next);
+    }
+
+    return fabsf(area);
+}
+
+
+static inline Vector2 polygon_area_moment_1(Vector2 *vertices, size_t n)
+{
+    if (!vertices || !n) return (Vector2) { 0, 0 };
+
+    Vector2 moment_1 = { 0 };
+    float factor = 0, denominator = 0;
+    Vector2 curr = { 0 }, next = vertices[0];
+
+    for (size_t i = 0; i < n; i++) {
+        curr = next, next = vertices[(i+1) % n];
+        factor = vector2_cross(curr, next);
+        moment_1.x += (curr.x + next.x) * factor;
+        moment_1.y += (curr.y + next.y) * factor;
+        denominator += factor;
+    }
+
+    return Vector2Scale(moment_1, 1/(3*denominator));
+}
+
+
+static inline float polygon_area_moment_2(Vector2 *vertices, size_t n)
+{
+    if (!vertices || !n) return 0;
+
+    float moment_2 = 0;
+    float factor = 0, denominator = 0;
+    Vector2 curr = { 0 }, next = vertices[0];
+
+    for (size_t i = 0; i < n; i++) {
+        curr = next, next = vertices[(i+1) % n];
+        factor = vector2_cross(curr, next);
+        moment_2 += factor * (
+            Vector2LengthSqr(curr) + vector2_dot(curr, next) + Vector2LengthSqr(next)
+        );
+        denominator += factor;
+    }
+    
+    return moment_2 / (6*denominator);
+}
+
+
+/*  convex decomposition
+ *      simple anticlockwise outlines of up to ASTEROID_VERTICES_MAX corners, convex or
+ *      not: ear clipping cuts one into n - 2 triangles, then Hertel-Mehlhorn merging
+ *      drops each diagonal whose removal leaves both its ends convex, which leaves at
+ *      most four times the fewest convex pieces possible
+ *
+ *      triangles and pieces are lists of indices into the outline, anticlockwise, so
+ *      each of their edges is either an outline edge or a diagonal
+ */
+
+
+/* whether the outline turns left (or runs straight on) at b, coming from a to c */
+static inline bool polygon_corner_convex(Vector2 a, Vector2 b, Vector2 c)
+{
+    return vector2_cross(Vector2Subtract(b, a), Vector2Subtract(c, b)) >= 0;
+}
+
+
+/* the outline, which must be simple, cut into n - 2 triangles; returns how many, or
+ * 0 if at some point no ear could be found
+ */
+static inline size_t polygon_triangulate
+(
+    Vector2 *vertices, size_t n, unsigned char (*triangles)[3]
+)
+{
+    if ((n < 3) || (n > ASTEROID_VERTICES_MAX)) return 0;
+
+    unsigned char left[ASTEROID_VERTICES_MAX];
+    for (size_t k = 0; k < n; k++) left[k] = k;
+
+    size_t num = 0, len = n;
+    while (len > 3) {
+        /* the first ear: a convex corner whose triangle holds no other corner left */
+        size_t ear = len;
+        for (size_t k = 0; (k < len) && (ear == len); k++) {
+            size_t a = left[(k + len - 1) % len], b = left[k], c = left[(k + 1) % len];
+            if (!polygon_corner_convex(vertices[a], vertices[b], vertices[c])) continue;
+
+            bool empty = true;
+            for (size_t m = 0; (m < len) && empty; m++) {
+                size_t d = left[m];
+                if ((d == a) || (d == b) || (d == c)) continue;
+                empty = !point_on_triangle(
+                    vertices[d], vertices[a], vertices[b], vertices[c]
+                );
+            }
+            if (empty) ear = k;
+        }
+        if (ear == len) return 0;
+
+        triangles[num][0] = left[(ear + len - 1) % len];
+        triangles[num][1] = left[ear];
+        triangles[num][2] = left[(ear + 1) % len];
+        num++;
+
+        for (size_t k = ear; k + 1 < len; k++) left[k] = left[k + 1];
+        len--;
+    }
+    for (size_t k = 0; k < 3; k++) triangles[num][k] = left[k];
+
+    return num + 1;
+}
+
+
+/* merge piece b into piece a across the diagonal they share, if the result is convex;
+ * returns whether they were merged
+ */
+static inline bool polygon_piece_merge
+(
+    Vector2 *vertices, unsigned char *a, size_t *na, const unsigned char *b, size_t nb
+)
+{
+    /* the diagonal runs a[i] -> a[i+1] in a, and back as b[j] -> b[j+1] in b */
+    size_t i = *na, j = nb;
+    for (size_t s = 0; (s < *na) && (i == *na); s++) {
+        for (size_t t = 0; t < nb; t++) {
+            if ((a[s] == b[(t + 1) % nb]) && (a[(s + 1) % *na] == b[t])) {
+                i = s, j = t;
+                break;
+            }
+        }
+    }
+    if (i == *na) return false;
+
+    /* a from a[i+1] round to a[i], then b strictly between b[j+1] and b[j] */
+    unsigned char merged[ASTEROID_VERTICES_MAX];
+    size_t len = 0;
+    for (size_t k = 1; k <= *na; k++) merged[len++] = a[(i + k) % *na];
+    for (size_t k = 2; k < nb; k++) merged[len++] = b[(j + k) % nb];
+
+    /* only the two ends of the diagonal can have turned reflex */
+    size_t ends[2] = { 0, *na - 1 };
+    for (size_t e = 0; e < 2; e++) {
+        size_t k = ends[e];
+        Vector2 prev = vertices[merged[(k + len - 1) % len]];
+        Vector2 next = vertices[merged[(k + 1) % len]];
+        if (!polygon_corner_convex(prev, vertices[merged[k]], next)) return false;
+    }
+
+    for (size_t k = 0; k < len; k++) a[k] = merged[k];
+    *na = len;
+    return true;
+}
+
+
+/* the outline as convex pieces, piece p the sizes[p] corners in pieces[p]; returns
+ * how many, 0 if it could not be triangulated
+ */
+static inline size_t polygon_decompose
+(
+    Vector2 *vertices, size_t n, unsigned char (*pieces)[ASTEROID_VERTICES_MAX],
+    size_t *sizes
+)
+{
+    unsigned char triangles[ASTEROID_VERTICES_MAX][3];
+    size_t num = polygon_triangulate(vertices, n, triangles);
+
+    for (size_t p = 0; p < num; p++) {
+        for (size_t k = 0; k < 3; k++) pieces[p][k] = triangles[p][k];
+        sizes[p] = 3;
+    }
+
+    /* greedily, in order, until no diagonal can go */
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (size_t p = 0; (p < num) && !merged; p++) {
+            for (size_t q = p + 1; (q < num) && !merged; q++) {
+                merged = polygon_piece_merge(
+                    vertices, pieces[p], sizes + p, pieces[q], sizes[q]
+                );
+                if (!merged) continue;
+
+                for (size_t r = q; r + 1 < num; r++) {
+                    for (size_t k = 0; k < sizes[r + 1]; k++) {
+                        pieces[r][k] = pieces[r + 1][k];
+                    }
+                    sizes[r] = sizes[r + 1];
+                }
+                num--;
+            }
+        }
+    }
+
+    return num;
+}
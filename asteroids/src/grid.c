@@ -0,0 +1,574 @@
+/*  uniform grid broadphase
+ *      the world is treated as a torus and cut into cols x rows cells, each at least
+ *      as wide as the largest swept diameter, so any pair which collides during the
+ *      step lies in the same or a neighbouring cell (neighbours wrap across the world
+ *      edges). an asteroid's swept circle covers its bounding circle over the whole
+ *      step: centred halfway along its motion, wider by half the distance moved. at
+ *      ordinary speeds that is barely more than the bounding circle itself
+ *
+ *      cells are stored compactly: entries holds asteroid indices sorted by cell, and
+ *      cell_start[c] .. cell_start[c+1] is the slice belonging to cell c
+ *
+ *      collision runs in two passes: detection is spread over a job pool, each worker
+ *      appending contacts to its own buffer, then the buffers are merged, sorted by
+ *      pair and handed to the physics world's solver, which runs serially, so the
+ *      outcome is the same for any worker count
+ */
+
+#define ASTEROIDGRID_JOB_CHUNK 32
+#define ASTEROIDGRID_CONTACTS_MIN 64
+
+
+struct AsteroidPairContact
+{
+    struct PhysicsManifold manifold;
+    float toi;
+};
+
+
+struct AsteroidContactBuffer
+{
+    struct AsteroidPairContact *contacts;
+    size_t len;
+    size_t max;
+    size_t pairs_tested;
+    size_t dropped;
+    struct SatCacheStats stats;
+};
+
+
+struct AsteroidGrid
+{
+    size_t *cell_start;
+    size_t *cell_of;
+    size_t *entries;
+    size_t num_cells;
+    size_t max;
+    size_t cols;
+    size_t rows;
+    float cell_width;
+    float cell_height;
+    size_t pairs_tested;
+    size_t pairs_collided;
+    size_t pairs_swept;
+    size_t contacts_dropped;
+    size_t drawn;
+
+    struct AsteroidContactBuffer *buffers;
+    size_t num_buffers;
+    struct AsteroidContactBuffer merged;
+
+    /* the merged contacts as the solver takes them, and per asteroid, the earliest
+     * time of impact and the velocity going into the solve of those swept
+     */
+    struct PhysicsManifold *manifolds;
+    size_t max_manifolds;
+    float *toi;
+    Vector2 *velocity_old;
+};
+
+
+void asteroidgrid_destroy(struct AsteroidGrid *grid)
+{
+    if (!grid) return;
+    if (grid->cell_start) free(grid->cell_start);
+    if (grid->cell_of) free(grid->cell_of);
+    if (grid->entries) free(grid->entries);
+    if (grid->buffers) {
+        for (size_t w = 0; w < grid->num_buffers; w++) free(grid->buffers[w].contacts);
+        free(grid->buffers);
+    }
+    if (grid->merged.contacts) free(grid->merged.contacts);
+    if (grid->manifolds) free(grid->manifolds);
+    if (grid->toi) free(grid->toi);
+    if (grid->velocity_old) free(grid->velocity_old);
+    free(grid);
+}
+
+
+/* a grid for up to max asteroids, collided by up to num_workers workers */
+struct AsteroidGrid *asteroidgrid_create(size_t max, size_t num_workers)
+{
+    struct AsteroidGrid *grid = malloc(sizeof(struct AsteroidGrid));
+    if (!grid) return NULL;
+
+    if (!num_workers) num_workers = 1;
+
+    *grid = (struct AsteroidGrid) { 0 };
+    grid->cell_of = malloc(max * sizeof(size_t));
+    grid->entries = malloc(max * sizeof(size_t));
+    grid->toi = malloc(max * sizeof(float));
+    grid->velocity_old = malloc(max * sizeof(Vector2));
+    grid->buffers = calloc(num_workers, sizeof(struct AsteroidContactBuffer));
+    if (
+        !grid->cell_of || !grid->entries || !grid->toi || !grid->velocity_old ||
+        !grid->buffers
+    ) {
+        asteroidgrid_destroy(grid);
+        return NULL;
+    }
+    grid->max = max;
+    grid->num_buffers = num_workers;
+
+    return grid;
+}
+
+
+/* cell containing a point, after wrapping the point onto the world torus */
+size_t asteroidgrid_cell(struct AsteroidGrid *grid, Vector2 p)
+{
+    float x = fmodf(p.x, WORLD_WIDTH), y = fmodf(p.y, WORLD_HEIGHT);
+    if (x < 0) x += WORLD_WIDTH;
+    if (y < 0) y += WORLD_HEIGHT;
+
+    size_t col = x / grid->cell_width, row = y / grid->cell_height;
+    if (col >= grid->cols) col = grid->cols - 1;
+    if (row >= grid->rows) row = grid->rows - 1;
+
+    return row * grid->cols + col;
+}
+
+
+/* centre of asteroid i's swept circle over the last step of length dt */
+Vector2 asteroidgrid_swept_centre(struct AsteroidQueue *aq, size_t i, float dt)
+{
+    struct PhysicsWorld *w = aq->bodies;
+    return Vector2Subtract(w->position[i], Vector2Scale(w->velocity[i], 0.5f * dt));
+}
+
+
+/* leave every cell empty, so what reads the grid finds nothing rather than indices
+ * from an earlier build
+ */
+void asteroidgrid_clear(struct AsteroidGrid *grid)
+{
+    if (!grid->cell_start) return;
+    for (size_t c = 0; c <= grid->num_cells; c++) grid->cell_start[c] = 0;
+}
+
+
+/* resize the cells to fit the largest swept radius over the last step of length dt,
+ * then counting-sort asteroids by the cell of their swept centre; false, with the
+ * grid left empty, if it could not grow to the queue
+ */
+bool asteroidgrid_build(struct AsteroidGrid *grid, struct AsteroidQueue *aq, float dt)
+{
+    if (!grid || !aq) return false;
+
+    struct PhysicsWorld *w = aq->bodies;
+
+    /* follow the queue's capacity */
+    if (aq->pool->len > grid->max) {
+        size_t max = aq->pool->max;
+        if (
+            !pool_realloc((void **) &grid->cell_of, max * sizeof(size_t)) ||
+            !pool_realloc((void **) &grid->entries, max * sizeof(size_t)) ||
+            !pool_realloc((void **) &grid->toi, max * sizeof(float)) ||
+            !pool_realloc((void **) &grid->velocity_old, max * sizeof(Vector2))
+        ) {
+            asteroidgrid_clear(grid);
+            return false;
+        }
+        grid->max = max;
+    }
+
+    float radius = ASTEROIDLEVEL_RADIUS[NUM_ASTEROID_LEVELS - 1];
+    for (size_t i = 0; i < aq->pool->len; i++) {
+        float swept = w->radius[i] + 0.5f * dt * Vector2Length(w->velocity[i]);
+        if (swept > radius) radius = swept;
+    }
+
+    float cell_min = 2 * radius * (1 + EPSILON);
+    size_t cols = WORLD_WIDTH / cell_min, rows = WORLD_HEIGHT / cell_min;
+    if (cols < 1) cols = 1;
+    if (rows < 1) rows = 1;
+
+    if (cols * rows != grid->num_cells) {
+        size_t *cell_start = realloc(
+            grid->cell_start, (cols*rows + 1) * sizeof(size_t)
+        );
+        if (!cell_start) {
+            asteroidgrid_clear(grid);
+            return false;
+        }
+        grid->cell_start = cell_start;
+        grid->num_cells = cols * rows;
+    }
+    grid->cols = cols, grid->rows = rows;
+    grid->cell_width = (float) WORLD_WIDTH / cols;
+    grid->cell_height = (float) WORLD_HEIGHT / rows;
+
+    for (size_t c = 0; c <= grid->num_cells; c++) grid->cell_start[c] = 0;
+
+    for (size_t i = 0; i < aq->pool->len; i++) {
+        grid->cell_of[i] = asteroidgrid_cell(
+            grid, asteroidgrid_swept_centre(aq, i, dt)
+        );
+        grid->cell_start[grid->cell_of[i] + 1]++;
+        grid->toi[i] = 1;
+    }
+    for (size_t c = 0; c < grid->num_cells; c++) {
+        grid->cell_start[c + 1] += grid->cell_start[c];
+    }
+
+    /* scatter, then walk cell_start back down so it again marks the slice starts */
+    for (size_t i = 0; i < aq->pool->len; i++) {
+        grid->entries[grid->cell_start[grid->cell_of[i]]++] = i;
+    }
+    for (size_t c = grid->num_cells; c > 0; c--) {
+        grid->cell_start[c] = grid->cell_start[c - 1];
+    }
+    grid->cell_start[0] = 0;
+
+    return true;
+}
+
+
+/* distinct cells in the wrapped 3x3 neighbourhood of cell, returns how many */
+size_t asteroidgrid_neighbours(struct AsteroidGrid *grid, size_t cell, size_t *out)
+{
+    size_t num = 0;
+    size_t col = cell % grid->cols, row = cell / grid->cols;
+
+    for (size_t dr = 0; dr < 3; dr++) {
+        for (size_t dc = 0; dc < 3; dc++) {
+            size_t c = (
+                ((row + grid->rows + dr - 1) % grid->rows) * grid->cols +
+                ((col + grid->cols + dc - 1) % grid->cols)
+            );
+
+            bool seen = false;
+            for (size_t k = 0; k < num; k++) seen = seen || (out[k] == c);
+            if (!seen) out[num++] = c;
+        }
+    }
+
+    return num;
+}
+
+
+/* offset which moves q to the image nearest p on the world torus */
+Vector2 asteroidgrid_image_offset(Vector2 p, Vector2 q)
+{
+    Vector2 offset = { 0, 0 };
+    Vector2 d = Vector2Subtract(q, p);
+
+    if (d.x > WORLD_WIDTH / 2.0f) offset.x = -WORLD_WIDTH;
+    if (d.x < -WORLD_WIDTH / 2.0f) offset.x = WORLD_WIDTH;
+    if (d.y > WORLD_HEIGHT / 2.0f) offset.y = -WORLD_HEIGHT;
+    if (d.y < -WORLD_HEIGHT / 2.0f) offset.y = WORLD_HEIGHT;
+
+    return offset;
+}
+
+
+/*  first live asteroid met by the segment p0 p1, or aq->pool->len if none
+ *      the segment is walked in pieces no longer than a cell, so every asteroid a
+ *      piece can touch lies in the 3x3 neighbourhood of the cell of its midpoint
+ */
+size_t asteroidgrid_sweep
+(
+    struct AsteroidGrid *grid, struct AsteroidQueue *aq, Vector2 p0, Vector2 p1
+)
+{
+    size_t len = aq->pool->len;
+    if (!grid || !grid->num_cells) return len;
+
+    Vector2 d = Vector2Subtract(p1, p0);
+    float cell = fminf(grid->cell_width, grid->cell_height);
+    size_t pieces = 1 + (size_t) (Vector2Length(d) / cell);
+    size_t neighbours[9];
+
+    for (size_t piece = 0; piece < pieces; piece++) {
+        Vector2 a = Vector2Add(p0, Vector2Scale(d, (float) piece / pieces));
+        Vector2 b = Vector2Add(p0, Vector2Scale(d, (float) (piece + 1) / pieces));
+        Vector2 mid = Vector2Scale(Vector2Add(a, b), 0.5f);
+
+        size_t hit = len;
+        float t_hit = 0;
+
+        size_t num = asteroidgrid_neighbours(
+            grid, asteroidgrid_cell(grid, mid), neighbours
+        );
+        for (size_t n = 0; n < num; n++) {
+            size_t c = neighbours[n];
+            for (size_t k = grid->cell_start[c]; k < grid->cell_start[c + 1]; k++) {
+                size_t j = grid->entries[k];
+                if (!asteroid_alive(aq, j)) continue;
+
+                float t;
+                Vector2 p = aq->bodies->position[j];
+                Vector2 offset = asteroidgrid_image_offset(mid, p);
+                if (!asteroid_segment(aq, j, offset, a, b, &t)) continue;
+
+                if ((hit == len) || (t < t_hit) || ((t == t_hit) && (j < hit))) {
+                    hit = j, t_hit = t;
+                }
+            }
+        }
+
+        if (hit < len) return hit;
+    }
+
+    return len;
+}
+
+
+/* cell index along an axis of n cells, wrapped round the torus */
+size_t asteroidgrid_wrap(long k, size_t n)
+{
+    long m = k % (long) n;
+    return (m < 0) ? m + (long) n : m;
+}
+
+
+/*  draw the asteroids in view, a rectangle of the world no larger than it
+ *      only the cells under view and a margin of one cell are visited: an asteroid is
+ *      binned by its swept centre, and its swept circle, which covers it wherever it is
+ *      drawn between the last two steps, fits in a cell. each is drawn at its image
+ *      nearest the view's centre, if its bounding circle there meets view
+ */
+void asteroidgrid_draw
+(
+    struct AsteroidGrid *grid, struct AsteroidQueue *aq, Rectangle view, float alpha,
+    struct RenderBatch *batch
+)
+{
+    if (!grid || !aq || !batch || !grid->num_cells) return;
+
+    struct PhysicsWorld *w = aq->bodies;
+
+    Vector2 centre = { view.x + view.width / 2, view.y + view.height / 2 };
+    long col0 = floorf(view.x / grid->cell_width) - 1;
+    long row0 = floorf(view.y / grid->cell_height) - 1;
+    size_t cols = floorf((view.x + view.width) / grid->cell_width) + 2 - col0;
+    size_t rows = floorf((view.y + view.height) / grid->cell_height) + 2 - row0;
+    if (cols > grid->cols) cols = grid->cols;
+    if (rows > grid->rows) rows = grid->rows;
+
+    grid->drawn = 0;
+    for (size_t r = 0; r < rows; r++) {
+        size_t row = asteroidgrid_wrap(row0 + (long) r, grid->rows);
+        for (size_t c = 0; c < cols; c++) {
+            size_t col = asteroidgrid_wrap(col0 + (long) c, grid->cols);
+            size_t cell = row * grid->cols + col;
+            size_t end = grid->cell_start[cell + 1];
+
+            for (size_t k = grid->cell_start[cell]; k < end; k++) {
+                size_t i = grid->entries[k];
+                if (!asteroid_alive(aq, i)) continue;
+
+                Vector2 p = vector2_interpolate(
+                    w->prev_position[i], w->position[i], alpha
+                );
+                Vector2 offset = asteroidgrid_image_offset(centre, p);
+                if (!circle_on_rectangle(Vector2Add(p, offset), w->radius[i], view)) {
+                    continue;
+                }
+
+                asteroid_draw(aq, i, offset, alpha, batch);
+                grid->drawn++;
+            }
+        }
+    }
+}
+
+
+/* room for n more contacts, growing geometrically */
+bool asteroidcontacts_reserve(struct AsteroidContactBuffer *buf, size_t n)
+{
+    if (buf->len + n <= buf->max) return true;
+
+    size_t max = (buf->max) ? buf->max : ASTEROIDGRID_CONTACTS_MIN;
+    while (max < buf->len + n) max *= 2;
+
+    struct AsteroidPairContact *contacts = realloc(
+        buf->contacts, max * sizeof(struct AsteroidPairContact)
+    );
+    if (!contacts) return false;
+
+    buf->contacts = contacts;
+    buf->max = max;
+    return true;
+}
+
+
+/* by pair, and a pair's contacts by their first feature, which names their pieces */
+int asteroidcontacts_compare(const void *a, const void *b)
+{
+    const struct PhysicsManifold *p = a, *q = b;
+    if (p->a != q->a) return (p->a < q->a) ? -1 : 1;
+    if (p->b != q->b) return (p->b < q->b) ? -1 : 1;
+    if (p->features[0] != q->features[0]) {
+        return (p->features[0] < q->features[0]) ? -1 : 1;
+    }
+    return 0;
+}
+
+
+struct AsteroidGridJob
+{
+    struct AsteroidGrid *grid;
+    struct AsteroidQueue *aq;
+    float dt;
+};
+
+
+/* detection for asteroids [begin, end) against every later neighbour */
+void asteroidgrid_detect(void *ctx, size_t begin, size_t end, size_t worker)
+{
+    struct AsteroidGrid *grid = ((struct AsteroidGridJob *) ctx)->grid;
+    struct AsteroidQueue *aq = ((struct AsteroidGridJob *) ctx)->aq;
+    float dt = ((struct AsteroidGridJob *) ctx)->dt;
+    struct AsteroidContactBuffer *buf = grid->buffers + worker;
+
+    size_t neighbours[9];
+
+    for (size_t i = begin; i < end; i++) {
+        size_t num = asteroidgrid_neighbours(grid, grid->cell_of[i], neighbours);
+
+        for (size_t n = 0; n < num; n++) {
+            size_t c = neighbours[n];
+            for (size_t k = grid->cell_start[c]; k < grid->cell_start[c + 1]; k++) {
+                size_t j = grid->entries[k];
+                if (j <= i) continue;
+
+                /* pairs straddling a world edge collide between nearest images */
+                struct PolygonContact contacts[ASTEROID_CONTACTS_MAX];
+                float toi = 1;
+                Vector2 offset = asteroidgrid_image_offset(
+                    asteroidgrid_swept_centre(aq, i, dt),
+                    asteroidgrid_swept_centre(aq, j, dt)
+                );
+
+                buf->pairs_tested++;
+                size_t num = asteroid_detect(
+                    aq, i, j, &offset, dt, &toi, contacts, &buf->stats
+                );
+                if (!num) continue;
+                if (!asteroidcontacts_reserve(buf, num)) {
+                    buf->dropped += num;
+                    continue;
+                }
+
+                for (size_t q = 0; q < num; q++) {
+                    buf->contacts[buf->len++] = (struct AsteroidPairContact) {
+                        .manifold = asteroid_manifold(i, j, offset, contacts + q),
+                        .toi = toi
+                    };
+                }
+            }
+        }
+    }
+}
+
+
+/* run the narrowphase on every pair sharing a neighbourhood, each pair exactly once,
+ * then solve the contacts found together, in (i, j) order; an asteroid which met
+ * another partway through the step of length dt finishes the step from its earliest
+ * such meeting with its new velocity; contacts there was no room for are counted in
+ * contacts_dropped rather than solved
+ */
+void asteroidgrid_collide
+(
+    struct AsteroidGrid *grid, struct AsteroidQueue *aq, struct JobPool *jobs,
+    float dt
+)
+{
+    if (!grid || !aq || !grid->num_cells) return;
+
+    /* more workers than buffers: detect on the calling thread alone */
+    if (jobs && (jobs->num_workers > grid->num_buffers)) jobs = NULL;
+
+    for (size_t w = 0; w < grid->num_buffers; w++) {
+        struct AsteroidContactBuffer *buf = grid->buffers + w;
+        buf->len = 0, buf->pairs_tested = 0, buf->dropped = 0;
+        buf->stats = (struct SatCacheStats) { 0 };
+    }
+
+    struct AsteroidGridJob job = { .grid = grid, .aq = aq, .dt = dt };
+    jobs_run(jobs, asteroidgrid_detect, &job, aq->pool->len, ASTEROIDGRID_JOB_CHUNK);
+
+    struct AsteroidContactBuffer *merged = &grid->merged;
+    merged->len = 0;
+    grid->pairs_tested = 0, grid->pairs_collided = 0, grid->contacts_dropped = 0;
+    aq->satcache_stats = (struct SatCacheStats) { 0 };
+
+    for (size_t w = 0; w < grid->num_buffers; w++) {
+        struct AsteroidContactBuffer *buf = grid->buffers + w;
+        grid->pairs_tested += buf->pairs_tested;
+        grid->contacts_dropped += buf->dropped;
+        aq->satcache_stats.tests += buf->stats.tests;
+        aq->satcache_stats.hits += buf->stats.hits;
+
+        if (!buf->len) continue;
+        if (!asteroidcontacts_reserve(merged, buf->len)) {
+            grid->contacts_dropped += buf->len;
+            continue;
+        }
+        memcpy(
+            merged->contacts + merged->len, buf->contacts,
+            buf->len * sizeof(struct AsteroidPairContact)
+        );
+        merged->len += buf->len;
+    }
+
+    if (merged->len > 1) {
+        qsort(
+            merged->contacts, merged->len, sizeof(struct AsteroidPairContact),
+            asteroidcontacts_compare
+        );
+    }
+
+    if (merged->len > grid->max_manifolds) {
+        size_t max = merged->max, size = max * sizeof(struct PhysicsManifold);
+        if (!pool_realloc((void **) &grid->manifolds, size)) {
+            grid->contacts_dropped += merged->len;
+            return;
+        }
+        grid->max_manifolds = max;
+    }
+
+    struct PhysicsWorld *w = aq->bodies;
+    for (size_t k = 0; k < merged->len; k++) {
+        struct AsteroidPairContact *p = merged->contacts + k;
+        grid->manifolds[k] = p->manifold;
+        if (p->toi == 1) continue;
+
+        size_t ends[2] = { p->manifold.a, p->manifold.b };
+        for (size_t e = 0; e < 2; e++) {
+            size_t i = ends[e];
+            if (grid->toi[i] == 1) grid->velocity_old[i] = w->velocity[i];
+            if (p->toi < grid->toi[i]) grid->toi[i] = p->toi;
+        }
+    }
+
+    physics_world_solve(w, grid->manifolds, merged->len, dt);
+
+    grid->pairs_swept = 0;
+    float impulse = 0;
+    for (size_t k = 0; k < merged->len; k++) {
+        struct PhysicsManifold *m = grid->manifolds + k;
+        for (size_t q = 0; q < m->num_points; q++) impulse += m->impulse[q];
+
+        /* a concave pair's contacts, one per pair of pieces, are taken together */
+        const struct PhysicsManifold *next = m + 1;
+        if ((k + 1 < merged->len) && (next->a == m->a) && (next->b == m->b)) continue;
+        bool pushed = (impulse > 0);
+        impulse = 0;
+        if (!pushed) continue;
+
+        asteroid_touch(aq, m->a, m->b);
+        grid->pairs_collided++;
+        if (merged->contacts[k].toi == 1) continue;
+
+        grid->pairs_swept++;
+        size_t ends[2] = { m->a, m->b };
+        for (size_t e = 0; e < 2; e++) {
+            size_t i = ends[e];
+            if (grid->toi[i] == 1) continue;
+            asteroid_redirect(aq, i, grid->velocity_old[i], (1 - grid->toi[i]) * dt);
+            grid->toi[i] = 1;
+        }
+    }
+}
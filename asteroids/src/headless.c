@@ -0,0 +1,276 @@
+#include <string.h>
+
+#include "game.c"
+
+/*  headless runner
+ *      steps the simulation with a fixed dt, seed and entity count, without opening a
+ *      window, and reports throughput and the time spent in each phase
+ *
+ *      asteroids-headless [--steps N] [--dt SEC] [--seed S] [--asteroids N]
+ *                         [--input random|idle] [--threads N] [--scaling N]
+ *                         [--iterations N] [--replay FILE [--from TICK]]
+ *                         [--record FILE]
+ *
+ *      --steps is HEADLESS_STEPS by default, or the rest of the game when replaying
+ *
+ *      --scaling N repeats the run with 1, 2, 4 .. N threads and reports the speedup
+ *      of each over one thread, with a hash of the final state to show they agree;
+ *      it fails if they do not
+ *
+ *      --iterations sets the contact solver's iterations per step (PHYSICS_ITERATIONS
+ *      by default)
+ *
+ *      --replay plays back a recorded game, whose seed, dt, asteroid count and solver
+ *      iterations replace the options'; --from seeks to a tick (untimed) before the
+ *      timed steps, so a stretch of a real game becomes a repeatable workload.
+ *      --record saves the run, and cannot be combined with --scaling
+ *
+ *      asteroids-stress is this runner built for a world of 66 x 66 screens, where
+ *      the default asteroid count is over 100k
+ */
+
+#define HEADLESS_STEPS 1000
+
+
+struct HeadlessOptions
+{
+    size_t steps;
+    float dt;
+    unsigned int seed;
+    size_t asteroids;
+    enum INPUT_SOURCE input;
+    size_t threads;
+    size_t scaling;
+    size_t iterations;
+    struct Replay *replay;
+    size_t from;
+    const char *record;
+};
+
+
+struct HeadlessRun
+{
+    double elapsed;
+    double phase_total[NUM_UPDATE_PHASES];
+    size_t workers;
+    size_t survivors;
+    size_t dropped;
+    unsigned long long hash;
+};
+
+
+void headless_usage(const char *name)
+{
+    fprintf(
+        stderr,
+        "usage: %s [--steps N] [--dt SEC] [--seed S] [--asteroids N] "
+        "[--input random|idle] [--threads N] [--scaling N] [--iterations N] "
+        "[--replay FILE [--from TICK]] [--record FILE]\n",
+        name
+    );
+}
+
+
+bool headless_parse(int argc, char **argv, struct HeadlessOptions *opt)
+{
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i], *val = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (!val) return false;
+
+        if (!strcmp(arg, "--steps")) opt->steps = strtoul(val, NULL, 10);
+        else if (!strcmp(arg, "--dt")) opt->dt = strtof(val, NULL);
+        else if (!strcmp(arg, "--seed")) opt->seed = strtoul(val, NULL, 10);
+        else if (!strcmp(arg, "--asteroids")) opt->asteroids = strtoul(val, NULL, 10);
+        else if (!strcmp(arg, "--input") && !strcmp(val, "random")) {
+            opt->input = SOURCE_RANDOM;
+        }
+        else if (!strcmp(arg, "--input") && !strcmp(val, "idle")) {
+            opt->input = SOURCE_SCRIPT;
+        }
+        else if (!strcmp(arg, "--threads")) opt->threads = strtoul(val, NULL, 10);
+        else if (!strcmp(arg, "--scaling")) opt->scaling = strtoul(val, NULL, 10);
+        else if (!strcmp(arg, "--iterations")) {
+            opt->iterations = strtoul(val, NULL, 10);
+        }
+        else if (!strcmp(arg, "--replay")) {
+            if (opt->replay) replay_destroy(opt->replay);
+            opt->replay = replay_open(val);
+            if (!opt->replay) {
+                fprintf(stderr, "could not read replay %s\n", val);
+                return false;
+            }
+        }
+        else if (!strcmp(arg, "--from")) opt->from = strtoul(val, NULL, 10);
+        else if (!strcmp(arg, "--record")) opt->record = val;
+        else return false;
+
+        i++;
+    }
+
+    /* each run of a scaling test would overwrite the last one's recording */
+    if (opt->record && opt->scaling) {
+        fprintf(stderr, "--record cannot be used with --scaling\n");
+        return false;
+    }
+
+    /* a replay plays to its end unless told otherwise */
+    if (opt->replay) {
+        struct ReplayHeader *h = &opt->replay->header;
+        if (opt->from > h->ticks) return false;
+
+        opt->seed = h->seed, opt->dt = h->dt, opt->asteroids = h->asteroids;
+        if (!opt->steps || (opt->steps > h->ticks - opt->from)) {
+            opt->steps = h->ticks - opt->from;
+        }
+    }
+    else if (!opt->steps) opt->steps = HEADLESS_STEPS;
+
+    return (opt->steps > 0) && (opt->dt > 0);
+}
+
+
+bool headless_run(struct HeadlessOptions *opt, size_t threads, struct HeadlessRun *run)
+{
+    static const unsigned int idle[] = { 0 };
+    struct InputProvider input = (opt->input == SOURCE_RANDOM)
+        ? input_random(opt->seed)
+        : input_script(idle, 1);
+
+    struct State *state = state_create(opt->asteroids, threads);
+    if (!state) return false;
+
+    /* a replay's keyframes carry the solver settings it was recorded with */
+    state->asteroids->bodies->solver.iterations = opt->iterations;
+    if (!opt->replay) state_initialise(state, opt->asteroids, opt->seed);
+    else if (!replay_seek(opt->replay, state, opt->from)) {
+        state_destroy(state);
+        return false;
+    }
+
+    struct Replay *record = NULL;
+    if (opt->record) {
+        record = replay_record(opt->record, opt->seed, opt->dt, opt->asteroids);
+        if (!record) {
+            state_destroy(state);
+            return false;
+        }
+    }
+
+    *run = (struct HeadlessRun) { .workers = state->jobs->num_workers };
+    bool recorded = true;
+    double t0 = timing_now();
+
+    for (size_t step = 0; step < opt->steps; step++) {
+        unsigned int bits = (opt->replay)
+            ? replay_input(opt->replay, opt->from + step)
+            : input_poll(&input);
+        recorded = !record || replay_record_tick(record, state, bits);
+        if (!recorded) break;
+
+        state_update(state, bits, opt->dt);
+        for (size_t p = 0; p < NUM_UPDATE_PHASES; p++) {
+            run->phase_total[p] += state->phase_time[p];
+        }
+        run->dropped += state->grid->contacts_dropped;
+    }
+
+    run->elapsed = timing_now() - t0;
+    run->hash = asteroidqueue_hash(state->asteroids);
+    run->survivors = state->asteroids->pool->len;
+
+    /* a replay cut short keeps its zeroed header, so it cannot be played back */
+    bool ok = recorded && (!record || replay_finish(record));
+    replay_destroy(record);
+    state_destroy(state);
+    return ok;
+}
+
+
+/* false if a run could not be made, or ended in a different state than one thread */
+bool headless_scaling(struct HeadlessOptions *opt, const char *name)
+{
+    struct HeadlessRun base, run;
+    bool agree = true;
+
+    printf(
+        "%-8s %12s %12s %8s  %s\n", "threads", "steps/sec", "ms/step", "speedup", "hash"
+    );
+    for (size_t threads = 1; threads <= opt->scaling; threads *= 2) {
+        if (!headless_run(opt, threads, &run)) {
+            fprintf(stderr, "%s: could not set up or record the run\n", name);
+            return false;
+        }
+        if (threads == 1) base = run;
+        agree = agree && (run.hash == base.hash);
+
+        printf(
+            "%-8zu %12.1f %12.3f %7.2fx  %016llx%s\n",
+            run.workers, opt->steps / run.elapsed, 1e3 * run.elapsed / opt->steps,
+            base.elapsed / run.elapsed, run.hash, (run.hash == base.hash) ? "" : " !"
+        );
+    }
+
+    if (!agree) fprintf(stderr, "%s: threads disagree on the final state\n", name);
+    return agree;
+}
+
+
+int main(int argc, char **argv)
+{
+    struct HeadlessOptions opt = {
+        .steps = 0,
+        .dt = 1.0f / 60,
+        .seed = 1,
+        .asteroids = ASTEROIDS_INITIAL,
+        .input = SOURCE_RANDOM,
+        .threads = 1,
+        .scaling = 0,
+        .iterations = PHYSICS_ITERATIONS
+    };
+    if (!headless_parse(argc, argv, &opt)) {
+        headless_usage(argv[0]);
+        return 1;
+    }
+
+    printf(
+        "%zu steps, dt %g, seed %u, %zu asteroids in %dx%d, %s input\n",
+        opt.steps, opt.dt, opt.seed, opt.asteroids, WORLD_WIDTH, WORLD_HEIGHT,
+        (opt.replay) ? "replayed" : (opt.input == SOURCE_RANDOM) ? "random" : "idle"
+    );
+    if (opt.replay) {
+        printf("from tick %zu of %llu\n", opt.from, opt.replay->header.ticks);
+    }
+
+    if (opt.scaling) {
+        bool ok = headless_scaling(&opt, argv[0]);
+        replay_destroy(opt.replay);
+        return !ok;
+    }
+
+    struct HeadlessRun run;
+    bool ok = headless_run(&opt, opt.threads, &run);
+    replay_destroy(opt.replay);
+    if (!ok) {
+        fprintf(stderr, "%s: could not set up or record the run\n", argv[0]);
+        return 1;
+    }
+
+    printf(
+        "%zu threads, %.1f steps/sec, %.3f ms/step, hash %016llx\n",
+        run.workers, opt.steps / run.elapsed, 1e3 * run.elapsed / opt.steps, run.hash
+    );
+    printf("%zu of %zu asteroids left\n", run.survivors, opt.asteroids);
+    if (run.dropped) printf("%zu contacts dropped, out of memory\n", run.dropped);
+    printf("%-12s %12s %12s %8s\n", "phase", "total ms", "us/step", "share");
+    for (size_t p = 0; p < NUM_UPDATE_PHASES; p++) {
+        printf(
+            "%-12s %12.3f %12.3f %7.1f%%\n",
+            STATE_PHASE_NAME[p],
+            1e3 * run.phase_total[p],
+            1e6 * run.phase_total[p] / opt.steps,
+            100 * run.phase_total[p] / run.elapsed
+        );
+    }
+
+    return 0;
+}
@@ -0,0 +1,106 @@
+/*  input providers
+ *      the simulation only ever sees a set of INPUT_* bits per step, so it can be
+ *      driven by the keyboard, a fixed script or a random generator alike
+ */
+enum INPUT_BIT
+{
+    INPUT_THRUST = 1 << 0,
+    INPUT_REVERSE = 1 << 1,
+    INPUT_LEFT = 1 << 2,
+    INPUT_RIGHT = 1 << 3,
+    INPUT_FIRE = 1 << 4
+};
+
+
+enum INPUT_SOURCE
+{
+    SOURCE_KEYBOARD = 0,
+    SOURCE_SCRIPT,
+    SOURCE_RANDOM,
+    NUM_INPUT_SOURCES
+};
+
+
+struct InputProvider
+{
+    enum INPUT_SOURCE source;
+    unsigned int (*poll)(struct InputProvider *);
+
+    /* script: bits are replayed in order and loop at the end */
+    const unsigned int *script;
+    size_t script_len;
+    size_t tick;
+
+    /* random: xorshift state, and the bits currently held down */
+    unsigned int rng;
+    unsigned int held;
+};
+
+
+unsigned int input_poll(struct InputProvider *provider)
+{
+    if (!provider || !provider->poll) return 0;
+    return provider->poll(provider);
+}
+
+
+unsigned int input_poll_keyboard(struct InputProvider *provider)
+{
+    (void) provider;
+    unsigned int bits = 0;
+
+    if (IsKeyDown(KEY_W) || IsKeyDown(KEY_UP)) bits |= INPUT_THRUST;
+    if (IsKeyDown(KEY_S) || IsKeyDown(KEY_DOWN)) bits |= INPUT_REVERSE;
+    if (IsKeyDown(KEY_A) || IsKeyDown(KEY_LEFT)) bits |= INPUT_LEFT;
+    if (IsKeyDown(KEY_D) || IsKeyDown(KEY_RIGHT)) bits |= INPUT_RIGHT;
+    if (IsKeyDown(KEY_SPACE)) bits |= INPUT_FIRE;
+
+    return bits;
+}
+
+
+unsigned int input_poll_script(struct InputProvider *provider)
+{
+    if (!provider->script || !provider->script_len) return 0;
+    return provider->script[provider->tick++ % provider->script_len];
+}
+
+
+/* hold each random set of bits for a while, as a player would */
+unsigned int input_poll_random(struct InputProvider *provider)
+{
+    unsigned int x = rng_next(&provider->rng);
+
+    if (!(x % 16)) provider->held = (x >> 8) & 0x1f;
+    return provider->held;
+}
+
+
+struct InputProvider input_keyboard(void)
+{
+    return (struct InputProvider) {
+        .source = SOURCE_KEYBOARD,
+        .poll = input_poll_keyboard
+    };
+}
+
+
+struct InputProvider input_script(const unsigned int *script, size_t len)
+{
+    return (struct InputProvider) {
+        .source = SOURCE_SCRIPT,
+        .poll = input_poll_script,
+        .script = script,
+        .script_len = len
+    };
+}
+
+
+struct InputProvider input_random(unsigned int seed)
+{
+    return (struct InputProvider) {
+        .source = SOURCE_RANDOM,
+        .poll = input_poll_random,
+        .rng = rng_seed(seed)
+    };
+}
@@ -3,6 +3,8 @@ struct Player
     Vector2 position;
     Vector2 velocity;
     float rotation;
+    Vector2 prev_position;
+    float prev_rotation;
     float mass;
     float engine;
     float drag;
@@ -29,23 +31,23 @@ struct Player *player_create(void)
 }
 
 
-void player_update_rotation(struct Player *p, float dt)
+void player_update_rotation(struct Player *p, unsigned int input, float dt)
 {
-    if (IsKeyDown(KEY_A) || IsKeyDown(KEY_LEFT)) p->rotation -= dt * 6;
-    if (IsKeyDown(KEY_D) || IsKeyDown(KEY_RIGHT)) p->rotation += dt * 6;
+    if (input & INPUT_LEFT) p->rotation -= dt * 6;
+    if (input & INPUT_RIGHT) p->rotation += dt * 6;
 }
 
 
-void player_update_position(struct Player *player, float dt)
+void player_update_position(struct Player *player, unsigned int input, float dt)
 {
     Vector2 force = { 0, 0 };
 
-    if (IsKeyDown(KEY_W) || IsKeyDown(KEY_UP)) {
+    if (input & INPUT_THRUST) {
         Vector2 df = { cos(player->rotation), sin(player->rotation) };
         force = Vector2Add(force, df);
     }
 
-    if (IsKeyDown(KEY_S) || IsKeyDown(KEY_DOWN)) { 
+    if (input & INPUT_REVERSE) { 
         Vector2 df = { -0.3 * cos(player->rotation), -0.3 * sin(player->rotation) };
         force = Vector2Add(force, df);
     }
@@ -59,15 +61,18 @@ void player_update_position(struct Player *player, float dt)
     player->position = vector2_wrap(
         Vector2Add(player->position, Vector2Scale(player->velocity, dt)),
         (const Vector2) { 0, 0 },
-        (const Vector2) { WINDOW_WIDTH, WINDOW_HEIGHT }
+        (const Vector2) { WORLD_WIDTH, WORLD_HEIGHT }
     );
 }
 
 
-void player_update(struct Player *player, float dt)
+void player_update(struct Player *player, unsigned int input, float dt)
 {
-    player_update_position(player, dt);
-    player_update_rotation(player, dt);
+    player->prev_position = player->position;
+    player->prev_rotation = player->rotation;
+
+    player_update_position(player, input, dt);
+    player_update_rotation(player, input, dt);
 
     if (0 < player->reload) {
         player->reload -= dt;
@@ -76,20 +81,23 @@ void player_update(struct Player *player, float dt)
 }
 
 
-void player_draw(struct Player *p)
+void player_draw(struct Player *p, float alpha, struct RenderBatch *batch)
 {
-    Vector2 offset1 = Vector2Rotate((Vector2){ 12, 0 }, p->rotation);
-    Vector2 offset2 = Vector2Rotate((Vector2){ -6, -6 }, p->rotation);
-    Vector2 offset3 = Vector2Rotate((Vector2){ -3, 0 }, p->rotation);
-    Vector2 offset4 = Vector2Rotate((Vector2){ -6, 6 }, p->rotation);
-
-    Vector2 ver1 = Vector2Add(p->position, offset1);
-    Vector2 ver2 = Vector2Add(p->position, offset2);
-    Vector2 ver3 = Vector2Add(p->position, offset3);
-    Vector2 ver4 = Vector2Add(p->position, offset4);
-
-    DrawTriangle(ver1, ver2, ver3, WHITE);
-    DrawTriangle(ver4, ver1, ver3, WHITE);
+    Vector2 position = vector2_interpolate(p->prev_position, p->position, alpha);
+    float rotation = Lerp(p->prev_rotation, p->rotation, alpha);
+
+    Vector2 offset1 = Vector2Rotate((Vector2){ 12, 0 }, rotation);
+    Vector2 offset2 = Vector2Rotate((Vector2){ -6, -6 }, rotation);
+    Vector2 offset3 = Vector2Rotate((Vector2){ -3, 0 }, rotation);
+    Vector2 offset4 = Vector2Rotate((Vector2){ -6, 6 }, rotation);
+
+    Vector2 ver1 = Vector2Add(position, offset1);
+    Vector2 ver2 = Vector2Add(position, offset2);
+    Vector2 ver3 = Vector2Add(position, offset3);
+    Vector2 ver4 = Vector2Add(position, offset4);
+
+    renderbatch_triangle(batch, ver1, ver2, ver3, WHITE);
+    renderbatch_triangle(batch, ver4, ver1, ver3, WHITE);
 }
 
 
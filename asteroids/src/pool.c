@@ -0,0 +1,282 @@
+#include <limits.h>
+
+/*  entity pool
+ *      bookkeeping shared by the asteroid and bullet queues, whose data stays packed
+ *      in dense arrays [0, len) for the per-step passes. each entity also holds a
+ *      slot for its whole lifetime: a handle names the slot and the generation it was
+ *      issued at, and goes stale once the entity is removed and the slot reused
+ *
+ *      removal only marks an entity dead, so dense indices stay valid for the rest of
+ *      the step; pool_compact then closes the gaps in one ordered pass and returns
+ *      the dead slots to the free list. capacity grows geometrically on demand
+ */
+
+#define POOL_CAPACITY_MIN 16
+#define POOL_NONE ((size_t) -1)
+#define POOL_HANDLE_NONE ((struct PoolHandle) { UINT_MAX, 0 })
+
+
+struct PoolHandle
+{
+    unsigned int slot;
+    unsigned int generation;
+};
+
+
+struct Pool
+{
+    unsigned int *generation;
+    size_t *dense;
+    unsigned int *slot;
+    bool *alive;
+    unsigned int *free_slots;
+    size_t num_free;
+    size_t num_dead;
+    size_t len;
+    size_t max;
+};
+
+
+void pool_destroy(struct Pool *pool)
+{
+    if (!pool) return;
+    if (pool->generation) free(pool->generation);
+    if (pool->dense) free(pool->dense);
+    if (pool->slot) free(pool->slot);
+    if (pool->alive) free(pool->alive);
+    if (pool->free_slots) free(pool->free_slots);
+    free(pool);
+}
+
+
+/* resize one of an owner's arrays, keeping the old one if that fails; owners grow
+ * their arrays before the pool, so the pool's max never exceeds what they hold
+ */
+bool pool_realloc(void **array, size_t size)
+{
+    void *p = realloc(*array, size);
+    if (!p) return false;
+
+    *array = p;
+    return true;
+}
+
+
+/* more slots, up to max; new slots go on the free list lowest first */
+bool pool_grow(struct Pool *pool, size_t max)
+{
+    if (max <= pool->max) return true;
+    if (max > UINT_MAX) return false;
+
+    if (
+        !pool_realloc((void **) &pool->generation, max * sizeof(unsigned int)) ||
+        !pool_realloc((void **) &pool->dense, max * sizeof(size_t)) ||
+        !pool_realloc((void **) &pool->slot, max * sizeof(unsigned int)) ||
+        !pool_realloc((void **) &pool->alive, max * sizeof(bool)) ||
+        !pool_realloc((void **) &pool->free_slots, max * sizeof(unsigned int))
+    ) return false;
+
+    for (size_t s = pool->max; s < max; s++) {
+        pool->generation[s] = 0;
+        pool->dense[s] = POOL_NONE;
+    }
+    for (size_t s = max; s > pool->max; s--) {
+        pool->free_slots[pool->num_free++] = s - 1;
+    }
+    pool->max = max;
+
+    return true;
+}
+
+
+/* max may be 0, for an owner which grows the pool along with its own arrays */
+struct Pool *pool_create(size_t max)
+{
+    struct Pool *pool = malloc(sizeof(struct Pool));
+    if (!pool) return NULL;
+
+    *pool = (struct Pool) { 0 };
+    if (!pool_grow(pool, max)) {
+        pool_destroy(pool);
+        return NULL;
+    }
+
+    return pool;
+}
+
+
+/* capacity to grow to for n more entities, or pool->max if there is room already */
+size_t pool_capacity(struct Pool *pool, size_t n)
+{
+    size_t max = (pool->max) ? pool->max : POOL_CAPACITY_MIN;
+    while (max < pool->len + n) max *= 2;
+    return max;
+}
+
+
+/* take a free slot for a new entity at dense index len; the pool must have room */
+struct PoolHandle pool_insert(struct Pool *pool)
+{
+    if (!pool || (pool->len >= pool->max) || !pool->num_free) return POOL_HANDLE_NONE;
+
+    unsigned int s = pool->free_slots[--pool->num_free];
+    size_t i = pool->len++;
+
+    pool->dense[s] = i;
+    pool->slot[i] = s;
+    pool->alive[i] = true;
+
+    return (struct PoolHandle) { .slot = s, .generation = pool->generation[s] };
+}
+
+
+bool pool_alive(struct Pool *pool, size_t i)
+{
+    return pool && (i < pool->len) && pool->alive[i];
+}
+
+
+/* mark dense index i dead, it stays in place until the next pool_compact */
+void pool_remove(struct Pool *pool, size_t i)
+{
+    if (!pool_alive(pool, i)) return;
+    pool->alive[i] = false;
+    pool->num_dead++;
+}
+
+
+struct PoolHandle pool_handle(struct Pool *pool, size_t i)
+{
+    if (!pool || (i >= pool->len)) return POOL_HANDLE_NONE;
+
+    unsigned int s = pool->slot[i];
+    return (struct PoolHandle) { .slot = s, .generation = pool->generation[s] };
+}
+
+
+/* dense index of the entity a handle names, or POOL_NONE if it has gone */
+size_t pool_find(struct Pool *pool, struct PoolHandle h)
+{
+    if (!pool || (h.slot >= pool->max)) return POOL_NONE;
+    if (pool->generation[h.slot] != h.generation) return POOL_NONE;
+    return pool->dense[h.slot];
+}
+
+
+/* close the gaps left by dead entities, keeping the live ones in order; move copies
+ * the owner's data for dense index from to index to
+ */
+void pool_compact(struct Pool *pool, void (*move)(void *, size_t, size_t), void *ctx)
+{
+    if (!pool || !pool->num_dead) return;
+
+    size_t w = 0;
+    for (size_t r = 0; r < pool->len; r++) {
+        unsigned int s = pool->slot[r];
+
+        if (!pool->alive[r]) {
+            pool->generation[s]++;
+            pool->dense[s] = POOL_NONE;
+            pool->free_slots[pool->num_free++] = s;
+            continue;
+        }
+
+        if (w != r) {
+            move(ctx, r, w);
+            pool->slot[w] = s;
+            pool->alive[w] = true;
+            pool->dense[s] = w;
+        }
+        w++;
+    }
+
+    pool->len = w;
+    pool->num_dead = 0;
+}
+
+
+bool pool_write(struct Pool *pool, FILE *f)
+{
+    return (
+        serial_write(f, &pool->len, sizeof(size_t)) &&
+        serial_write(f, &pool->max, sizeof(size_t)) &&
+        serial_write(f, &pool->num_free, sizeof(size_t)) &&
+        serial_write(f, &pool->num_dead, sizeof(size_t)) &&
+        serial_write(f, pool->generation, pool->max * sizeof(unsigned int)) &&
+        serial_write(f, pool->dense, pool->max * sizeof(size_t)) &&
+        serial_write(f, pool->slot, pool->len * sizeof(unsigned int)) &&
+        serial_write(f, pool->alive, pool->len * sizeof(bool)) &&
+        serial_write(f, pool->free_slots, pool->num_free * sizeof(unsigned int))
+    );
+}
+
+
+/* whether the slots and dense indices name each other, every slot being either in
+ * use or on the free list exactly once, and num_dead counts the dead; free slots are
+ * marked in dense while they are checked, then put back to POOL_NONE
+ */
+bool pool_valid(struct Pool *pool)
+{
+    if (pool->len + pool->num_free != pool->max) return false;
+
+    /* alive is read as bytes, as one from a file may hold neither true nor false */
+    const unsigned char *alive = (const unsigned char *) pool->alive;
+    size_t dead = 0;
+    for (size_t i = 0; i < pool->len; i++) {
+        unsigned int s = pool->slot[i];
+        if ((s >= pool->max) || (pool->dense[s] != i) || (alive[i] > 1)) return false;
+        if (!alive[i]) dead++;
+    }
+    if (dead != pool->num_dead) return false;
+
+    bool ok = true;
+    size_t k = 0;
+    for (; ok && (k < pool->num_free); k++) {
+        unsigned int s = pool->free_slots[k];
+        ok = (s < pool->max) && (pool->dense[s] == POOL_NONE);
+        if (ok) pool->dense[s] = POOL_NONE - 1;
+    }
+    for (size_t m = 0; m < k; m++) {
+        unsigned int s = pool->free_slots[m];
+        if ((s < pool->max) && (pool->dense[s] == POOL_NONE - 1)) {
+            pool->dense[s] = POOL_NONE;
+        }
+    }
+    return ok;
+}
+
+
+/* restore a pool exactly, at the capacity it was written with, rejecting one whose
+ * indices do not hold together; owners then resize their arrays to the new max
+ */
+bool pool_read(struct Pool *pool, FILE *f)
+{
+    size_t len, max, num_free, num_dead;
+    if (
+        !serial_read(f, &len, sizeof(size_t)) ||
+        !serial_read(f, &max, sizeof(size_t)) ||
+        !serial_read(f, &num_free, sizeof(size_t)) ||
+        !serial_read(f, &num_dead, sizeof(size_t)) ||
+        (len > max) || (num_free > max) || (max > UINT_MAX) || !max
+    ) return false;
+
+    if (
+        !pool_realloc((void **) &pool->generation, max * sizeof(unsigned int)) ||
+        !pool_realloc((void **) &pool->dense, max * sizeof(size_t)) ||
+        !pool_realloc((void **) &pool->slot, max * sizeof(unsigned int)) ||
+        !pool_realloc((void **) &pool->alive, max * sizeof(bool)) ||
+        !pool_realloc((void **) &pool->free_slots, max * sizeof(unsigned int))
+    ) return false;
+
+    pool->len = len, pool->max = max;
+    pool->num_free = num_free, pool->num_dead = num_dead;
+
+    return (
+        serial_read(f, pool->generation, max * sizeof(unsigned int)) &&
+        serial_read(f, pool->dense, max * sizeof(size_t)) &&
+        serial_read(f, pool->slot, len * sizeof(unsigned int)) &&
+        serial_read(f, pool->alive, len * sizeof(bool)) &&
+        serial_read(f, pool->free_slots, num_free * sizeof(unsigned int)) &&
+        pool_valid(pool)
+    );
+}
@@ -0,0 +1,196 @@
+#include <stdio.h>
+
+/*  frame profiler
+ *      the phase times of every frame, summed over however many steps it ran, go in a
+ *      ring of the last PROFILER_FRAMES frames along with the draw phase and the whole
+ *      frame's time; the overlay graphs frame time, each bar split by phase, above a
+ *      table of per-phase averages and maxima over the ring
+ *
+ *      the ring can be dumped to csv, oldest frame first, times in milliseconds
+ */
+#define PROFILER_FRAMES 300
+#define PROFILER_FONT "../common/ttf/RobotoMono-Medium.ttf"
+#define PROFILER_CSV "profile.csv"
+#define PROFILER_FONT_SIZE 14
+#define PROFILER_GRAPH_HEIGHT 120
+#define PROFILER_GRAPH_SCALE (2.0 / 60)
+
+
+static const Color PROFILER_PHASE_COLOUR[NUM_STATE_PHASES] = {
+    { 230, 41, 55, 255 },
+    { 255, 161, 0, 255 },
+    { 253, 249, 0, 255 },
+    { 0, 228, 48, 255 },
+    { 0, 121, 241, 255 },
+    { 200, 122, 255, 255 },
+    { 255, 255, 255, 255 }
+};
+
+
+struct ProfileFrame
+{
+    double phase[NUM_STATE_PHASES];
+    double total;
+    size_t steps;
+};
+
+
+struct Profiler
+{
+    struct ProfileFrame frames[PROFILER_FRAMES];
+    size_t count;
+    struct ProfileFrame current;
+    double frame_start;
+    Font font;
+    bool font_loaded;
+    bool visible;
+};
+
+
+void profiler_destroy(struct Profiler *prof)
+{
+    if (!prof) return;
+    if (prof->font_loaded) UnloadFont(prof->font);
+    free(prof);
+}
+
+
+/* the overlay font is loaded here, so the window must be open */
+struct Profiler *profiler_create(void)
+{
+    struct Profiler *prof = malloc(sizeof(struct Profiler));
+    if (!prof) return NULL;
+
+    *prof = (struct Profiler) { .frame_start = timing_now() };
+    prof->font = LoadFontEx(PROFILER_FONT, PROFILER_FONT_SIZE, NULL, 0);
+    prof->font_loaded = (prof->font.texture.id != 0);
+    if (!prof->font_loaded) prof->font = GetFontDefault();
+
+    return prof;
+}
+
+
+/* add one step's update phases to the frame in progress */
+void profiler_step(struct Profiler *prof, const double *phase_time)
+{
+    if (!prof) return;
+    for (size_t p = 0; p < NUM_UPDATE_PHASES; p++) {
+        prof->current.phase[p] += phase_time[p];
+    }
+    prof->current.steps++;
+}
+
+
+/* close the frame in progress with its draw phase, and start the next */
+void profiler_frame(struct Profiler *prof, const double *phase_time)
+{
+    if (!prof) return;
+
+    double now = timing_now();
+    prof->current.phase[PHASE_DRAW] = phase_time[PHASE_DRAW];
+    prof->current.total = now - prof->frame_start;
+
+    prof->frames[prof->count++ % PROFILER_FRAMES] = prof->current;
+    prof->current = (struct ProfileFrame) { 0 };
+    prof->frame_start = now;
+}
+
+
+size_t profiler_len(struct Profiler *prof)
+{
+    return (prof->count < PROFILER_FRAMES) ? prof->count : PROFILER_FRAMES;
+}
+
+
+/* kth oldest frame in the ring */
+struct ProfileFrame *profiler_at(struct Profiler *prof, size_t k)
+{
+    size_t first = prof->count - profiler_len(prof);
+    return prof->frames + (first + k) % PROFILER_FRAMES;
+}
+
+
+bool profiler_dump(struct Profiler *prof, const char *path)
+{
+    if (!prof) return false;
+
+    FILE *f = fopen(path, "w");
+    if (!f) return false;
+
+    fprintf(f, "frame,steps");
+    for (size_t p = 0; p < NUM_STATE_PHASES; p++) {
+        fprintf(f, ",%s", STATE_PHASE_NAME[p]);
+    }
+    fprintf(f, ",total\n");
+
+    size_t len = profiler_len(prof), first = prof->count - len;
+    for (size_t k = 0; k < len; k++) {
+        struct ProfileFrame *frame = profiler_at(prof, k);
+        fprintf(f, "%zu,%zu", first + k, frame->steps);
+        for (size_t p = 0; p < NUM_STATE_PHASES; p++) {
+            fprintf(f, ",%.4f", 1e3 * frame->phase[p]);
+        }
+        fprintf(f, ",%.4f\n", 1e3 * frame->total);
+    }
+
+    return !fclose(f);
+}
+
+
+void profiler_text(struct Profiler *prof, const char *text, float x, float y, Color c)
+{
+    DrawTextEx(prof->font, text, (Vector2) { x, y }, PROFILER_FONT_SIZE, 0, c);
+}
+
+
+/* graph in the bottom left corner, a bar per frame scaled so the top is two 60Hz
+ * frames, with a line at one; time outside the phases (vsync, input) is grey. the
+ * table sits above it
+ */
+void profiler_draw(struct Profiler *prof)
+{
+    if (!prof || !prof->visible) return;
+
+    size_t len = profiler_len(prof);
+    float x0 = 8, y0 = WINDOW_HEIGHT - 8, h = PROFILER_GRAPH_HEIGHT, top = y0 - h;
+    DrawRectangle(x0, top, PROFILER_FRAMES, h, (Color) { 0, 0, 0, 160 });
+
+    double mean[NUM_STATE_PHASES + 1] = { 0 }, max[NUM_STATE_PHASES + 1] = { 0 };
+    for (size_t k = 0; k < len; k++) {
+        struct ProfileFrame *frame = profiler_at(prof, k);
+        float x = x0 + PROFILER_FRAMES - len + k, y = y0;
+
+        for (size_t p = 0; p < NUM_STATE_PHASES; p++) {
+            float dy = fminf(h * frame->phase[p] / PROFILER_GRAPH_SCALE, y - top);
+            DrawLine(x, y, x, y - dy, PROFILER_PHASE_COLOUR[p]);
+            y -= dy;
+
+            mean[p] += frame->phase[p];
+            if (frame->phase[p] > max[p]) max[p] = frame->phase[p];
+        }
+        float y_total = y0 - h * frame->total / PROFILER_GRAPH_SCALE;
+        if (y_total < y) DrawLine(x, y, x, fmaxf(y_total, top), GRAY);
+
+        mean[NUM_STATE_PHASES] += frame->total;
+        if (frame->total > max[NUM_STATE_PHASES]) max[NUM_STATE_PHASES] = frame->total;
+    }
+    DrawLine(x0, y0 - h / 2, x0 + PROFILER_FRAMES, y0 - h / 2, WHITE);
+
+    float y = top - (NUM_STATE_PHASES + 2) * PROFILER_FONT_SIZE;
+    profiler_text(
+        prof, TextFormat("%-11s %8s %8s", "ms", "mean", "max"), x0, y, WHITE
+    );
+    for (size_t p = 0; p <= NUM_STATE_PHASES; p++) {
+        y += PROFILER_FONT_SIZE;
+        double n = (len) ? len : 1;
+        profiler_text(
+            prof,
+            TextFormat(
+                "%-11s %8.3f %8.3f",
+                (p < NUM_STATE_PHASES) ? STATE_PHASE_NAME[p] : "frame",
+                1e3 * mean[p] / n, 1e3 * max[p]
+            ),
+            x0, y, (p < NUM_STATE_PHASES) ? PROFILER_PHASE_COLOUR[p] : GRAY
+        );
+    }
+}
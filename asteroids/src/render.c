@@ -0,0 +1,153 @@
+#include <rlgl.h>
+
+/*  batched vector renderer
+ *      outlines, points and filled triangles are gathered for the whole frame into
+ *      two vertex buffers (lines, triangles) and submitted through rlgl in large
+ *      chunks, instead of one immediate-mode raylib call per shape
+ *
+ *      debug toggles the overlays (centre dots, velocity vectors, counters)
+ */
+
+#define RENDERBATCH_CHUNK 4096
+#define RENDERBATCH_POINT_SIZE 2.0f
+
+
+struct RenderVertex
+{
+    Vector2 position;
+    Color colour;
+};
+
+
+struct RenderBuffer
+{
+    struct RenderVertex *vertices;
+    size_t len;
+    size_t max;
+};
+
+
+struct RenderBatch
+{
+    struct RenderBuffer lines;
+    struct RenderBuffer triangles;
+    bool debug;
+};
+
+
+void renderbatch_destroy(struct RenderBatch *batch)
+{
+    if (!batch) return;
+    if (batch->lines.vertices) free(batch->lines.vertices);
+    if (batch->triangles.vertices) free(batch->triangles.vertices);
+    free(batch);
+}
+
+
+struct RenderBatch *renderbatch_create(void)
+{
+    struct RenderBatch *batch = malloc(sizeof(struct RenderBatch));
+    if (!batch) return NULL;
+
+    *batch = (struct RenderBatch) { 0 };
+    return batch;
+}
+
+
+/* room for n more vertices, growing geometrically */
+bool renderbuffer_reserve(struct RenderBuffer *buf, size_t n)
+{
+    if (buf->len + n <= buf->max) return true;
+
+    size_t max = (buf->max) ? buf->max : RENDERBATCH_CHUNK;
+    while (max < buf->len + n) max *= 2;
+
+    struct RenderVertex *vertices = realloc(
+        buf->vertices, max * sizeof(struct RenderVertex)
+    );
+    if (!vertices) return false;
+
+    buf->vertices = vertices;
+    buf->max = max;
+    return true;
+}
+
+
+void renderbuffer_push(struct RenderBuffer *buf, Vector2 p, Color c)
+{
+    buf->vertices[buf->len++] = (struct RenderVertex) { .position = p, .colour = c };
+}
+
+
+void renderbatch_line(struct RenderBatch *batch, Vector2 v0, Vector2 v1, Color c)
+{
+    if (!renderbuffer_reserve(&batch->lines, 2)) return;
+    renderbuffer_push(&batch->lines, v0, c);
+    renderbuffer_push(&batch->lines, v1, c);
+}
+
+
+/* closed outline through n vertices */
+void renderbatch_outline(struct RenderBatch *batch, Vector2 *v, size_t n, Color c)
+{
+    if (!n || !renderbuffer_reserve(&batch->lines, 2*n)) return;
+    for (size_t k = 0; k < n; k++) {
+        renderbuffer_push(&batch->lines, v[k], c);
+        renderbuffer_push(&batch->lines, v[(k + 1) % n], c);
+    }
+}
+
+
+/* v0, v1, v2 anticlockwise on screen, as for DrawTriangle */
+void renderbatch_triangle
+(
+    struct RenderBatch *batch, Vector2 v0, Vector2 v1, Vector2 v2, Color c
+)
+{
+    if (!renderbuffer_reserve(&batch->triangles, 3)) return;
+    renderbuffer_push(&batch->triangles, v0, c);
+    renderbuffer_push(&batch->triangles, v1, c);
+    renderbuffer_push(&batch->triangles, v2, c);
+}
+
+
+/* a small square centred on p */
+void renderbatch_point(struct RenderBatch *batch, Vector2 p, float size, Color c)
+{
+    float h = size / 2;
+    Vector2 tl = { p.x - h, p.y - h }, tr = { p.x + h, p.y - h };
+    Vector2 bl = { p.x - h, p.y + h }, br = { p.x + h, p.y + h };
+
+    renderbatch_triangle(batch, tl, bl, tr, c);
+    renderbatch_triangle(batch, tr, bl, br, c);
+}
+
+
+/* submit a buffer in chunks of whole primitives of the given size */
+void renderbuffer_flush(struct RenderBuffer *buf, int mode, size_t primitive)
+{
+    size_t chunk = RENDERBATCH_CHUNK - (RENDERBATCH_CHUNK % primitive);
+
+    for (size_t start = 0; start < buf->len; start += chunk) {
+        size_t end = (start + chunk < buf->len) ? start + chunk : buf->len;
+
+        rlCheckRenderBatchLimit((int) (end - start));
+        rlBegin(mode);
+        for (size_t k = start; k < end; k++) {
+            struct RenderVertex *v = buf->vertices + k;
+            rlColor4ub(v->colour.r, v->colour.g, v->colour.b, v->colour.a);
+            rlVertex2f(v->position.x, v->position.y);
+        }
+        rlEnd();
+    }
+
+    buf->len = 0;
+}
+
+
+void renderbatch_flush(struct RenderBatch *batch)
+{
+    if (!batch) return;
+    renderbuffer_flush(&batch->triangles, RL_TRIANGLES, 3);
+    renderbuffer_flush(&batch->lines, RL_LINES, 2);
+}
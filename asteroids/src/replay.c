@@ -0,0 +1,216 @@
+/*  replays
+ *      a game is fixed by its seed, dt and asteroid count and the input bits of each
+ *      tick; a replay records those, plus a keyframe of the whole state every
+ *      REPLAY_KEYFRAME_INTERVAL ticks, so playback can start at any tick by restoring
+ *      the keyframe at or before it and simulating less than an interval forward
+ *
+ *      file layout:
+ *          header      struct ReplayHeader, written once recording finishes and
+ *                      zeroes until then, so an unfinished replay never opens
+ *          keyframes   state_write records, at the offsets held by the index
+ *          inputs      one byte of INPUT_* bits per tick
+ *          index       struct ReplayKeyframe per keyframe, in tick order
+ *
+ *      keyframes are native byte order (see serial.c), so a replay plays back on the
+ *      build that recorded it, and only with the same world size
+ */
+#define REPLAY_MAGIC 0x31525341u
+#define REPLAY_VERSION 4
+#define REPLAY_KEYFRAME_INTERVAL 600
+#define REPLAY_CAPACITY_MIN 1024
+
+
+struct ReplayHeader
+{
+    unsigned int magic;
+    unsigned int version;
+    unsigned int seed;
+    unsigned int world_width;
+    unsigned int world_height;
+    float dt;
+    unsigned long long asteroids;
+    unsigned long long interval;
+    unsigned long long ticks;
+    unsigned long long num_keyframes;
+    long long inputs;
+    long long index;
+};
+
+
+struct ReplayKeyframe
+{
+    unsigned long long tick;
+    long long offset;
+};
+
+
+struct Replay
+{
+    FILE *file;
+    struct ReplayHeader header;
+    unsigned char *inputs;
+    struct ReplayKeyframe *keyframes;
+    size_t max_inputs;
+    size_t max_keyframes;
+};
+
+
+void replay_destroy(struct Replay *r)
+{
+    if (!r) return;
+    if (r->file) fclose(r->file);
+    if (r->inputs) free(r->inputs);
+    if (r->keyframes) free(r->keyframes);
+    free(r);
+}
+
+
+/* start recording a game initialised with seed to path */
+struct Replay *replay_record
+(
+    const char *path, unsigned int seed, float dt, size_t asteroids
+)
+{
+    struct Replay *r = malloc(sizeof(struct Replay));
+    if (!r) return NULL;
+
+    *r = (struct Replay) {
+        .header = {
+            .magic = REPLAY_MAGIC,
+            .version = REPLAY_VERSION,
+            .seed = seed,
+            .world_width = WORLD_WIDTH,
+            .world_height = WORLD_HEIGHT,
+            .dt = dt,
+            .asteroids = asteroids,
+            .interval = REPLAY_KEYFRAME_INTERVAL
+        }
+    };
+    struct ReplayHeader unfinished = { 0 };
+    r->file = fopen(path, "wb");
+    if (!r->file || !serial_write(r->file, &unfinished, sizeof(struct ReplayHeader))) {
+        replay_destroy(r);
+        return NULL;
+    }
+
+    return r;
+}
+
+
+/* record the input for the next tick, given the state just before it is stepped */
+bool replay_record_tick(struct Replay *r, struct State *state, unsigned int bits)
+{
+    struct ReplayHeader *h = &r->header;
+
+    if (!(h->ticks % h->interval)) {
+        if (h->num_keyframes == r->max_keyframes) {
+            size_t max = (r->max_keyframes) ? 2 * r->max_keyframes : 16;
+            void *p = realloc(r->keyframes, max * sizeof(struct ReplayKeyframe));
+            if (!p) return false;
+            r->keyframes = p, r->max_keyframes = max;
+        }
+
+        r->keyframes[h->num_keyframes++] = (struct ReplayKeyframe) {
+            .tick = h->ticks, .offset = ftell(r->file)
+        };
+        if (!state_write(state, r->file)) return false;
+    }
+
+    if (h->ticks == r->max_inputs) {
+        size_t max = (r->max_inputs) ? 2 * r->max_inputs : REPLAY_CAPACITY_MIN;
+        void *p = realloc(r->inputs, max);
+        if (!p) return false;
+        r->inputs = p, r->max_inputs = max;
+    }
+    r->inputs[h->ticks++] = bits;
+
+    return true;
+}
+
+
+/* write out the inputs and index after the last keyframe, and the final header */
+bool replay_finish(struct Replay *r)
+{
+    struct ReplayHeader *h = &r->header;
+
+    h->inputs = ftell(r->file);
+    if (!serial_write(r->file, r->inputs, h->ticks)) return false;
+
+    h->index = ftell(r->file);
+    size_t index_size = h->num_keyframes * sizeof(struct ReplayKeyframe);
+    if (!serial_write(r->file, r->keyframes, index_size)) return false;
+
+    return (
+        !fseek(r->file, 0, SEEK_SET) &&
+        serial_write(r->file, h, sizeof(struct ReplayHeader)) &&
+        !fflush(r->file)
+    );
+}
+
+
+/* a finished replay for playback, with its inputs and index read in whole */
+struct Replay *replay_open(const char *path)
+{
+    struct Replay *r = malloc(sizeof(struct Replay));
+    if (!r) return NULL;
+
+    *r = (struct Replay) { 0 };
+    r->file = fopen(path, "rb");
+    struct ReplayHeader *h = &r->header;
+    if (
+        !r->file || !serial_read(r->file, h, sizeof(struct ReplayHeader)) ||
+        (h->magic != REPLAY_MAGIC) || (h->version != REPLAY_VERSION) ||
+        (h->world_width != WORLD_WIDTH) || (h->world_height != WORLD_HEIGHT) ||
+        !h->num_keyframes || !h->interval || !(h->dt > 0)
+    ) {
+        replay_destroy(r);
+        return NULL;
+    }
+
+    r->max_inputs = h->ticks, r->max_keyframes = h->num_keyframes;
+    r->inputs = malloc(h->ticks + 1);
+    r->keyframes = malloc(h->num_keyframes * sizeof(struct ReplayKeyframe));
+    size_t index_size = h->num_keyframes * sizeof(struct ReplayKeyframe);
+    if (
+        !r->inputs || !r->keyframes ||
+        fseek(r->file, h->inputs, SEEK_SET) ||
+        !serial_read(r->file, r->inputs, h->ticks) ||
+        fseek(r->file, h->index, SEEK_SET) ||
+        !serial_read(r->file, r->keyframes, index_size)
+    ) {
+        replay_destroy(r);
+        return NULL;
+    }
+
+    return r;
+}
+
+
+/* input bits for tick, none past the end of the recording */
+unsigned int replay_input(struct Replay *r, size_t tick)
+{
+    return (tick < r->header.ticks) ? r->inputs[tick] : 0;
+}
+
+
+/* put state (created but not initialised) at the start of tick: restore the last
+ * keyframe at or before it and step forward through the recorded inputs
+ */
+bool replay_seek(struct Replay *r, struct State *state, size_t tick)
+{
+    struct ReplayHeader *h = &r->header;
+    if (tick > h->ticks) return false;
+
+    size_t k = tick / h->interval;
+    if (k >= h->num_keyframes) k = h->num_keyframes - 1;
+    struct ReplayKeyframe kf = r->keyframes[k];
+
+    if (fseek(r->file, kf.offset, SEEK_SET) || !state_read(state, r->file)) {
+        return false;
+    }
+    for (size_t t = kf.tick; t < tick; t++) {
+        state_update(state, replay_input(r, t), h->dt);
+    }
+
+    return true;
+}
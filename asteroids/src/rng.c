@@ -0,0 +1,18 @@
+/*  random numbers
+ *      xorshift32 with the state carried explicitly by its owner, so that a seed alone
+ *      fixes everything drawn from it (state spawns, scripted input, the shape library)
+ */
+
+
+unsigned int rng_seed(unsigned int seed)
+{
+    return (seed) ? seed : 1;
+}
+
+
+unsigned int rng_next(unsigned int *rng)
+{
+    unsigned int x = *rng;
+    x ^= x << 13, x ^= x >> 17, x ^= x << 5;
+    return (*rng = x);
+}
@@ -0,0 +1,18 @@
+#include <stdio.h>
+
+/*  keyframe serialisation
+ *      modules write their own state as raw arrays, in native byte order and layout;
+ *      keyframes are for replaying on the build that recorded them, not interchange
+ */
+
+
+bool serial_write(FILE *f, const void *p, size_t size)
+{
+    return !size || (fwrite(p, size, 1, f) == 1);
+}
+
+
+bool serial_read(FILE *f, void *p, size_t size)
+{
+    return !size || (fread(p, size, 1, f) == 1);
+}
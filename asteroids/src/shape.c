@@ -0,0 +1,238 @@
+#include <raylib.h>
+#include <raymath.h>
+
+enum ASTEROID_LEVEL
+{
+    LEVEL0 = 0,
+    LEVEL1,
+    LEVEL2,
+    NUM_ASTEROID_LEVELS
+};
+
+
+static const size_t ASTEROIDLEVEL_NUM_CORNERS[NUM_ASTEROID_LEVELS] = { 3, 4, 6 };
+static const Color  ASTEROIDLEVEL_COLOUR[NUM_ASTEROID_LEVELS] = {
+    { 255, 255, 255, 255 },
+    { 255, 255, 255, 255 },
+    { 255, 255, 255, 255 }
+};
+static const float ASTEROIDLEVEL_RADIUS[NUM_ASTEROID_LEVELS] = { 12.0f, 18.0f, 24.0f };
+/* how far in, as a fraction of the radius, alternate corners may be dented */
+static const float ASTEROIDLEVEL_DENT[NUM_ASTEROID_LEVELS] = { 0, 0, 0.6f };
+static const float ASTEROIDLEVEL_MASS[NUM_ASTEROID_LEVELS] = { 144.0f, 324.0f, 576.0f };
+static const float ASTEROIDLEVEL_MOI[NUM_ASTEROID_LEVELS] = {
+    12.0f * 12.0f * 144.0f / (3 + 1),
+    18.0f * 18.0f * 324.0f / (4 + 1),
+    24.0f * 24.0f * 324.0f / (6 + 1)
+};
+
+
+/*  shape library
+ *      a fixed set of prototype outlines per level, generated once at startup with
+ *      their centroid, mass properties and bounding radius; asteroids refer to a
+ *      prototype by index and carry only their own transform and state
+ *
+ *      the outlines come from their own generator with a fixed seed, so the library is
+ *      the same on every run whatever the state's seed
+ *
+ *      outlines may be concave (the largest level's are dented), so each is also cut
+ *      once into convex pieces, with a bounding circle apiece, for the narrowphase;
+ *      the mass properties hold for any simple outline and come from it whole
+ */
+#define SHAPELIBRARY_PROTOTYPES 256
+#define SHAPELIBRARY_SEED 0x9e3779b9u
+
+
+/* a convex piece of an outline, as indices into its corners, anticlockwise, and the
+ * circle about it in the body frame
+ */
+struct AsteroidPiece
+{
+    unsigned char corners[ASTEROID_VERTICES_MAX];
+    size_t num_corners;
+    Vector2 centre;
+    float radius;
+};
+
+
+struct AsteroidPrototype
+{
+    Vector2 corners[ASTEROID_VERTICES_MAX];
+    Vector2 centroid;
+    size_t num_corners;
+    struct AsteroidPiece pieces[ASTEROID_PIECES_MAX];
+    size_t num_pieces;
+    enum ASTEROID_LEVEL level;
+    float radius;
+    float mass;
+    float inv_mass;
+    float moi;
+    float inv_moi;
+};
+
+
+struct ShapeLibrary
+{
+    struct AsteroidPrototype *prototypes;
+    size_t per_level;
+};
+
+
+/* convex pieces of the corners and their circles; an outline which cannot be cut
+ * (never one from asteroidprototype_randomise) is left whole as a single piece
+ */
+void asteroidprototype_decompose(struct AsteroidPrototype *proto)
+{
+    unsigned char pieces[ASTEROID_VERTICES_MAX][ASTEROID_VERTICES_MAX];
+    size_t sizes[ASTEROID_VERTICES_MAX];
+    size_t num = polygon_decompose(proto->corners, proto->num_corners, pieces, sizes);
+    if (!num) {
+        num = 1, sizes[0] = proto->num_corners;
+        for (size_t k = 0; k < proto->num_corners; k++) pieces[0][k] = k;
+    }
+
+    proto->num_pieces = num;
+    for (size_t p = 0; p < num; p++) {
+        struct AsteroidPiece *piece = proto->pieces + p;
+        *piece = (struct AsteroidPiece) { .num_corners = sizes[p] };
+
+        for (size_t k = 0; k < sizes[p]; k++) {
+            piece->corners[k] = pieces[p][k];
+            piece->centre = Vector2Add(piece->centre, proto->corners[pieces[p][k]]);
+        }
+        piece->centre = Vector2Scale(piece->centre, 1.0f / sizes[p]);
+
+        for (size_t k = 0; k < sizes[p]; k++) {
+            Vector2 d = Vector2Subtract(proto->corners[pieces[p][k]], piece->centre);
+            piece->radius = fmaxf(piece->radius, Vector2Length(d));
+        }
+    }
+}
+
+
+/* corners about the centroid, anticlockwise, and the mass properties they imply */
+void asteroidprototype_initialise
+(
+    struct AsteroidPrototype *proto, enum ASTEROID_LEVEL level, Vector2 *vertices,
+    size_t n
+)
+{
+    *proto = (struct AsteroidPrototype) { .num_corners = n, .level = level };
+
+    /* the narrowphase expects anticlockwise corners, reverse them if not */
+    float signed_area = 0;
+    for (size_t i = 0; i < n; i++) {
+        signed_area += vector2_cross(vertices[i], vertices[(i+1) % n]);
+    }
+    bool reverse = (signed_area < 0);
+
+    /* centroid and effective positions of corners */
+    proto->centroid = polygon_area_moment_1(vertices, n);
+    for (size_t i = 0; i < n; i++) {
+        Vector2 v = vertices[(reverse) ? n - 1 - i : i];
+        proto->corners[i] = vector2_diff(v, proto->centroid);
+        if (Vector2Length(proto->corners[i]) > proto->radius) {
+            proto->radius = Vector2Length(proto->corners[i]);
+        }
+    }
+
+    /* area and mass */
+    float area = polygon_area_moment_0(proto->corners, n);
+    proto->mass = area * ASTEROID_DENSITY;
+    proto->inv_mass = 1 / proto->mass;
+
+    /* moment of inertia: the second moment is per unit area, about the centroid */
+    proto->moi = proto->mass * polygon_area_moment_2(proto->corners, n);
+    proto->inv_moi = 1 / proto->moi;
+
+    asteroidprototype_decompose(proto);
+}
+
+
+/* corners on the level's circle, each jittered forward by up to half a step; on a
+ * dented level every other corner is pulled in, half the time
+ */
+void asteroidprototype_randomise
+(
+    struct AsteroidPrototype *proto, enum ASTEROID_LEVEL level, unsigned int *rng
+)
+{
+    size_t num_corners = ASTEROIDLEVEL_NUM_CORNERS[level];
+    Vector2 corners[ASTEROID_VERTICES_MAX];
+
+    float radius = ASTEROIDLEVEL_RADIUS[level];
+    float angle_step = (2 * PI) / num_corners;
+    float angle_delta = 0;
+    for (size_t i = 0; i < num_corners; i++) {
+        size_t jitter = rng_next(rng) % (2*num_corners);
+        angle_delta = jitter * angle_step / (2.0f*num_corners);
+        float r = radius;
+        if ((ASTEROIDLEVEL_DENT[level] > 0) && (i % 2) && (rng_next(rng) % 2)) {
+            r *= 1 - ASTEROIDLEVEL_DENT[level];
+        }
+        corners[i] = (Vector2) {
+            r * cos(i*angle_step + angle_delta), r * sin(i*angle_step + angle_delta)
+        };
+    }
+    asteroidprototype_initialise(proto, level, corners, num_corners);
+}
+
+
+void shapelibrary_destroy(struct ShapeLibrary *lib)
+{
+    if (!lib) return;
+    if (lib->prototypes) free(lib->prototypes);
+    free(lib);
+}
+
+
+struct ShapeLibrary *shapelibrary_create(size_t per_level)
+{
+    struct ShapeLibrary *lib = malloc(sizeof(struct ShapeLibrary));
+    if (!lib) return NULL;
+
+    if (!per_level) per_level = SHAPELIBRARY_PROTOTYPES;
+    lib->per_level = per_level;
+    lib->prototypes = malloc(
+        NUM_ASTEROID_LEVELS * per_level * sizeof(struct AsteroidPrototype)
+    );
+    if (!lib->prototypes) {
+        shapelibrary_destroy(lib);
+        return NULL;
+    }
+
+    unsigned int rng = SHAPELIBRARY_SEED;
+    for (size_t level = 0; level < NUM_ASTEROID_LEVELS; level++) {
+        for (size_t k = 0; k < per_level; k++) {
+            asteroidprototype_randomise(
+                lib->prototypes + level * per_level + k, level, &rng
+            );
+        }
+    }
+
+    return lib;
+}
+
+
+/* the outline edge which edge k of piece p lies along, or num_corners if the piece
+ * edge is a diagonal inside the outline
+ */
+size_t asteroidprototype_piece_edge
+(
+    const struct AsteroidPrototype *proto, size_t p, size_t k
+)
+{
+    const struct AsteroidPiece *piece = proto->pieces + p;
+    size_t c0 = piece->corners[k], c1 = piece->corners[(k + 1) % piece->num_corners];
+    return (c1 == (c0 + 1) % proto->num_corners) ? c0 : proto->num_corners;
+}
+
+
+/* index of the kth prototype of a level */
+size_t shapelibrary_index
+(
+    const struct ShapeLibrary *lib, enum ASTEROID_LEVEL level, size_t k
+)
+{
+    return level * lib->per_level + (k % lib->per_level);
+}
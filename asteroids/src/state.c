@@ -6,6 +6,13 @@ struct State
     struct Player *player;
     struct BulletQueue *bullets;
     struct AsteroidQueue *asteroids;
+    struct ShapeLibrary *shapes;
+    struct AsteroidGrid *grid;
+    struct RenderBatch *render;
+    struct JobPool *jobs;
+    Camera2D camera;
+    unsigned int rng;
+    double phase_time[NUM_STATE_PHASES];
 };
 
 
@@ -15,20 +22,42 @@ void state_destroy(struct State *state)
     if (state->player) player_destroy(state->player);
     if (state->bullets) bulletqueue_destroy(state->bullets);
     if (state->asteroids) asteroidqueue_destroy(state->asteroids);
+    if (state->shapes) shapelibrary_destroy(state->shapes);
+    if (state->grid) asteroidgrid_destroy(state->grid);
+    if (state->render) renderbatch_destroy(state->render);
+    if (state->jobs) jobs_destroy(state->jobs);
     free(state);
 }
 
 
-struct State *state_create(void)
+/* room for num_asteroids to begin with (the queues grow), and num_workers threads
+ * (counting the caller) sharing collision detection, 0 for one per cpu; results do
+ * not depend on it
+ */
+struct State *state_create(size_t num_asteroids, size_t num_workers)
 {
     struct State *state = malloc(sizeof(struct State));
     if (!state) return NULL;
 
-    state->player = player_create();
-    state->bullets = bulletqueue_create(BULLETQUEUE_LEN_MAX);
-    state->asteroids = asteroidqueue_create(ASTEROIDQUEUE_LEN_MAX);
+    *state = (struct State) { 0 };
+    state->jobs = jobs_create(num_workers);
+    state->shapes = shapelibrary_create(SHAPELIBRARY_PROTOTYPES);
+    if (!state->jobs || !state->shapes) {
+        state_destroy(state);
+        return NULL;
+    }
 
-    if (!state->player || !state->bullets || !state->asteroids) {
+    state->player = player_create();
+    state->bullets = bulletqueue_create(BULLETQUEUE_CAPACITY);
+    state->asteroids = asteroidqueue_create(num_asteroids, state->shapes);
+    state->grid = asteroidgrid_create(num_asteroids, state->jobs->num_workers);
+    state->render = renderbatch_create();
+    for (size_t p = 0; p < NUM_STATE_PHASES; p++) state->phase_time[p] = 0;
+
+    if (
+        !state->player || !state->bullets || !state->asteroids || !state->grid ||
+        !state->render
+    ) {
         state_destroy(state);
         return NULL;
     }
@@ -37,43 +66,148 @@ struct State *state_create(void)
 }
 
 
-void state_initialise(struct State *state)
+/* everything random about a game follows from seed */
+void state_initialise(struct State *state, size_t num_asteroids, unsigned int seed)
 {
+    state->rng = rng_seed(seed);
+
     *(state->player) = (struct Player) { 
-        .position = (Vector2){ WINDOW_WIDTH / 2, WINDOW_HEIGHT / 2},
+        .position = (Vector2){ WORLD_WIDTH / 2, WORLD_HEIGHT / 2},
         .rotation = 0,
+        .prev_position = (Vector2){ WORLD_WIDTH / 2, WORLD_HEIGHT / 2},
+        .prev_rotation = 0,
         .mass = 0.33,
         .engine = 100,
         .drag = 0.003
     };
 
-    size_t N = 24;
-    for (size_t i = 0; i < N; i++) {
-        struct Asteroid *a = state->asteroids->asteroids + i;
-        asteroid_randomise(a);
-        state->asteroids->len = N;
+    for (size_t i = 0; i < num_asteroids; i++) {
+        struct Asteroid a;
+        asteroid_randomise(&a, state->shapes, &state->rng);
+        asteroidqueue_insert(state->asteroids, a);
     }
+    asteroidgrid_build(state->grid, state->asteroids, 0);
 }
 
 
-void state_draw(struct State *state)
+/* a keyframe: everything state_update reads and writes between steps; the grid,
+ * render batch and jobs are rebuilt or refilled every step, so they are left out
+ */
+bool state_write(struct State *state, FILE *f)
 {
-    asteroidqueue_draw(state->asteroids);
-    bulletqueue_draw(state->bullets);
-    player_draw(state->player);
+    return (
+        serial_write(f, &state->rng, sizeof(unsigned int)) &&
+        serial_write(f, state->player, sizeof(struct Player)) &&
+        asteroidqueue_write(state->asteroids, f) &&
+        bulletqueue_write(state->bullets, f)
+    );
 }
 
 
-void state_update(struct State *state, float dt)
+/* restore a keyframe written by state_write, in place of state_initialise */
+bool state_read(struct State *state, FILE *f)
 {
+    bool ok = (
+        serial_read(f, &state->rng, sizeof(unsigned int)) &&
+        serial_read(f, state->player, sizeof(struct Player)) &&
+        asteroidqueue_read(state->asteroids, f) &&
+        bulletqueue_read(state->bullets, f)
+    );
+    if (ok) asteroidgrid_build(state->grid, state->asteroids, 0);
+    return ok;
+}
+
+
+/* broadphase and narrowphase counters for the last step */
+void state_draw_debug(struct State *state)
+{
+    DrawText(
+        TextFormat(
+            "pairs %zu / %zu, %zu swept, %zu contacts dropped",
+            state->grid->pairs_collided, state->grid->pairs_tested,
+            state->grid->pairs_swept, state->grid->contacts_dropped
+        ),
+        8, 8, 10, WHITE
+    );
+    DrawText(
+        TextFormat(
+            "sat cache %zu / %zu", state->asteroids->satcache_stats.hits,
+            state->asteroids->satcache_stats.tests
+        ),
+        8, 20, 10, WHITE
+    );
+    DrawText(
+        TextFormat(
+            "drawn %zu / %zu", state->grid->drawn, state->asteroids->pool->len
+        ),
+        8, 32, 10, WHITE
+    );
+}
+
+
+/* draw alpha of the way between the previous and the current step, through a camera
+ * centred on the player; only what the grid and the bullets' own test find in view
+ * reaches the render batch, so the cost follows the view and not the world
+ */
+void state_draw(struct State *state, float alpha)
+{
+    double t = timing_now();
+
+    struct Player *p = state->player;
+    Vector2 target = vector2_interpolate(p->prev_position, p->position, alpha);
+    Vector2 half = { WINDOW_WIDTH / 2.0f, WINDOW_HEIGHT / 2.0f };
+    Rectangle view = {
+        target.x - half.x, target.y - half.y, WINDOW_WIDTH, WINDOW_HEIGHT
+    };
+    state->camera = (Camera2D) { .offset = half, .target = target, .zoom = 1 };
+
+    BeginMode2D(state->camera);
+    asteroidgrid_draw(state->grid, state->asteroids, view, alpha, state->render);
+    bulletqueue_draw(state->bullets, view, alpha, state->render);
+    player_draw(state->player, alpha, state->render);
+    renderbatch_flush(state->render);
+    EndMode2D();
+
+    if (state->render->debug) state_draw_debug(state);
+    state->phase_time[PHASE_DRAW] = timing_now() - t;
+}
+
+
+void state_update(struct State *state, unsigned int input, float dt)
+{
+    double *phase_time = state->phase_time;
+    double t = timing_now(), t_prev = t;
+
     asteroidqueue_update(state->asteroids, dt);
+    t = timing_now(), phase_time[PHASE_ASTEROIDS] = t - t_prev, t_prev = t;
+
+    /* a grid which could not grow to the queue is left empty, and what needs it waits
+     * for a step where it can
+     */
+    bool built = asteroidgrid_build(state->grid, state->asteroids, dt);
+    t = timing_now(), phase_time[PHASE_BROADPHASE] = t - t_prev, t_prev = t;
+
+    if (built) {
+        asteroidgrid_collide(state->grid, state->asteroids, state->jobs, dt);
+    }
+    else {
+        struct AsteroidGrid *grid = state->grid;
+        grid->pairs_tested = grid->pairs_collided = grid->pairs_swept = 0;
+        grid->contacts_dropped = 0;
+    }
+    t = timing_now(), phase_time[PHASE_COLLISIONS] = t - t_prev, t_prev = t;
+
     bulletqueue_update(state->bullets, dt);
-    player_update(state->player, dt);
+    if (built) bulletqueue_collide(state->bullets, state->grid, state->asteroids, dt);
+    t = timing_now(), phase_time[PHASE_BULLETS] = t - t_prev, t_prev = t;
+
+    player_update(state->player, input, dt);
 
-    if (IsKeyDown(KEY_SPACE) && player_can_fire(state->player)) {
+    if ((input & INPUT_FIRE) && player_can_fire(state->player)) {
         struct Player *p = state->player;
         struct Bullet b = {
             .position = player_barrel(p),
+            .previous = player_barrel(p),
             .velocity = (Vector2) { 
                 BULLET_VELOCITY * cos(p->rotation) + p->velocity.x,
                 BULLET_VELOCITY * sin(p->rotation) + p->velocity.y
@@ -84,4 +218,15 @@ void state_update(struct State *state, float dt)
         bulletqueue_insert(state->bullets, b);
         p->reload += 0.66;
     }
+    t = timing_now(), phase_time[PHASE_PLAYER] = t - t_prev, t_prev = t;
+
+    /* removals during the step are only applied now, so indices held by the grid
+     * and the passes above stayed valid throughout; if any asteroid went the grid is
+     * rebuilt over the compacted queue, as state_draw culls against it
+     */
+    bool removed = state->asteroids->pool->num_dead;
+    asteroidqueue_compact(state->asteroids);
+    bulletqueue_compact(state->bullets);
+    if (removed) asteroidgrid_build(state->grid, state->asteroids, dt);
+    phase_time[PHASE_COMPACT] = timing_now() - t_prev;
 }
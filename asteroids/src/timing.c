@@ -0,0 +1,35 @@
+/*  phase timing
+ *      state_update records how long each of the phases before NUM_UPDATE_PHASES took
+ *      on the last step, and state_draw the draw phase of the last frame
+ */
+enum STATE_PHASE
+{
+    PHASE_ASTEROIDS = 0,
+    PHASE_BROADPHASE,
+    PHASE_COLLISIONS,
+    PHASE_BULLETS,
+    PHASE_PLAYER,
+    PHASE_COMPACT,
+    NUM_UPDATE_PHASES,
+    PHASE_DRAW = NUM_UPDATE_PHASES,
+    NUM_STATE_PHASES
+};
+
+
+const char *STATE_PHASE_NAME[NUM_STATE_PHASES] = {
+    "asteroids",
+    "broadphase",
+    "collisions",
+    "bullets",
+    "player",
+    "compact",
+    "draw"
+};
+
+
+double timing_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
@@ -0,0 +1,148 @@
+#include <stdio.h>
+
+#include "../src/bricks.c"
+#include "../src/level.c"
+#include "../../common/src/bench.c"
+
+/*  level load benchmark
+ *      levels of a million to 64 million bricks are written to temporary files, then
+ *      each is opened, focused on a random view and closed again; neither the time
+ *      this takes nor the pages it leaves resident should grow with the level
+ *
+ *      bench_level [results.json [baseline.json]], see bench_finish
+ */
+
+#define LEVEL_BENCH_LOADS 64
+#define LEVEL_BENCH_REPS 10
+
+
+struct LevelBenchSize
+{
+    const char *name;
+    size_t cols;
+    size_t rows;
+};
+
+
+struct LevelBench
+{
+    const char *path;
+    size_t cols;
+    size_t rows;
+    unsigned int rng;
+    size_t standing;
+};
+
+
+unsigned int levelbench_random(unsigned int *rng)
+{
+    unsigned int x = *rng;
+    x ^= x << 13, x ^= x >> 17, x ^= x << 5;
+    return (*rng = x);
+}
+
+
+/* most bricks standing, some taking a few hits */
+unsigned char levelbench_brick(void *ctx, size_t col, size_t row)
+{
+    size_t k = (col * 7919 + row * 104729) % 97;
+    (void) ctx;
+    return (k < 16) ? 0 : LEVEL_BRICK(k, 1 + k % 3);
+}
+
+
+void levelbench_kernel(void *ctx)
+{
+    struct LevelBench *bench = ctx;
+    Vector2 view = { 800, 600 };
+
+    for (size_t i = 0; i < LEVEL_BENCH_LOADS; i++) {
+        struct Level *level = level_open(bench->path, (Vector2) { 0, 0 }, view);
+        if (!level) continue;
+
+        float w = bench->cols * level->header->cell_width;
+        float h = bench->rows * level->header->cell_height;
+        Rectangle at = {
+            levelbench_random(&bench->rng) % 4096 / 4096.0f * w,
+            levelbench_random(&bench->rng) % 4096 / 4096.0f * h, view.x, view.y
+        };
+        level_focus(level, at);
+        bench->standing += level->grid->count;
+        level_close(level);
+    }
+}
+
+
+/* pages resident, from /proc; 0 where that cannot be read */
+size_t levelbench_resident(void)
+{
+    size_t size = 0, resident = 0;
+    FILE *f = fopen("/proc/self/statm", "r");
+    if (!f) return 0;
+    if (fscanf(f, "%zu %zu", &size, &resident) != 2) resident = 0;
+    fclose(f);
+    return resident;
+}
+
+
+int main(int argc, char **argv)
+{
+    static const struct LevelBenchSize sizes[] = {
+        { "  load 1M bricks", 1024, 1024 },
+        { "  load 16M bricks", 4096, 4096 },
+        { "  load 64M bricks", 8192, 8192 }
+    };
+    size_t n = sizeof(sizes) / sizeof(sizes[0]);
+
+    struct BenchResult results[sizeof(sizes) / sizeof(sizes[0])];
+    char path[] = "/tmp/bench_level_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        fprintf(stderr, "level: could not make a temporary file\n");
+        return 1;
+    }
+    close(fd);
+
+    printf("level, opened and focused on an 800 x 600 view of 16 x 8 bricks\n");
+    Vector2 view = { 800, 600 };
+    bool ok = true;
+    for (size_t s = 0; ok && (s < n); s++) {
+        struct LevelBench bench = {
+            .path = path, .cols = sizes[s].cols, .rows = sizes[s].rows, .rng = 1
+        };
+        ok = level_write(
+            path, bench.cols, bench.rows, (Vector2) { 16, 8 }, NULL, 0,
+            levelbench_brick, NULL
+        );
+        if (!ok) break;
+
+        /* what one open and focus leaves resident while the level is open */
+        size_t before = levelbench_resident();
+        struct Level *level = level_open(path, (Vector2) { 0, 0 }, view);
+        ok = level != NULL;
+        if (!ok) break;
+
+        level_focus(level, (Rectangle) { 0, 0, view.x, view.y });
+        printf(
+            "  %zu x %zu, %zu MB on disk: %zu chunks decoded, %zu kB resident\n",
+            bench.cols, bench.rows, level->size >> 20, level->decoded,
+            (levelbench_resident() - before) * sysconf(_SC_PAGESIZE) >> 10
+        );
+        level_close(level);
+
+        results[s] = bench_run(
+            sizes[s].name, levelbench_kernel, &bench, LEVEL_BENCH_LOADS,
+            LEVEL_BENCH_REPS
+        );
+    }
+    unlink(path);
+
+    if (!ok) {
+        fprintf(stderr, "level: could not write or open %s\n", path);
+        return 1;
+    }
+
+    for (size_t s = 0; s < n; s++) bench_report(results[s]);
+    printf("  64M / 1M %.2f\n", results[2].best / results[0].best);
+    return !bench_finish(argc, argv, results, n);
+}
@@ -0,0 +1,207 @@
+#include <stdio.h>
+
+#include "../src/bricks.c"
+#include "../../common/src/bench.c"
+
+/*  brick sweep benchmark
+ *      levels of a thousand to a million bricks, half of them standing at random, and
+ *      a ball's path for one tick from random points across each; the time per sweep
+ *      should not grow with the level
+ *
+ *      first every level is checked: paths of random lengths, up to many cells long,
+ *      each swept against the grid and against every standing brick in turn, and any
+ *      disagreement on whether or when a brick is hit fails the bench
+ *
+ *      bench_sweep [results.json [baseline.json]], see bench_finish
+ */
+
+#define SWEEP_PATHS (1 << 16)
+#define SWEEP_CHECKS 256
+#define SWEEP_CHECK_LENGTH 200
+#define SWEEP_RADIUS 6.0f
+#define SWEEP_LENGTH 6.0f
+#define SWEEP_REPS 20
+
+
+struct SweepLevel
+{
+    const char *name;
+    size_t cols;
+    size_t rows;
+    Vector2 cell;
+};
+
+
+struct SweepBench
+{
+    struct BrickGrid *grid;
+    Vector2 *from;
+    Vector2 *to;
+    size_t hits;
+};
+
+
+unsigned int sweep_random(unsigned int *rng)
+{
+    unsigned int x = *rng;
+    x ^= x << 13, x ^= x >> 17, x ^= x << 5;
+    return (*rng = x);
+}
+
+
+float sweep_unit(unsigned int *rng)
+{
+    return (sweep_random(rng) % (1 << 24)) / (float) (1 << 24);
+}
+
+
+/* a path of length from a random point over the grid, heading anywhere */
+void sweep_path
+(
+    unsigned int *rng, const struct BrickGrid *g, float length, Vector2 *p
+)
+{
+    float angle = sweep_unit(rng) * 2 * PI;
+    p[0] = (Vector2) {
+        g->origin.x + sweep_unit(rng) * g->cols * g->cell.x,
+        g->origin.y + sweep_unit(rng) * g->rows * g->cell.y
+    };
+    p[1] = (Vector2) { p[0].x + length * cosf(angle), p[0].y + length * sinf(angle) };
+}
+
+
+/* the earliest standing brick touched, trying every one */
+bool sweep_brute
+(
+    const struct BrickGrid *g, Vector2 p0, Vector2 p1, float radius,
+    struct BrickHit *hit
+)
+{
+    Vector2 d = { p1.x - p0.x, p1.y - p0.y };
+    hit->t = INFINITY;
+
+    for (size_t row = 0; row < g->rows; row++) {
+        for (size_t col = 0; col < g->cols; col++) {
+            if (!brickgrid_get(g, col, row)) continue;
+
+            Rectangle box = brickgrid_rect(g, col, row);
+            box.x -= radius, box.y -= radius;
+            box.width += 2 * radius, box.height += 2 * radius;
+
+            float t;
+            Vector2 normal;
+            if (!brickgrid_slab(p0, d, box, 0, 1, &t, &normal) || (t >= hit->t)) {
+                continue;
+            }
+            *hit = (struct BrickHit) {
+                .col = col, .row = row, .t = t, .normal = normal
+            };
+        }
+    }
+
+    return hit->t <= 1;
+}
+
+
+/* paths for which the sweep and the brute force disagree */
+size_t sweep_check(const struct BrickGrid *g)
+{
+    unsigned int rng = 11;
+    size_t failures = 0;
+
+    for (size_t k = 0; k < SWEEP_CHECKS; k++) {
+        Vector2 p[2];
+        sweep_path(&rng, g, sweep_unit(&rng) * SWEEP_CHECK_LENGTH, p);
+
+        struct BrickHit a, b;
+        bool found = brickgrid_sweep(g, p[0], p[1], SWEEP_RADIUS, &a);
+        bool expected = sweep_brute(g, p[0], p[1], SWEEP_RADIUS, &b);
+        failures += (found != expected) || (found && (fabsf(a.t - b.t) > 1e-4f));
+    }
+
+    return failures;
+}
+
+
+void sweep_kernel(void *ctx)
+{
+    struct SweepBench *bench = ctx;
+    struct BrickHit hit;
+    for (size_t i = 0; i < SWEEP_PATHS; i++) {
+        bench->hits += brickgrid_sweep(
+            bench->grid, bench->from[i], bench->to[i], SWEEP_RADIUS, &hit
+        );
+    }
+}
+
+
+int main(int argc, char **argv)
+{
+    static const struct SweepLevel levels[] = {
+        { "  sweep 1k bricks", 40, 25, { 16, 8 } },
+        { "  sweep 100k bricks", 400, 250, { 16, 8 } },
+        { "  sweep 1M bricks", 1000, 1000, { 16, 8 } },
+        { "  sweep 100k small bricks", 500, 200, { 1.6f, 1.2f } }
+    };
+    size_t n = sizeof(levels) / sizeof(levels[0]);
+
+    struct SweepBench bench = {
+        .from = malloc(SWEEP_PATHS * sizeof(Vector2)),
+        .to = malloc(SWEEP_PATHS * sizeof(Vector2))
+    };
+    if (!bench.from || !bench.to) {
+        fprintf(stderr, "sweep: allocation failed\n");
+        return 1;
+    }
+
+    struct BenchResult results[sizeof(levels) / sizeof(levels[0])];
+    size_t failures = 0;
+    printf(
+        "sweep, a ball of radius %g moving %g per tick\n", SWEEP_RADIUS, SWEEP_LENGTH
+    );
+
+    for (size_t l = 0; l < n; l++) {
+        const struct SweepLevel *level = levels + l;
+        bench.grid = brickgrid_create(
+            level->cols, level->rows, (Vector2) { 0, 0 }, level->cell
+        );
+        if (!bench.grid) {
+            fprintf(stderr, "sweep: allocation failed\n");
+            return 1;
+        }
+
+        unsigned int rng = 1;
+        for (size_t row = 0; row < level->rows; row++) {
+            for (size_t col = 0; col < level->cols; col++) {
+                brickgrid_set(bench.grid, col, row, sweep_random(&rng) % 2);
+            }
+        }
+
+        size_t failed = sweep_check(bench.grid);
+        printf(
+            "  %zu x %zu, %zu standing, %d paths checked: %zu failed\n", level->cols,
+            level->rows, bench.grid->count, SWEEP_CHECKS, failed
+        );
+        failures += failed;
+
+        for (size_t i = 0; i < SWEEP_PATHS; i++) {
+            Vector2 p[2];
+            sweep_path(&rng, bench.grid, SWEEP_LENGTH, p);
+            bench.from[i] = p[0], bench.to[i] = p[1];
+        }
+        results[l] = bench_run(
+            level->name, sweep_kernel, &bench, SWEEP_PATHS, SWEEP_REPS
+        );
+        brickgrid_destroy(bench.grid);
+    }
+
+    for (size_t l = 0; l < n; l++) bench_report(results[l]);
+    printf("  1M / 1k %.2f\n", results[2].best / results[0].best);
+    free(bench.from), free(bench.to);
+
+    if (failures) {
+        fprintf(stderr, "sweep: %zu paths disagree with brute force\n", failures);
+        return 1;
+    }
+    return !bench_finish(argc, argv, results, n);
+}
@@ -0,0 +1,316 @@
+#include <math.h>
+#include <raylib.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+/*  brick grid
+ *      the bricks of a level are cells of a uniform cols x rows grid, and only whether
+ *      each is standing is stored: one bit a brick, rows padded to a whole number of
+ *      words, so a level of a million bricks is 125kB
+ *
+ *      a ball is swept along its path for the step by walking the cells its centre
+ *      passes through in order (a dda, after amanatides and woo), and testing the
+ *      bricks standing within its radius of them against the path, each step adding
+ *      only the strip of cells newly in reach; once the walk reaches cells entered
+ *      after the earliest hit so far nothing closer can be found, and it stops. a step
+ *      costs the cells crossed and the bricks around them, however many bricks the
+ *      level holds
+ *
+ *      a brick is hit where the ball's centre enters the brick grown by the ball's
+ *      radius on every side, so its corners are taken as square
+ */
+
+#define BRICKGRID_WORD_BITS 64
+#define BRICKGRID_EPSILON 1e-4f
+
+
+struct BrickGrid
+{
+    unsigned long long *bits;
+    size_t cols;
+    size_t rows;
+    size_t stride;
+    size_t count;
+    Vector2 origin;
+    Vector2 cell;
+};
+
+
+/* where along the path (0 at its start, 1 at its end) a brick was first touched, and
+ * the face it was touched on
+ */
+struct BrickHit
+{
+    size_t col;
+    size_t row;
+    float t;
+    Vector2 normal;
+};
+
+
+void brickgrid_destroy(struct BrickGrid *g)
+{
+    if (!g) return;
+    if (g->bits) free(g->bits);
+    free(g);
+}
+
+
+/* an empty cols x rows grid with its top left corner at origin */
+struct BrickGrid *brickgrid_create
+(
+    size_t cols, size_t rows, Vector2 origin, Vector2 cell
+)
+{
+    if (!cols || !rows || !(cell.x > 0) || !(cell.y > 0)) return NULL;
+
+    struct BrickGrid *g = malloc(sizeof(struct BrickGrid));
+    if (!g) return NULL;
+
+    size_t stride = (cols + BRICKGRID_WORD_BITS - 1) / BRICKGRID_WORD_BITS;
+    *g = (struct BrickGrid) {
+        .bits = calloc(stride * rows, sizeof(unsigned long long)),
+        .cols = cols,
+        .rows = rows,
+        .stride = stride,
+        .origin = origin,
+        .cell = cell
+    };
+    if (!g->bits) {
+        brickgrid_destroy(g);
+        return NULL;
+    }
+
+    return g;
+}
+
+
+bool brickgrid_get(const struct BrickGrid *g, size_t col, size_t row)
+{
+    if ((col >= g->cols) || (row >= g->rows)) return false;
+    unsigned long long word = g->bits[row * g->stride + col / BRICKGRID_WORD_BITS];
+    return (word >> (col % BRICKGRID_WORD_BITS)) & 1;
+}
+
+
+void brickgrid_set(struct BrickGrid *g, size_t col, size_t row, bool standing)
+{
+    if ((col >= g->cols) || (row >= g->rows)) return;
+
+    unsigned long long *word = g->bits + row * g->stride + col / BRICKGRID_WORD_BITS;
+    unsigned long long bit = 1ull << (col % BRICKGRID_WORD_BITS);
+    if (standing == !!(*word & bit)) return;
+
+    *word ^= bit;
+    if (standing) g->count++;
+    else g->count--;
+}
+
+
+/* every brick standing; the padding past the last column stays clear */
+void brickgrid_fill(struct BrickGrid *g)
+{
+    size_t tail = g->cols % BRICKGRID_WORD_BITS;
+    for (size_t row = 0; row < g->rows; row++) {
+        unsigned long long *words = g->bits + row * g->stride;
+        for (size_t w = 0; w < g->stride; w++) words[w] = ~0ull;
+        if (tail) words[g->stride - 1] = (1ull << tail) - 1;
+    }
+    g->count = g->cols * g->rows;
+}
+
+
+Rectangle brickgrid_rect(const struct BrickGrid *g, size_t col, size_t row)
+{
+    return (Rectangle) {
+        g->origin.x + col * g->cell.x, g->origin.y + row * g->cell.y,
+        g->cell.x, g->cell.y
+    };
+}
+
+
+/* the bits of columns c0 .. c1 (within one word, c1 - c0 < BRICKGRID_WORD_BITS) of
+ * row, starting at bit 0
+ */
+unsigned long long brickgrid_span
+(
+    const struct BrickGrid *g, size_t row, size_t c0, size_t c1
+)
+{
+    const unsigned long long *words = g->bits + row * g->stride;
+    size_t w = c0 / BRICKGRID_WORD_BITS, shift = c0 % BRICKGRID_WORD_BITS;
+    unsigned long long bits = words[w] >> shift;
+    if (shift && (w + 1 < g->stride)) {
+        bits |= words[w + 1] << (BRICKGRID_WORD_BITS - shift);
+    }
+
+    size_t n = c1 - c0 + 1;
+    return (n < BRICKGRID_WORD_BITS) ? bits & ((1ull << n) - 1) : bits;
+}
+
+
+/* where along p0 + t*d, if anywhere in [t0, t1], the path enters box, and the normal
+ * of the face it enters by. a path which starts inside (by more than rounding) does
+ * not enter, so a ball leaving the face it has just bounced off is not caught by the
+ * brick beside the one it hit
+ */
+bool brickgrid_slab
+(
+    Vector2 p0, Vector2 d, Rectangle box, float t0, float t1, float *t, Vector2 *normal
+)
+{
+    float lo[2] = { box.x, box.y }, hi[2] = { box.x + box.width, box.y + box.height };
+    float p[2] = { p0.x, p0.y }, v[2] = { d.x, d.y };
+    float enter = -INFINITY, leave = INFINITY;
+    size_t axis = 0;
+
+    for (size_t k = 0; k < 2; k++) {
+        if (v[k] == 0) {
+            if ((p[k] < lo[k]) || (p[k] > hi[k])) return false;
+            continue;
+        }
+        float a = (lo[k] - p[k]) / v[k], b = (hi[k] - p[k]) / v[k];
+        if (a > b) {
+            float swap = a;
+            a = b, b = swap;
+        }
+        if (a > enter) enter = a, axis = k;
+        if (b < leave) leave = b;
+    }
+
+    if ((enter > leave) || (enter > t1) || (enter < t0 - BRICKGRID_EPSILON)) {
+        return false;
+    }
+    *t = fmaxf(enter, t0);
+    *normal = (axis) ? (Vector2) { 0, (v[1] > 0) ? -1 : 1 }
+        : (Vector2) { (v[0] > 0) ? -1 : 1, 0 };
+    return true;
+}
+
+
+/* a path being swept, over the stretch t0 .. t1 of it, and the earliest hit so far */
+struct BrickSweep
+{
+    Vector2 p0;
+    Vector2 d;
+    float radius;
+    float t0;
+    float t1;
+    struct BrickHit *hit;
+};
+
+
+/* test the standing bricks of columns c0 .. c1 and rows r0 .. r1 (clipped to the
+ * grid) against the path, keeping the earliest hit
+ */
+void brickgrid_sweep_block
+(
+    const struct BrickGrid *g, struct BrickSweep *s, long c0, long c1, long r0, long r1
+)
+{
+    if (r0 < 0) r0 = 0;
+    if (c0 < 0) c0 = 0;
+    if (r1 >= (long) g->rows) r1 = g->rows - 1;
+    if (c1 >= (long) g->cols) c1 = g->cols - 1;
+
+    for (long r = r0; r <= r1; r++) {
+        for (long c = c0; c <= c1; c += BRICKGRID_WORD_BITS) {
+            long last = c + BRICKGRID_WORD_BITS - 1;
+            if (last > c1) last = c1;
+
+            for (unsigned long long bits = brickgrid_span(g, r, c, last); bits;) {
+                size_t col = c + __builtin_ctzll(bits);
+                bits &= bits - 1;
+
+                Rectangle box = brickgrid_rect(g, col, r);
+                box.x -= s->radius, box.y -= s->radius;
+                box.width += 2 * s->radius, box.height += 2 * s->radius;
+
+                float t;
+                Vector2 normal;
+                if (!brickgrid_slab(s->p0, s->d, box, s->t0, s->t1, &t, &normal)) {
+                    continue;
+                }
+                if (t >= s->hit->t) continue;
+                *s->hit = (struct BrickHit) {
+                    .col = col, .row = r, .t = t, .normal = normal
+                };
+            }
+        }
+    }
+}
+
+
+/* the earliest brick a ball of radius moving from p0 to p1 touches, if any */
+bool brickgrid_sweep
+(
+    const struct BrickGrid *g, Vector2 p0, Vector2 p1, float radius,
+    struct BrickHit *hit
+)
+{
+    Vector2 d = { p1.x - p0.x, p1.y - p0.y };
+
+    /* only the stretch of the path within reach of the grid */
+    Rectangle reach = {
+        g->origin.x - radius, g->origin.y - radius,
+        g->cols * g->cell.x + 2 * radius, g->rows * g->cell.y + 2 * radius
+    };
+    float t0 = 0, t1 = 1;
+    if (d.x != 0) {
+        float a = (reach.x - p0.x) / d.x, b = (reach.x + reach.width - p0.x) / d.x;
+        t0 = fmaxf(t0, fminf(a, b)), t1 = fminf(t1, fmaxf(a, b));
+    }
+    else if ((p0.x < reach.x) || (p0.x > reach.x + reach.width)) return false;
+    if (d.y != 0) {
+        float a = (reach.y - p0.y) / d.y, b = (reach.y + reach.height - p0.y) / d.y;
+        t0 = fmaxf(t0, fminf(a, b)), t1 = fminf(t1, fmaxf(a, b));
+    }
+    else if ((p0.y < reach.y) || (p0.y > reach.y + reach.height)) return false;
+    if (t0 > t1) return false;
+
+    /* the cells of the start and end of that stretch, and how far around each visited
+     * cell a brick can be touched from it
+     */
+    Vector2 a = { p0.x + d.x * t0 - g->origin.x, p0.y + d.y * t0 - g->origin.y };
+    Vector2 b = { p0.x + d.x * t1 - g->origin.x, p0.y + d.y * t1 - g->origin.y };
+    long col = floorf(a.x / g->cell.x), row = floorf(a.y / g->cell.y);
+    long col_end = floorf(b.x / g->cell.x), row_end = floorf(b.y / g->cell.y);
+    long around_c = ceilf(radius / g->cell.x), around_r = ceilf(radius / g->cell.y);
+
+    long step_c = (d.x > 0) ? 1 : -1, step_r = (d.y > 0) ? 1 : -1;
+    float next_c = (d.x != 0)
+        ? ((col + (d.x > 0)) * g->cell.x + g->origin.x - p0.x) / d.x : INFINITY;
+    float next_r = (d.y != 0)
+        ? ((row + (d.y > 0)) * g->cell.y + g->origin.y - p0.y) / d.y : INFINITY;
+    float delta_c = (d.x != 0) ? g->cell.x / fabsf(d.x) : INFINITY;
+    float delta_r = (d.y != 0) ? g->cell.y / fabsf(d.y) : INFINITY;
+
+    struct BrickSweep sweep = {
+        .p0 = p0, .d = d, .radius = radius, .t0 = t0, .t1 = t1, .hit = hit
+    };
+    hit->t = INFINITY;
+
+    /* the first cell's whole neighbourhood, then at each step into the next cell only
+     * the strip of its neighbourhood the last one's did not cover
+     */
+    brickgrid_sweep_block(
+        g, &sweep, col - around_c, col + around_c, row - around_r, row + around_r
+    );
+    size_t cells = labs(col_end - col) + labs(row_end - row) + 1;
+    for (size_t k = 1; k < cells; k++) {
+        if (next_c < next_r) {
+            if (next_c > hit->t) break;
+            next_c += delta_c, col += step_c;
+            long c = col + step_c * around_c;
+            brickgrid_sweep_block(g, &sweep, c, c, row - around_r, row + around_r);
+        }
+        else {
+            if (next_r > hit->t) break;
+            next_r += delta_r, row += step_r;
+            long r = row + step_r * around_r;
+            brickgrid_sweep_block(g, &sweep, col - around_c, col + around_c, r, r);
+        }
+    }
+
+    return hit->t <= 1;
+}
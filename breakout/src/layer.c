@@ -0,0 +1,236 @@
+#include <math.h>
+#include <raylib.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+/*  brick layer
+ *      the bricks are drawn once into a render texture, background and all, and the
+ *      frame draws that texture as one quad; a brick knocked out (or put back) marks
+ *      its cell dirty, and before the next frame only the dirty cells are drawn over:
+ *      the background, then every standing brick which overlaps the cell once it is
+ *      widened to whole pixels, so bricks narrower than a pixel share their edges
+ *      cleanly
+ *
+ *      the texture is the size it is created with, not the grid's: the whole field
+ *      when that fits on screen, or the view and a margin over a larger one, moved
+ *      with bricklayer_follow. its size never depends on the cells, so large bricks
+ *      cannot push it past what a GPU allows
+ *
+ *      bricks are coloured by the function given, or by row if none is
+ *
+ *      more dirty cells in a frame than the layer keeps turn into one redraw of the
+ *      whole texture, as does bricklayer_mark_all; last_dirty counts the rectangles the
+ *      last flush drew over, the whole texture as one
+ */
+
+#define BRICKLAYER_DIRTY_MAX 256
+
+
+struct BrickCell
+{
+    size_t col;
+    size_t row;
+};
+
+
+struct BrickLayer
+{
+    RenderTexture2D target;
+    Vector2 origin;
+    const struct BrickGrid *grid;
+    Color background;
+    Color (*colour)(const void *ctx, size_t col, size_t row);
+    const void *ctx;
+    struct BrickCell dirty[BRICKLAYER_DIRTY_MAX];
+    size_t num_dirty;
+    bool redraw;
+    size_t last_dirty;
+};
+
+
+void bricklayer_destroy(struct BrickLayer *layer)
+{
+    if (!layer) return;
+    if (layer->target.id) UnloadRenderTexture(layer->target);
+    free(layer);
+}
+
+
+Color bricklayer_colour(const void *ctx, size_t col, size_t row)
+{
+    (void) col;
+    const struct BrickGrid *g = ctx;
+    return ColorFromHSV(360.0f * row / g->rows, 0.6f, 0.95f);
+}
+
+
+/* a layer of size pixels for grid, its top left corner on the grid's, drawn in full
+ * on its first flush; needs the window open
+ */
+struct BrickLayer *bricklayer_create
+(
+    const struct BrickGrid *grid, Vector2 size, Color background,
+    Color (*colour)(const void *ctx, size_t col, size_t row), const void *ctx
+)
+{
+    struct BrickLayer *layer = malloc(sizeof(struct BrickLayer));
+    if (!layer) return NULL;
+
+    *layer = (struct BrickLayer) {
+        .target = LoadRenderTexture(ceilf(size.x), ceilf(size.y)),
+        .origin = grid->origin,
+        .grid = grid,
+        .background = background,
+        .colour = (colour) ? colour : bricklayer_colour,
+        .ctx = (colour) ? ctx : grid,
+        .redraw = true
+    };
+    if (!layer->target.id) {
+        bricklayer_destroy(layer);
+        return NULL;
+    }
+
+    return layer;
+}
+
+
+void bricklayer_mark(struct BrickLayer *layer, size_t col, size_t row)
+{
+    if (layer->num_dirty == BRICKLAYER_DIRTY_MAX) layer->redraw = true;
+    if (layer->redraw) return;
+    layer->dirty[layer->num_dirty++] = (struct BrickCell) { col, row };
+}
+
+
+void bricklayer_mark_all(struct BrickLayer *layer)
+{
+    layer->redraw = true;
+}
+
+
+/* keep the texture over view (in world space), centring it on the view again, and
+ * redrawing it, once the view leaves it
+ */
+void bricklayer_follow(struct BrickLayer *layer, Rectangle view)
+{
+    Texture2D texture = layer->target.texture;
+    bool inside = (
+        (view.x >= layer->origin.x) && (view.y >= layer->origin.y) &&
+        (view.x + view.width <= layer->origin.x + texture.width) &&
+        (view.y + view.height <= layer->origin.y + texture.height)
+    );
+    if (inside) return;
+
+    /* on whole pixels, so the dirty cells widen the same way wherever it is */
+    layer->origin = (Vector2) {
+        floorf(view.x + (view.width - texture.width) / 2),
+        floorf(view.y + (view.height - texture.height) / 2)
+    };
+    layer->redraw = true;
+}
+
+
+/* the columns and rows of the grid under the layer's pixels px; false if none */
+bool bricklayer_cells
+(
+    const struct BrickLayer *layer, Rectangle px, size_t *c0, size_t *c1, size_t *r0,
+    size_t *r1
+)
+{
+    const struct BrickGrid *g = layer->grid;
+    float x0 = px.x + layer->origin.x - g->origin.x, x1 = x0 + px.width;
+    float y0 = px.y + layer->origin.y - g->origin.y, y1 = y0 + px.height;
+    if ((x1 <= 0) || (x0 >= g->cols * g->cell.x)) return false;
+    if ((y1 <= 0) || (y0 >= g->rows * g->cell.y)) return false;
+
+    *c0 = (x0 > 0) ? x0 / g->cell.x : 0, *c1 = ceilf(x1 / g->cell.x) - 1;
+    *r0 = (y0 > 0) ? y0 / g->cell.y : 0, *r1 = ceilf(y1 / g->cell.y) - 1;
+    if (*c1 >= g->cols) *c1 = g->cols - 1;
+    if (*r1 >= g->rows) *r1 = g->rows - 1;
+    return true;
+}
+
+
+/* the standing bricks of columns c0 .. c1 and rows r0 .. r1, a word of the bitset at a
+ * time, in the layer's own space (its origin at 0, 0)
+ */
+void bricklayer_draw_bricks
+(
+    const struct BrickLayer *layer, size_t c0, size_t c1, size_t r0, size_t r1
+)
+{
+    const struct BrickGrid *g = layer->grid;
+    for (size_t row = r0; row <= r1; row++) {
+        for (size_t c = c0; c <= c1; c += BRICKGRID_WORD_BITS) {
+            size_t last = c + BRICKGRID_WORD_BITS - 1;
+            if (last > c1) last = c1;
+
+            for (unsigned long long bits = brickgrid_span(g, row, c, last); bits;) {
+                size_t col = c + __builtin_ctzll(bits);
+                bits &= bits - 1;
+
+                Rectangle r = brickgrid_rect(g, col, row);
+                r.x -= layer->origin.x, r.y -= layer->origin.y;
+                if ((r.width > 2) && (r.height > 2)) {
+                    r.x += 1, r.y += 1, r.width -= 2, r.height -= 2;
+                }
+                DrawRectangleRec(r, layer->colour(layer->ctx, col, row));
+            }
+        }
+    }
+}
+
+
+/* bring the texture up to date with the grid: everything, or just the dirty cells */
+void bricklayer_flush(struct BrickLayer *layer)
+{
+    const struct BrickGrid *g = layer->grid;
+    Texture2D texture = layer->target.texture;
+    size_t c0, c1, r0, r1;
+
+    layer->last_dirty = (layer->redraw) ? 1 : layer->num_dirty;
+    if (!layer->redraw && !layer->num_dirty) return;
+
+    BeginTextureMode(layer->target);
+    if (layer->redraw) {
+        ClearBackground(layer->background);
+        Rectangle all = { 0, 0, texture.width, texture.height };
+        if (bricklayer_cells(layer, all, &c0, &c1, &r0, &r1)) {
+            bricklayer_draw_bricks(layer, c0, c1, r0, r1);
+        }
+    }
+    for (size_t k = 0; (k < layer->num_dirty) && !layer->redraw; k++) {
+        struct BrickCell cell = layer->dirty[k];
+
+        /* the pixels the cell touches, and the cells which touch those */
+        Rectangle r = brickgrid_rect(g, cell.col, cell.row);
+        float x0 = floorf(r.x - layer->origin.x);
+        float x1 = ceilf(r.x + r.width - layer->origin.x);
+        float y0 = floorf(r.y - layer->origin.y);
+        float y1 = ceilf(r.y + r.height - layer->origin.y);
+        if ((x1 <= 0) || (y1 <= 0) || (x0 >= texture.width) || (y0 >= texture.height)) {
+            continue;
+        }
+
+        Rectangle px = { x0, y0, x1 - x0, y1 - y0 };
+        DrawRectangleRec(px, layer->background);
+        if (bricklayer_cells(layer, px, &c0, &c1, &r0, &r1)) {
+            bricklayer_draw_bricks(layer, c0, c1, r0, r1);
+        }
+    }
+    EndTextureMode();
+
+    layer->num_dirty = 0;
+    layer->redraw = false;
+}
+
+
+/* the texture as one quad; render textures are stored upside down */
+void bricklayer_draw(const struct BrickLayer *layer)
+{
+    Texture2D texture = layer->target.texture;
+    DrawTextureRec(
+        texture, (Rectangle) { 0, 0, texture.width, -texture.height }, layer->origin,
+        WHITE
+    );
+}
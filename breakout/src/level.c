@@ -0,0 +1,335 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*  level files
+ *      a level is cols x rows bricks cut into square chunks of LEVEL_CHUNK, each stored
+ *      as a fixed size record, so chunk k is found by arithmetic and a level of any
+ *      size opens without reading more than its header:
+ *          header      struct LevelHeader, with the palette
+ *          chunks      struct LevelChunk, row by row of chunks
+ *
+ *      a chunk holds a row of bits per row of bricks (a word each, as BrickGrid rows)
+ *      and a byte per brick, its colour index in the low four bits and the hits it
+ *      takes in the high four; a brick is standing exactly when its bit is set, and
+ *      the partial chunks at the right and bottom edges are empty past the level
+ *
+ *      the file is mapped privately, so breaking bricks changes the mapping and never
+ *      the file, and only the pages actually touched become resident. the game plays
+ *      on a window of whole chunks around the view, whose bits are copied into a
+ *      BrickGrid when the view leaves it; hit counts and colours are read straight
+ *      from the mapping
+ *
+ *      native byte order and layout, like the replays: files are for the build which
+ *      wrote them (or one like it), see breakout-levelc
+ */
+
+#define LEVEL_MAGIC 0x4c4b5242u
+#define LEVEL_VERSION 1
+#define LEVEL_CHUNK 64
+#define LEVEL_COLOURS 16
+#define LEVEL_HITS_MAX 15
+
+/* a brick's byte; no hits is no brick */
+#define LEVEL_BRICK(colour, hits) ((unsigned char) (((hits) << 4) | ((colour) & 15)))
+
+_Static_assert(LEVEL_CHUNK == BRICKGRID_WORD_BITS, "a chunk row is one grid word");
+
+
+struct LevelHeader
+{
+    unsigned int magic;
+    unsigned int version;
+    unsigned long long cols;
+    unsigned long long rows;
+    unsigned long long chunks_x;
+    unsigned long long chunks_y;
+    unsigned long long standing;
+    float cell_width;
+    float cell_height;
+    unsigned int num_colours;
+    unsigned char palette[LEVEL_COLOURS][4];
+};
+
+
+struct LevelChunk
+{
+    unsigned long long bits[LEVEL_CHUNK];
+    unsigned char bricks[LEVEL_CHUNK * LEVEL_CHUNK];
+};
+
+
+/* an open level: the mapping, and the window of view_x x view_y chunks from
+ * (chunk_x, chunk_y) decoded into grid
+ */
+struct Level
+{
+    unsigned char *map;
+    size_t size;
+    struct LevelHeader *header;
+    struct LevelChunk *chunks;
+    Vector2 origin;
+
+    struct BrickGrid *grid;
+    size_t view_x;
+    size_t view_y;
+    size_t chunk_x;
+    size_t chunk_y;
+    bool focused;
+    size_t decoded;
+};
+
+
+/* a level of cols x rows bricks, where brick(ctx, col, row) gives each one's byte
+ * (see LEVEL_BRICK); written a chunk at a time, so levels far larger than memory can
+ * be generated
+ */
+bool level_write
+(
+    const char *path, size_t cols, size_t rows, Vector2 cell, const Color *palette,
+    size_t num_colours, unsigned char (*brick)(void *ctx, size_t col, size_t row),
+    void *ctx
+)
+{
+    if (!cols || !rows || !(cell.x > 0) || !(cell.y > 0)) return false;
+    if (num_colours > LEVEL_COLOURS) return false;
+
+    struct LevelHeader h = {
+        .magic = LEVEL_MAGIC,
+        .version = LEVEL_VERSION,
+        .cols = cols,
+        .rows = rows,
+        .chunks_x = (cols + LEVEL_CHUNK - 1) / LEVEL_CHUNK,
+        .chunks_y = (rows + LEVEL_CHUNK - 1) / LEVEL_CHUNK,
+        .cell_width = cell.x,
+        .cell_height = cell.y,
+        .num_colours = num_colours
+    };
+    for (size_t k = 0; k < num_colours; k++) {
+        h.palette[k][0] = palette[k].r, h.palette[k][1] = palette[k].g;
+        h.palette[k][2] = palette[k].b, h.palette[k][3] = palette[k].a;
+    }
+
+    struct LevelChunk *chunk = malloc(sizeof(struct LevelChunk));
+    FILE *f = fopen(path, "wb");
+    bool ok = chunk && f && (fwrite(&h, sizeof(struct LevelHeader), 1, f) == 1);
+
+    for (size_t cy = 0; ok && (cy < h.chunks_y); cy++) {
+        for (size_t cx = 0; ok && (cx < h.chunks_x); cx++) {
+            memset(chunk, 0, sizeof(struct LevelChunk));
+
+            for (size_t r = 0; r < LEVEL_CHUNK; r++) {
+                size_t row = cy * LEVEL_CHUNK + r;
+                for (size_t c = 0; (c < LEVEL_CHUNK) && (row < rows); c++) {
+                    size_t col = cx * LEVEL_CHUNK + c;
+                    unsigned char b = (col < cols) ? brick(ctx, col, row) : 0;
+                    if (!(b >> 4)) continue;
+
+                    chunk->bricks[r * LEVEL_CHUNK + c] = b;
+                    chunk->bits[r] |= 1ull << c;
+                    h.standing++;
+                }
+            }
+            ok = (fwrite(chunk, sizeof(struct LevelChunk), 1, f) == 1);
+        }
+    }
+
+    /* the header again, now the bricks are counted */
+    ok = (
+        ok && !fseek(f, 0, SEEK_SET) &&
+        (fwrite(&h, sizeof(struct LevelHeader), 1, f) == 1)
+    );
+    if (f) ok = !fclose(f) && ok;
+    free(chunk);
+    return ok;
+}
+
+
+void level_close(struct Level *level)
+{
+    if (!level) return;
+    if (level->map) munmap(level->map, level->size);
+    brickgrid_destroy(level->grid);
+    free(level);
+}
+
+
+bool level_valid(const struct LevelHeader *h, size_t size)
+{
+    size_t chunks_x = (h->cols + LEVEL_CHUNK - 1) / LEVEL_CHUNK;
+    size_t chunks_y = (h->rows + LEVEL_CHUNK - 1) / LEVEL_CHUNK;
+    return (
+        (h->magic == LEVEL_MAGIC) && (h->version == LEVEL_VERSION) &&
+        h->cols && h->rows && (h->chunks_x == chunks_x) && (h->chunks_y == chunks_y) &&
+        (h->cell_width > 0) && (h->cell_height > 0) &&
+        (h->num_colours <= LEVEL_COLOURS) &&
+        ((size - sizeof(struct LevelHeader)) / sizeof(struct LevelChunk)
+            >= chunks_x * chunks_y)
+    );
+}
+
+
+/* map the level at path, placing its top left corner at origin, with a window large
+ * enough to hold a view of view.x x view.y wherever it is; nothing is decoded until
+ * the first level_focus
+ */
+struct Level *level_open(const char *path, Vector2 origin, Vector2 view)
+{
+    struct Level *level = malloc(sizeof(struct Level));
+    if (!level) return NULL;
+    *level = (struct Level) { .origin = origin };
+
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    bool sized = (fd >= 0) && !fstat(fd, &st);
+    if (!sized || (st.st_size < (off_t) sizeof(struct LevelHeader))) {
+        if (fd >= 0) close(fd);
+        level_close(level);
+        return NULL;
+    }
+
+    level->size = st.st_size;
+    void *map = mmap(NULL, level->size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        level_close(level);
+        return NULL;
+    }
+    level->map = map;
+    level->header = map;
+    level->chunks = (struct LevelChunk *) (level->map + sizeof(struct LevelHeader));
+    if (!level_valid(level->header, level->size)) {
+        level_close(level);
+        return NULL;
+    }
+
+    /* the chunks a view can straddle, and one more each way to move within */
+    struct LevelHeader *h = level->header;
+    Vector2 cell = { h->cell_width, h->cell_height };
+    level->view_x = ceilf(view.x / (LEVEL_CHUNK * cell.x)) + 2;
+    level->view_y = ceilf(view.y / (LEVEL_CHUNK * cell.y)) + 2;
+    if (level->view_x > h->chunks_x) level->view_x = h->chunks_x;
+    if (level->view_y > h->chunks_y) level->view_y = h->chunks_y;
+
+    level->grid = brickgrid_create(
+        level->view_x * LEVEL_CHUNK, level->view_y * LEVEL_CHUNK, origin, cell
+    );
+    if (!level->grid) {
+        level_close(level);
+        return NULL;
+    }
+
+    return level;
+}
+
+
+struct LevelChunk *level_chunk(const struct Level *level, size_t cx, size_t cy)
+{
+    return level->chunks + cy * level->header->chunks_x + cx;
+}
+
+
+/* the chunks from first to last of total (clipped to the level), and the first of a
+ * window of n chunks centred on them
+ */
+size_t level_window(long *first, long *last, size_t n, size_t total)
+{
+    if (*first < 0) *first = 0;
+    if (*last > (long) total - 1) *last = total - 1;
+
+    long start = (*first + *last) / 2 - (long) (n - 1) / 2;
+    if (start > (long) (total - n)) start = total - n;
+    return (start < 0) ? 0 : start;
+}
+
+
+/* keep the window over view (in world space), decoding a new one centred on it once
+ * the view reaches a chunk outside it; returns whether the window moved
+ */
+bool level_focus(struct Level *level, Rectangle view)
+{
+    const struct LevelHeader *h = level->header;
+    float chunk_w = LEVEL_CHUNK * h->cell_width, chunk_h = LEVEL_CHUNK * h->cell_height;
+    float x = view.x - level->origin.x, y = view.y - level->origin.y;
+    long first_x = floorf(x / chunk_w), last_x = floorf((x + view.width) / chunk_w);
+    long first_y = floorf(y / chunk_h), last_y = floorf((y + view.height) / chunk_h);
+
+    size_t cx = level_window(&first_x, &last_x, level->view_x, h->chunks_x);
+    size_t cy = level_window(&first_y, &last_y, level->view_y, h->chunks_y);
+    bool inside = (
+        (first_x >= (long) level->chunk_x) &&
+        (last_x < (long) (level->chunk_x + level->view_x)) &&
+        (first_y >= (long) level->chunk_y) &&
+        (last_y < (long) (level->chunk_y + level->view_y))
+    );
+    if (level->focused && inside) return false;
+
+    /* each chunk row of bits is one word of a grid row */
+    struct BrickGrid *g = level->grid;
+    g->count = 0;
+    for (size_t j = 0; j < level->view_y; j++) {
+        for (size_t i = 0; i < level->view_x; i++) {
+            const struct LevelChunk *chunk = level_chunk(level, cx + i, cy + j);
+            for (size_t r = 0; r < LEVEL_CHUNK; r++) {
+                g->bits[(j * LEVEL_CHUNK + r) * g->stride + i] = chunk->bits[r];
+                g->count += __builtin_popcountll(chunk->bits[r]);
+            }
+        }
+    }
+    g->origin = (Vector2) {
+        level->origin.x + cx * chunk_w, level->origin.y + cy * chunk_h
+    };
+
+    level->chunk_x = cx, level->chunk_y = cy;
+    level->focused = true;
+    level->decoded += level->view_x * level->view_y;
+    return true;
+}
+
+
+/* the byte of the brick at col, row of the window */
+unsigned char *level_brick(const struct Level *level, size_t col, size_t row)
+{
+    struct LevelChunk *chunk = level_chunk(
+        level, level->chunk_x + col / LEVEL_CHUNK, level->chunk_y + row / LEVEL_CHUNK
+    );
+    return chunk->bricks + (row % LEVEL_CHUNK) * LEVEL_CHUNK + col % LEVEL_CHUNK;
+}
+
+
+/* take a hit off the standing brick at col, row of the window; returns whether that
+ * broke it
+ */
+bool level_hit(struct Level *level, size_t col, size_t row)
+{
+    unsigned char *b = level_brick(level, col, row);
+    if ((*b >> 4) > 1) {
+        *b -= 1 << 4;
+        return false;
+    }
+
+    struct LevelChunk *chunk = level_chunk(
+        level, level->chunk_x + col / LEVEL_CHUNK, level->chunk_y + row / LEVEL_CHUNK
+    );
+    chunk->bits[row % LEVEL_CHUNK] &= ~(1ull << (col % LEVEL_CHUNK));
+    *b = 0;
+    brickgrid_set(level->grid, col, row, false);
+    level->header->standing--;
+    return true;
+}
+
+
+/* the colour of the brick at col, row of the window, for BrickLayer */
+Color level_colour(const void *ctx, size_t col, size_t row)
+{
+    const struct Level *level = ctx;
+    size_t k = *level_brick(level, col, row) & 15;
+    if (k >= level->header->num_colours) return WHITE;
+
+    const unsigned char *c = level->header->palette[k];
+    return (Color) { c[0], c[1], c[2], c[3] };
+}
@@ -0,0 +1,206 @@
+#include <raylib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bricks.c"
+#include "level.c"
+
+/*  level converter
+ *      writes a level file (see level.c) from a pattern of bricks, tiled as many times
+ *      across and down as asked, so a few lines can describe a board of any size
+ *
+ *      breakout-levelc [--cell W H] [--repeat ACROSS DOWN] input output
+ *
+ *      an input ending in .txt is a text description:
+ *          # a comment
+ *          cell 8 4                brick size, 16 x 8 if not given
+ *          brick r ff4040 2        r is a brick coloured ff4040 taking 2 hits
+ *          repeat 100 50           the pattern is tiled 100 across and 50 down
+ *          pattern                 every line after this is a row of the pattern:
+ *          rrrr..gggg              a brick's character, or anything else for none
+ *
+ *      any other input is an image loaded by raylib, a brick per pixel taking one hit;
+ *      pixels less than half opaque are empty, and the first LEVEL_COLOURS colours
+ *      found make the palette, later ones taking the nearest of those. the options
+ *      override the text's directives
+ */
+
+#define LEVELC_LINE_MAX 4096
+
+
+struct LevelPattern
+{
+    unsigned char *bricks;
+    size_t width;
+    size_t height;
+    Color palette[LEVEL_COLOURS];
+    size_t num_colours;
+    Vector2 cell;
+    size_t across;
+    size_t down;
+};
+
+
+unsigned char levelc_brick(void *ctx, size_t col, size_t row)
+{
+    const struct LevelPattern *p = ctx;
+    return p->bricks[(row % p->height) * p->width + col % p->width];
+}
+
+
+/* append a row of the pattern, widening every row (with empty bricks) to fit it */
+bool levelc_add_row(struct LevelPattern *p, const unsigned char *row, size_t width)
+{
+    size_t w = (width > p->width) ? width : p->width;
+    unsigned char *bricks = calloc((p->height + 1) * w + 1, 1);
+    if (!bricks) return false;
+
+    for (size_t r = 0; r < p->height; r++) {
+        memcpy(bricks + r * w, p->bricks + r * p->width, p->width);
+    }
+    memcpy(bricks + p->height * w, row, width);
+    free(p->bricks);
+    p->bricks = bricks, p->width = w, p->height++;
+    return true;
+}
+
+
+bool levelc_read_text(const char *path, struct LevelPattern *p)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) return false;
+
+    unsigned char kinds[256] = { 0 }, row[LEVELC_LINE_MAX];
+    char line[LEVELC_LINE_MAX];
+    bool pattern = false, ok = true;
+    size_t number = 0;
+
+    while (ok && fgets(line, sizeof(line), f)) {
+        number++;
+        line[strcspn(line, "\r\n")] = '\0';
+
+        if (pattern) {
+            size_t width = strlen(line);
+            for (size_t c = 0; c < width; c++) row[c] = kinds[(unsigned char) line[c]];
+            ok = levelc_add_row(p, row, width);
+            continue;
+        }
+
+        char name;
+        unsigned int rgb, hits;
+        if ((line[0] == '#') || (line[strspn(line, " \t")] == '\0')) continue;
+        else if (!strcmp(line, "pattern")) pattern = true;
+        else if (sscanf(line, "cell %f %f", &p->cell.x, &p->cell.y) == 2) continue;
+        else if (sscanf(line, "repeat %zu %zu", &p->across, &p->down) == 2) continue;
+        else if (sscanf(line, "brick %c %x %u", &name, &rgb, &hits) == 3) {
+            ok = (p->num_colours < LEVEL_COLOURS) && hits && (hits <= LEVEL_HITS_MAX);
+            if (!ok) break;
+            p->palette[p->num_colours] = (Color) {
+                (rgb >> 16) & 255, (rgb >> 8) & 255, rgb & 255, 255
+            };
+            kinds[(unsigned char) name] = LEVEL_BRICK(p->num_colours++, hits);
+        }
+        else ok = false;
+    }
+
+    if (!ok) fprintf(stderr, "%s:%zu: could not read \"%s\"\n", path, number, line);
+    fclose(f);
+    return ok;
+}
+
+
+bool levelc_read_image(const char *path, struct LevelPattern *p)
+{
+    Image image = LoadImage(path);
+    Color *pixels = (image.data) ? LoadImageColors(image) : NULL;
+    size_t n = (size_t) image.width * image.height;
+    p->bricks = (pixels) ? malloc(n) : NULL;
+    if (!p->bricks) {
+        if (pixels) UnloadImageColors(pixels);
+        if (image.data) UnloadImage(image);
+        return false;
+    }
+    p->width = image.width, p->height = image.height;
+
+    for (size_t i = 0; i < n; i++) {
+        Color c = pixels[i];
+        if (c.a < 128) {
+            p->bricks[i] = 0;
+            continue;
+        }
+
+        /* the palette entry closest to it, added if there is room */
+        size_t best = 0;
+        int best_d = -1;
+        for (size_t k = 0; k < p->num_colours; k++) {
+            Color q = p->palette[k];
+            int dr = c.r - q.r, dg = c.g - q.g, db = c.b - q.b;
+            int d = dr*dr + dg*dg + db*db;
+            if ((best_d < 0) || (d < best_d)) best = k, best_d = d;
+        }
+        if (best_d && (p->num_colours < LEVEL_COLOURS)) {
+            best = p->num_colours++;
+            p->palette[best] = (Color) { c.r, c.g, c.b, 255 };
+        }
+        p->bricks[i] = LEVEL_BRICK(best, 1);
+    }
+
+    UnloadImageColors(pixels);
+    UnloadImage(image);
+    return true;
+}
+
+
+int main(int argc, char **argv)
+{
+    struct LevelPattern p = { .cell = { 16, 8 }, .across = 1, .down = 1 };
+    Vector2 cell = { 0 };
+    size_t across = 0, down = 0;
+
+    int i = 1;
+    for (; (i + 2 < argc) && !strncmp(argv[i], "--", 2); i += 3) {
+        if (!strcmp(argv[i], "--cell")) {
+            cell = (Vector2) { strtof(argv[i + 1], NULL), strtof(argv[i + 2], NULL) };
+        }
+        else if (!strcmp(argv[i], "--repeat")) {
+            across = strtoul(argv[i + 1], NULL, 10);
+            down = strtoul(argv[i + 2], NULL, 10);
+        }
+        else break;
+    }
+    if (i + 2 != argc) {
+        fprintf(
+            stderr, "usage: %s [--cell W H] [--repeat ACROSS DOWN] input output\n",
+            argv[0]
+        );
+        return 1;
+    }
+
+    const char *input = argv[i], *output = argv[i + 1];
+    size_t len = strlen(input);
+    bool text = (len > 4) && !strcmp(input + len - 4, ".txt");
+    if (!((text) ? levelc_read_text(input, &p) : levelc_read_image(input, &p))) {
+        fprintf(stderr, "%s: could not read %s\n", argv[0], input);
+        free(p.bricks);
+        return 1;
+    }
+    if (cell.x > 0) p.cell = cell;
+    if (across && down) p.across = across, p.down = down;
+
+    size_t cols = p.width * p.across, rows = p.height * p.down;
+    bool ok = p.bricks && level_write(
+        output, cols, rows, p.cell, p.palette, p.num_colours, levelc_brick, &p
+    );
+    free(p.bricks);
+    if (!ok) {
+        fprintf(stderr, "%s: could not write %s\n", argv[0], output);
+        return 1;
+    }
+
+    printf(
+        "%s: %zu x %zu bricks of %g x %g, %zu colours\n", output, cols, rows, p.cell.x,
+        p.cell.y, p.num_colours
+    );
+    return 0;
+}
@@ -1,51 +1,308 @@
 #include <raylib.h>
 #include <raymath.h>
+#include <stdlib.h>
+
+#include "../../common/src/timestep.c"
+#include "bricks.c"
+#include "layer.c"
+#include "level.c"
 
 
 const int WINDOW_WIDTH = 800;
 const int WINDOW_HEIGHT = 600;
+const float BALL_SPEED = 360.0f;
+const float BALL_RADIUS = 6.0f;
+const float PADDLE_W = 100.0f;
+const float PADDLE_H = 12.0f;
+const float PADDLE_SPEED = 480.0f;
+const float PADDLE_INSET = 40.0f;
+const float BRICKS_TOP = 60.0f;
+const float BRICKS_HEIGHT = 240.0f;
+const size_t BRICK_COLUMNS = 16;
+const size_t BRICK_ROWS = 8;
+
+/* a level's brick layer is the window and this much more each way, however large its
+ * bricks, so its texture stays well within GPU limits; see layer.c
+ */
+const float LAYER_MARGIN = 200.0f;
+
+/* bricks a ball may bounce off in one step before the rest of its path is dropped */
+#define BALL_BOUNCES_MAX 4
 
-struct Paddle { Vector2 pos; };
-struct Block { Vector2 pos; bool active; };
+struct Paddle { Vector2 pos; Vector2 prev; };
+struct Ball { Vector2 pos; Vector2 prev; Vector2 vel; };
 
 struct Paddle player = { 0 };
+struct Ball ball = { 0 };
+struct BrickGrid *bricks = NULL;
+struct BrickLayer *layer = NULL;
+struct Level *level = NULL;
 
+/* the field the ball plays in: the window, or a loaded level and the space below it */
+Vector2 world = { 0 };
+Camera2D camera = { .zoom = 1 };
 
-void breakout_draw(void)
+struct FixedStep timestep = { 0 };
+
+
+/* update fns */
+
+
+void update_paddle(struct Paddle *paddle, float dt)
 {
-    BeginDrawing();
+    bool left = IsKeyDown(KEY_LEFT), right = IsKeyDown(KEY_RIGHT);
 
-    ClearBackground(SKYBLUE);
+    paddle->prev = paddle->pos;
+    if (left != right) paddle->pos.x += ((left) ? -1 : 1) * PADDLE_SPEED * dt;
+    paddle->pos.x = Clamp(paddle->pos.x, 0, world.x - PADDLE_W);
+}
 
-    EndDrawing();
+
+/* a hit on the brick at col, row: a level's brick may take several, any other breaks
+ * at once; a broken brick's cell is marked for redrawing
+ */
+void brick_hit(size_t col, size_t row)
+{
+    if (level && !level_hit(level, col, row)) return;
+    if (!level) brickgrid_set(bricks, col, row, false);
+    bricklayer_mark(layer, col, row);
+}
+
+
+/* the ball's path over the step through the bricks: each brick it touches is hit and
+ * the ball carries on, reflected, for what is left of the step
+ */
+void ball_sweep_bricks(struct Ball *ball, struct BrickGrid *bricks, float dt)
+{
+    Vector2 move = Vector2Scale(ball->vel, dt);
+    struct BrickHit hit;
+
+    for (size_t k = 0; k < BALL_BOUNCES_MAX; k++) {
+        Vector2 end = Vector2Add(ball->pos, move);
+        if (!brickgrid_sweep(bricks, ball->pos, end, BALL_RADIUS, &hit)) {
+            ball->pos = end;
+            return;
+        }
+
+        brick_hit(hit.col, hit.row);
+        ball->pos = Vector2Lerp(ball->pos, end, hit.t);
+        move = Vector2Reflect(Vector2Scale(move, 1 - hit.t), hit.normal);
+        ball->vel = Vector2Reflect(ball->vel, hit.normal);
+    }
+}
+
+
+/* off the top of the paddle, at an angle set by how far from its middle it lands */
+bool ball_sweep_paddle(struct Ball *ball, struct Paddle *paddle)
+{
+    float face = paddle->pos.y - BALL_RADIUS;
+    if ((ball->vel.y <= 0) || (ball->prev.y > face) || (ball->pos.y <= face)) {
+        return false;
+    }
+
+    float t = (face - ball->prev.y) / (ball->pos.y - ball->prev.y);
+    float x = Lerp(ball->prev.x, ball->pos.x, t);
+    float left = Lerp(paddle->prev.x, paddle->pos.x, t);
+    if ((x < left - BALL_RADIUS) || (x > left + PADDLE_W + BALL_RADIUS)) return false;
+
+    float offset = Clamp((x - left) / PADDLE_W * 2 - 1, -1, 1);
+    float angle = offset * PI / 3;
+    ball->vel = (Vector2) { BALL_SPEED * sinf(angle), -BALL_SPEED * cosf(angle) };
+    ball->pos = (Vector2) { x, face };
+    return true;
+}
+
+
+/* walls on the left, right and top; out of the bottom */
+bool update_ball(struct Ball *ball, float dt)
+{
+    ball->prev = ball->pos;
+    ball_sweep_bricks(ball, bricks, dt);
+
+    if ((ball->pos.x < BALL_RADIUS) || (ball->pos.x > world.x - BALL_RADIUS)) {
+        ball->pos.x = Clamp(ball->pos.x, BALL_RADIUS, world.x - BALL_RADIUS);
+        ball->vel.x *= -1;
+    }
+    if (ball->pos.y < BALL_RADIUS) {
+        ball->pos.y = BALL_RADIUS;
+        ball->vel.y *= -1;
+    }
+
+    ball_sweep_paddle(ball, &player);
+    return ball->pos.y < world.y + BALL_RADIUS;
+}
+
+
+/* draw fns */
+
+
+void draw_paddle(struct Paddle *paddle, float alpha)
+{
+    Vector2 pos = Vector2Lerp(paddle->prev, paddle->pos, alpha);
+    DrawRectangle(pos.x, pos.y, PADDLE_W, PADDLE_H, WHITE);
 }
 
 
+void draw_ball(struct Ball *ball, float alpha)
+{
+    Vector2 pos = Vector2Lerp(ball->prev, ball->pos, alpha);
+    DrawCircle(pos.x, pos.y, BALL_RADIUS, WHITE);
+}
+
+
+/* breakout fns */
+
+
+void breakout_serve(void)
+{
+    player = (struct Paddle) {
+        .pos = { (world.x - PADDLE_W) / 2, world.y - PADDLE_INSET }
+    };
+    player.prev = player.pos;
+
+    float angle = GetRandomValue(-45, 45) * DEG2RAD;
+    ball = (struct Ball) {
+        .pos = { world.x / 2, world.y - PADDLE_INSET - 4 * BALL_RADIUS },
+        .vel = { BALL_SPEED * sinf(angle), -BALL_SPEED * cosf(angle) }
+    };
+    ball.prev = ball.pos;
+}
+
+
+/* the camera on the ball, kept within the world, and a level's window under it */
+void breakout_focus(void)
+{
+    Vector2 half = { WINDOW_WIDTH / 2.0f, WINDOW_HEIGHT / 2.0f };
+    camera.offset = half;
+    camera.target = (Vector2) {
+        Clamp(ball.pos.x, half.x, fmaxf(half.x, world.x - half.x)),
+        Clamp(ball.pos.y, half.y, fmaxf(half.y, world.y - half.y))
+    };
+    if (!level) return;
+
+    Rectangle view = {
+        camera.target.x - half.x, camera.target.y - half.y, WINDOW_WIDTH, WINDOW_HEIGHT
+    };
+    if (level_focus(level, view)) bricklayer_mark_all(layer);
+    bricklayer_follow(layer, view);
+}
+
+
+void breakout_step(float dt)
+{
+    update_paddle(&player, dt);
+    if (!update_ball(&ball, dt)) breakout_serve();
+    if (!level && !bricks->count) {
+        brickgrid_fill(bricks);
+        bricklayer_mark_all(layer);
+    }
+    breakout_focus();
+}
+
+
+/* spend the frame time in fixed ticks, see common/src/timestep.c */
 void breakout_update(void)
 {
-    return;
+    size_t steps = fixedstep_advance(&timestep, GetFrameTime());
+    for (size_t s = 0; s < steps; s++) breakout_step(timestep.tick);
 }
 
 
-void breakout_initialise(void)
+/* the bricks as one cached quad, redrawn only where they changed, see layer.c */
+void breakout_draw(void)
 {
+    bricklayer_flush(layer);
+
+    BeginDrawing();
+    ClearBackground(SKYBLUE);
+
+    float alpha = fixedstep_alpha(&timestep);
+    BeginMode2D(camera);
+    bricklayer_draw(layer);
+    draw_paddle(&player, alpha);
+    draw_ball(&ball, alpha);
+    EndMode2D();
+
+    DrawText(TextFormat("dirty %zu", layer->last_dirty), 8, 8, 10, WHITE);
+    if (level) {
+        DrawText(
+            TextFormat(
+                "standing %llu, chunks decoded %zu", level->header->standing,
+                level->decoded
+            ),
+            8, 20, 10, WHITE
+        );
+    }
+    EndDrawing();
+}
+
+
+/* the level at path, or else cols x rows bricks filling the window's width,
+ * BRICKS_HEIGHT deep; either way with the paddle's space below
+ */
+bool breakout_initialise(double tick_rate, const char *path, size_t cols, size_t rows)
+{
+    Vector2 origin = { 0, BRICKS_TOP }, field;
+    if (path) {
+        level = level_open(path, origin, (Vector2) { WINDOW_WIDTH, WINDOW_HEIGHT });
+        if (!level) return false;
+
+        const struct LevelHeader *h = level->header;
+        bricks = level->grid;
+        world = (Vector2) {
+            fmaxf(WINDOW_WIDTH, h->cols * h->cell_width),
+            WINDOW_HEIGHT - BRICKS_HEIGHT + h->rows * h->cell_height
+        };
+        field = (Vector2) {
+            WINDOW_WIDTH + 2 * LAYER_MARGIN, WINDOW_HEIGHT + 2 * LAYER_MARGIN
+        };
+    }
+    else {
+        Vector2 cell = { (float) WINDOW_WIDTH / cols, BRICKS_HEIGHT / rows };
+        bricks = brickgrid_create(cols, rows, origin, cell);
+        if (!bricks) return false;
+
+        brickgrid_fill(bricks);
+        world = (Vector2) { WINDOW_WIDTH, WINDOW_HEIGHT };
+        field = (Vector2) { WINDOW_WIDTH, BRICKS_HEIGHT };
+    }
+
+    timestep = fixedstep_create(tick_rate, TIMESTEP_MAX_STEPS_DEFAULT);
+
     InitWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "Breakout");
+    SetExitKey(KEY_Q);
+    layer = bricklayer_create(
+        bricks, field, SKYBLUE, (level) ? level_colour : NULL, level
+    );
+    if (!layer) return false;
+
+    breakout_serve();
+    breakout_focus();
+    return true;
 }
 
 
 void breakout_deinitialise(void)
 {
+    bricklayer_destroy(layer);
     CloseWindow();
+    if (level) level_close(level);
+    else brickgrid_destroy(bricks);
 }
 
 
-int main(void)
+/* breakout [tick rate] [columns rows | level], levels made by breakout-levelc */
+int main(int argc, char **argv)
 {
-    breakout_initialise();
+    const char *path = (argc == 3) ? argv[2] : NULL;
+    size_t cols = (argc > 3) ? strtoul(argv[2], NULL, 10) : BRICK_COLUMNS;
+    size_t rows = (argc > 3) ? strtoul(argv[3], NULL, 10) : BRICK_ROWS;
+    double rate = fixedstep_rate_arg(argc, argv, 1);
+    if (!breakout_initialise(rate, path, cols, rows)) return 1;
 
     while (!WindowShouldClose()) {
-        breakout_draw();
         breakout_update();
+        breakout_draw();
     }
 
     breakout_deinitialise();
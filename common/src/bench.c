@@ -0,0 +1,167 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/*  benchmark harness
+ *      a kernel is run once to warm caches and branch predictors, then timed over a
+ *      number of repetitions; the fastest repetition is reported as the least disturbed
+ *      measurement, alongside the mean
+ *
+ *      results can be saved as json and checked against a baseline saved the same way:
+ *      a kernel more than BENCH_TOLERANCE slower than its baseline is a regression
+ */
+
+#define BENCH_TOLERANCE 0.25
+#define BENCH_NAME_MAX 64
+
+struct BenchResult
+{
+    const char *name;
+    size_t ops;
+    double best;
+    double mean;
+};
+
+
+double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+
+/* time reps calls of kernel(ctx), each of which performs ops operations */
+struct BenchResult bench_run
+(
+    const char *name, void (*kernel)(void *), void *ctx, size_t ops, size_t reps
+)
+{
+    struct BenchResult res = { .name = name, .ops = ops, .best = 0, .mean = 0 };
+    if (!kernel || !reps) return res;
+
+    kernel(ctx);
+
+    double total = 0;
+    for (size_t r = 0; r < reps; r++) {
+        double t0 = bench_now();
+        kernel(ctx);
+        double t = bench_now() - t0;
+
+        total += t;
+        if (!r || (t < res.best)) res.best = t;
+    }
+    res.mean = total / reps;
+
+    return res;
+}
+
+
+double bench_ns_per_op(struct BenchResult res)
+{
+    return (res.ops) ? 1e9 * res.best / res.ops : 0;
+}
+
+
+double bench_mops(struct BenchResult res)
+{
+    return (res.best > 0) ? 1e-6 * res.ops / res.best : 0;
+}
+
+
+void bench_report(struct BenchResult res)
+{
+    printf(
+        "%-36s %10.2f ns/op %10.2f Mop/s  (mean %.3f ms)\n",
+        res.name,
+        bench_ns_per_op(res),
+        bench_mops(res),
+        1e3 * res.mean
+    );
+}
+
+
+/* one benchmark per line, in the form bench_compare reads back */
+bool bench_json(const char *path, const struct BenchResult *results, size_t n)
+{
+    FILE *f = fopen(path, "w");
+    if (!f) return false;
+
+    fprintf(f, "[\n");
+    for (size_t i = 0; i < n; i++) {
+        fprintf(
+            f,
+            "  {\"name\": \"%s\", \"ns_per_op\": %.4f, \"mops\": %.4f, "
+            "\"ops\": %zu}%s\n",
+            results[i].name + strspn(results[i].name, " "),
+            bench_ns_per_op(results[i]), bench_mops(results[i]), results[i].ops,
+            (i + 1 < n) ? "," : ""
+        );
+    }
+    fprintf(f, "]\n");
+
+    return !fclose(f);
+}
+
+
+/* report each result against the baseline at path, returns the number of regressions;
+ * kernels missing from the baseline (or a missing baseline) are not compared
+ */
+size_t bench_compare(const char *path, const struct BenchResult *results, size_t n)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        printf("no baseline at %s\n", path);
+        return 0;
+    }
+
+    size_t regressions = 0;
+    char line[256], name[BENCH_NAME_MAX];
+    double base;
+    while (fgets(line, sizeof(line), f)) {
+        if (
+            sscanf(line, " {\"name\": \"%63[^\"]\", \"ns_per_op\": %lf", name, &base)
+            != 2
+        ) continue;
+
+        for (size_t i = 0; i < n; i++) {
+            if (strcmp(name, results[i].name + strspn(results[i].name, " "))) continue;
+
+            double ns = bench_ns_per_op(results[i]);
+            bool slow = (ns > base * (1 + BENCH_TOLERANCE));
+            printf(
+                "%-36s %10.2f ns/op  baseline %10.2f  %+7.1f%%%s\n",
+                name, ns, base, (base > 0) ? 100 * (ns / base - 1) : 0,
+                (slow) ? "  REGRESSION" : ""
+            );
+            regressions += slow;
+        }
+    }
+
+    fclose(f);
+    return regressions;
+}
+
+
+/*  bench [results.json [baseline.json]]
+ *      saves results where asked, and fails if any regressed against the baseline
+ */
+bool bench_finish(int argc, char **argv, const struct BenchResult *results, size_t n)
+{
+    if ((argc > 1) && !bench_json(argv[1], results, n)) {
+        fprintf(stderr, "%s: could not write %s\n", argv[0], argv[1]);
+        return false;
+    }
+    if (argc > 2) {
+        size_t regressions = bench_compare(argv[2], results, n);
+        if (regressions) {
+            fprintf(
+                stderr, "%s: %zu kernels regressed by more than %.0f%%\n",
+                argv[0], regressions, 100 * BENCH_TOLERANCE
+            );
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,186 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/*  job pool
+ *      a fixed set of worker threads which, together with the calling thread, run
+ *      range jobs: [0, n) is cut into chunks that workers claim from a shared cursor
+ *      until none are left, so a worker that finishes early picks up the slack of a
+ *      slow one. jobs_run returns once every chunk is done
+ *
+ *      workers are numbered 0 (the caller) to num_workers - 1, so a job can keep
+ *      scratch per worker without locking
+ */
+
+#define JOBS_WORKERS_MAX 64
+
+
+struct JobPool;
+
+
+struct JobWorker
+{
+    struct JobPool *pool;
+    size_t index;
+};
+
+
+struct JobPool
+{
+    pthread_t *threads;
+    struct JobWorker *workers;
+    size_t num_workers;
+    size_t num_threads;
+
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t idle;
+    size_t generation;
+    size_t busy;
+    bool quit;
+
+    void (*func)(void *ctx, size_t begin, size_t end, size_t worker);
+    void *ctx;
+    size_t n;
+    size_t chunk;
+    atomic_size_t cursor;
+};
+
+
+/* claim and run chunks of the current job until it is exhausted */
+void jobs_drain(struct JobPool *pool, size_t worker)
+{
+    for (;;) {
+        size_t begin = atomic_fetch_add(&pool->cursor, pool->chunk);
+        if (begin >= pool->n) return;
+
+        size_t end = (begin + pool->chunk < pool->n) ? begin + pool->chunk : pool->n;
+        pool->func(pool->ctx, begin, end, worker);
+    }
+}
+
+
+void *jobs_worker(void *arg)
+{
+    struct JobWorker *w = arg;
+    struct JobPool *pool = w->pool;
+    size_t seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->quit && (pool->generation == seen)) {
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        }
+        if (pool->quit) break;
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        jobs_drain(pool, w->index);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->busy == 0) pthread_cond_signal(&pool->idle);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+
+void jobs_destroy(struct JobPool *pool)
+{
+    if (!pool) return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->quit = true;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (size_t t = 0; t < pool->num_threads; t++) pthread_join(pool->threads[t], NULL);
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->wake);
+    pthread_cond_destroy(&pool->idle);
+    if (pool->threads) free(pool->threads);
+    if (pool->workers) free(pool->workers);
+    free(pool);
+}
+
+
+/* a pool of num_workers, counting the caller; 0 picks one per online cpu */
+struct JobPool *jobs_create(size_t num_workers)
+{
+    if (!num_workers) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        num_workers = (cpus > 0) ? cpus : 1;
+    }
+    if (num_workers > JOBS_WORKERS_MAX) num_workers = JOBS_WORKERS_MAX;
+
+    struct JobPool *pool = malloc(sizeof(struct JobPool));
+    if (!pool) return NULL;
+
+    *pool = (struct JobPool) { .num_workers = num_workers };
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->idle, NULL);
+    atomic_init(&pool->cursor, 0);
+
+    pool->threads = malloc(num_workers * sizeof(pthread_t));
+    pool->workers = malloc(num_workers * sizeof(struct JobWorker));
+    if (!pool->threads || !pool->workers) {
+        jobs_destroy(pool);
+        return NULL;
+    }
+
+    for (size_t w = 1; w < num_workers; w++) {
+        struct JobWorker *worker = pool->workers + w;
+        *worker = (struct JobWorker) { .pool = pool, .index = w };
+        if (pthread_create(pool->threads + w - 1, NULL, jobs_worker, worker)) {
+            jobs_destroy(pool);
+            return NULL;
+        }
+        pool->num_threads++;
+    }
+
+    return pool;
+}
+
+
+/* run func over [0, n) in chunks across the pool, and wait for it to finish */
+void jobs_run
+(
+    struct JobPool *pool, void (*func)(void *, size_t, size_t, size_t), void *ctx,
+    size_t n, size_t chunk
+)
+{
+    if (!n) return;
+    if (!chunk) chunk = 1;
+
+    if (!pool || (pool->num_workers < 2) || (n <= chunk)) {
+        func(ctx, 0, n, 0);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->func = func, pool->ctx = ctx, pool->n = n, pool->chunk = chunk;
+    atomic_store(&pool->cursor, 0);
+    pool->busy = pool->num_threads;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    jobs_drain(pool, 0);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->busy) pthread_cond_wait(&pool->idle, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+
+/* worker count from a command line argument, or 0 (one per cpu) */
+size_t jobs_workers_arg(int argc, char **argv, int index)
+{
+    if (index >= argc) return 0;
+    return strtoul(argv[index], NULL, 10);
+}
@@ -1,6 +0,0 @@
-#include "physics.c"
-
-int main(void)
-{
-    return 0;
-}
@@ -1,45 +1,47 @@
+#include <math.h>
 #include <raylib.h>
 #include <raymath.h>
+#include <stdlib.h>
+#include <string.h>
 
-/* Geometry */
+#include "physics.h"
 
-struct Polygon
-{
-    Vector2 *vertices;
-    size_t len;
-};
+/* Geometry */
 
 
-void polygon_clear(struct Polygon *polygon)
+static inline float vector2_dot(Vector2 v1, Vector2 v2)
 {
-    if (!polygon) return;
-    free(polygon->vertices);
-    polygon->vertices = NULL;
-    polygon->len = 0;
+    return (v1.x * v2.x) + (v1.y * v2.y);
 }
 
 
-bool polygon_is_null(struct Polygon *polygon)
+static inline float vector2_cross(Vector2 v1, Vector2 v2)
 {
-    return (!polygon || !polygon->vertices || !polygon->len);
+    return (v1.x * v2.y) - (v1.y * v2.x);
 }
 
 
-float vector2_dot(Vector2 v1, Vector2 v2)
+static inline Vector2 vector2_wrap(Vector2 vec, const Vector2 min, const Vector2 max)
 {
-    return (v1.x * v2.x) + (v1.y * v2.y);
+    Vector2 res = vec;
+    if (res.x < min.x) res.x = max.x;
+    if (res.y < min.y) res.y = max.y;
+    if (res.x > max.x) res.x = min.x;
+    if (res.y > max.y) res.y = min.y;
+    return res;
 }
 
 
-float vector2_cross(Vector2 v1, Vector2 v2)
+static bool polygon_is_null(const struct Polygon *polygon)
 {
-    return (v1.x * v2.y) - (v1.y * v2.x);
+    return (!polygon || !polygon->vertices || !polygon->len);
 }
 
 
-float polygon_area_moment_0(struct Polygon *polyon)
+/* twice the signed area, positive for anticlockwise vertices */
+static float polygon_area_moment_0(const struct Polygon *polygon)
 {
-    if (polygon_is_null()) return 0;
+    if (polygon_is_null(polygon)) return 0;
 
     float area = 0;
     Vector2 curr = { 0 }, next = polygon->vertices[0];
@@ -52,9 +54,10 @@ float polygon_area_moment_0(struct Polygon *polyon)
 }
 
 
-Vector2 polygon_area_moment_1(struct Polygon *polygon)
+/* centroid */
+static Vector2 polygon_area_moment_1(const struct Polygon *polygon)
 {
-    if (polygon_is_null()) return (Vector2) { 0, 0 };
+    if (polygon_is_null(polygon)) return (Vector2) { 0, 0 };
 
     Vector2 moment_1 = { 0 };
     float factor = 0, denominator = 0;
@@ -72,9 +75,10 @@ Vector2 polygon_area_moment_1(struct Polygon *polygon)
 }
 
 
-float polygon_area_moment_2(struct Polygon *polygon)
+/* second moment about the origin, per unit area */
+static float polygon_area_moment_2(const struct Polygon *polygon)
 {
-    if (polygon_is_null()) return 0;
+    if (polygon_is_null(polygon)) return 0;
 
     float moment_2 = 0;
     float factor = 0, denominator = 0;
@@ -88,18 +92,515 @@ float polygon_area_moment_2(struct Polygon *polygon)
         );
         denominator += factor;
     }
-    
+
     return moment_2 / (6*denominator);
 }
 
 
-struct PhysicsBody
+#include "integrate.c"
+
+
+/* World */
+
+
+void physics_world_destroy(struct PhysicsWorld *world)
+{
+    if (!world) return;
+    if (world->position) free(world->position);
+    if (world->prev_position) free(world->prev_position);
+    if (world->velocity) free(world->velocity);
+    if (world->rotation) free(world->rotation);
+    if (world->spin) free(world->spin);
+    if (world->radius) free(world->radius);
+    if (world->inv_mass) free(world->inv_mass);
+    if (world->inv_moi) free(world->inv_moi);
+    if (world->alive) free(world->alive);
+    if (world->contacts) free(world->contacts);
+    if (world->order) free(world->order);
+    if (world->cache) free(world->cache);
+    if (world->points) free(world->points);
+    free(world);
+}
+
+
+/* resize one array, keeping the old one if that fails */
+static bool physics_realloc(void **array, size_t size)
+{
+    void *p = realloc(*array, size);
+    if (!p) return false;
+
+    *array = p;
+    return true;
+}
+
+
+/* room for max bodies in all, never shrinking */
+bool physics_world_reserve(struct PhysicsWorld *world, size_t max)
+{
+    if (max <= world->max) return true;
+
+    if (
+        !physics_realloc((void **) &world->position, max * sizeof(Vector2)) ||
+        !physics_realloc((void **) &world->prev_position, max * sizeof(Vector2)) ||
+        !physics_realloc((void **) &world->velocity, max * sizeof(Vector2)) ||
+        !physics_realloc((void **) &world->rotation, max * sizeof(float)) ||
+        !physics_realloc((void **) &world->spin, max * sizeof(float)) ||
+        !physics_realloc((void **) &world->radius, max * sizeof(float)) ||
+        !physics_realloc((void **) &world->inv_mass, max * sizeof(float)) ||
+        !physics_realloc((void **) &world->inv_moi, max * sizeof(float)) ||
+        !physics_realloc((void **) &world->alive, max * sizeof(bool)) ||
+        !physics_realloc(
+            (void **) &world->order, max * sizeof(struct PhysicsInterval)
+        )
+    ) return false;
+
+    world->max = max;
+    return true;
+}
+
+
+/* a world with room for max bodies to begin with, it grows as needed */
+struct PhysicsWorld *physics_world_create(size_t max, Vector2 size)
+{
+    struct PhysicsWorld *world = malloc(sizeof(struct PhysicsWorld));
+    if (!world) return NULL;
+
+    *world = (struct PhysicsWorld) {
+        .size = size,
+        .solver = {
+            .iterations = PHYSICS_ITERATIONS,
+            .baumgarte = PHYSICS_BAUMGARTE
+        }
+    };
+    if (!physics_world_reserve(world, (max) ? max : PHYSICS_CAPACITY_MIN)) {
+        physics_world_destroy(world);
+        return NULL;
+    }
+
+    return world;
+}
+
+
+/* add a body at dense index len, returned; world->max if the world could not grow */
+size_t physics_body_create(struct PhysicsWorld *world, const struct PhysicsBody *def)
+{
+    if (world->len == world->max) {
+        if (!physics_world_reserve(world, 2 * world->max)) return world->max;
+    }
+
+    /* about the hull's centroid, by the parallel axis theorem for the inertia */
+    float radius = def->radius, mass = def->mass, moi = def->moi;
+    if (!polygon_is_null(def->hull)) {
+        Vector2 centroid = polygon_area_moment_1(def->hull);
+        radius = 0;
+        for (size_t k = 0; k < def->hull->len; k++) {
+            Vector2 v = Vector2Subtract(def->hull->vertices[k], centroid);
+            radius = fmaxf(radius, Vector2Length(v));
+        }
+        if (!mass) mass = fabsf(polygon_area_moment_0(def->hull)) / 2;
+        if (!moi) {
+            moi = mass * (
+                polygon_area_moment_2(def->hull) - Vector2LengthSqr(centroid)
+            );
+        }
+    }
+
+    size_t i = world->len++;
+    world->position[i] = def->position;
+    world->prev_position[i] = def->position;
+    world->velocity[i] = def->velocity;
+    world->rotation[i] = def->rotation;
+    world->spin[i] = def->spin;
+    world->radius[i] = radius;
+    world->inv_mass[i] = (mass > 0) ? 1 / mass : 0;
+    world->inv_moi[i] = (moi > 0) ? 1 / moi : 0;
+    world->alive[i] = true;
+
+    return i;
+}
+
+
+bool physics_body_alive(const struct PhysicsWorld *world, size_t i)
+{
+    return world && (i < world->len) && world->alive[i];
+}
+
+
+/* mark body i dead, it stays in place until the next physics_world_compact */
+void physics_body_destroy(struct PhysicsWorld *world, size_t i)
+{
+    if (!physics_body_alive(world, i)) return;
+    world->alive[i] = false;
+    world->num_dead++;
+}
+
+
+/* close the gaps left by destroyed bodies, keeping the live ones in order; cached
+ * contacts follow their bodies, or go with them
+ */
+void physics_world_compact(struct PhysicsWorld *world)
+{
+    if (!world || !world->num_dead) return;
+
+    /* order doubles as the map from old index to new, len for the dead */
+    size_t w = 0;
+    for (size_t r = 0; r < world->len; r++) {
+        world->order[r].i = (world->alive[r]) ? w : world->len;
+        if (!world->alive[r]) continue;
+
+        if (w != r) {
+            world->position[w] = world->position[r];
+            world->prev_position[w] = world->prev_position[r];
+            world->velocity[w] = world->velocity[r];
+            world->rotation[w] = world->rotation[r];
+            world->spin[w] = world->spin[r];
+            world->radius[w] = world->radius[r];
+            world->inv_mass[w] = world->inv_mass[r];
+            world->inv_moi[w] = world->inv_moi[r];
+            world->alive[w] = true;
+        }
+        w++;
+    }
+
+    /* the map keeps the order, so the cache stays sorted */
+    size_t kept = 0;
+    for (size_t k = 0; k < world->num_cached; k++) {
+        struct PhysicsManifold m = world->cache[k];
+        m.a = world->order[m.a].i, m.b = world->order[m.b].i;
+        if ((m.a == world->len) || (m.b == world->len)) continue;
+        world->cache[kept++] = m;
+    }
+    world->num_cached = kept;
+
+    world->len = w;
+    world->num_dead = 0;
+}
+
+
+/* advance every body by dt, wrapping round the world's torus if it has a size */
+void physics_world_step(struct PhysicsWorld *world, float dt)
 {
-    struct Polygon *hull;
-    Vector2 position;
-    Vector2 velocity;
-    float   mass;
-    float   rotation;
-    float   spin;
-    float   moi;
-};
+    if (!world) return;
+
+    if ((world->size.x > 0) && (world->size.y > 0)) {
+        physics_integrate_wrap(
+            world->position, world->prev_position, world->velocity, world->radius,
+            world->rotation, world->spin, world->len, dt, world->size
+        );
+        return;
+    }
+
+    for (size_t i = 0; i < world->len; i++) {
+        world->prev_position[i] = world->position[i];
+        world->position[i] = Vector2Add(
+            world->position[i], Vector2Scale(world->velocity[i], dt)
+        );
+        world->rotation[i] += world->spin[i] * dt;
+    }
+}
+
+
+/* Contacts */
+
+
+/* offset which moves q to the image nearest p, on a torus of size (if any) */
+static Vector2 physics_image_offset(Vector2 size, Vector2 p, Vector2 q)
+{
+    Vector2 offset = { 0, 0 };
+    if ((size.x <= 0) || (size.y <= 0)) return offset;
+
+    Vector2 d = Vector2Subtract(q, p);
+    if (d.x > size.x / 2) offset.x = -size.x;
+    if (d.x < -size.x / 2) offset.x = size.x;
+    if (d.y > size.y / 2) offset.y = -size.y;
+    if (d.y < -size.y / 2) offset.y = size.y;
+
+    return offset;
+}
+
+
+static bool physics_contact_push(struct PhysicsWorld *world, size_t a, size_t b)
+{
+    Vector2 pa = world->position[a], pb = world->position[b];
+    pb = Vector2Add(pb, physics_image_offset(world->size, pa, pb));
+
+    Vector2 d = Vector2Subtract(pb, pa);
+    float reach = world->radius[a] + world->radius[b], dist = Vector2Length(d);
+    if (dist >= reach) return true;
+
+    if (world->num_contacts == world->max_contacts) {
+        size_t max = (world->max_contacts) ? 2 * world->max_contacts : world->max;
+        void *p = world->contacts;
+        if (!physics_realloc(&p, max * sizeof(struct PhysicsContact))) return false;
+        world->contacts = p, world->max_contacts = max;
+    }
+
+    if (a > b) {
+        size_t t = a;
+        a = b, b = t, d = Vector2Negate(d);
+    }
+    world->contacts[world->num_contacts++] = (struct PhysicsContact) {
+        .a = a, .b = b, .depth = reach - dist,
+        .normal = (dist > 0) ? Vector2Scale(d, 1 / dist) : (Vector2) { 1, 0 }
+    };
+    return true;
+}
+
+
+static int physics_interval_compare(const void *p, const void *q)
+{
+    const struct PhysicsInterval *u = p, *v = q;
+    if (u->lo != v->lo) return (u->lo < v->lo) ? -1 : 1;
+    if (u->i != v->i) return (u->i < v->i) ? -1 : 1;
+    return 0;
+}
+
+
+static int physics_contact_compare(const void *p, const void *q)
+{
+    const struct PhysicsContact *c = p, *d = q;
+    if (c->a != d->a) return (c->a < d->a) ? -1 : 1;
+    if (c->b != d->b) return (c->b < d->b) ? -1 : 1;
+    return 0;
+}
+
+
+/*  pairs of live bodies whose bounding circles overlap, as of the last step, sorted
+ *  by (a, b) with a < b; the array stays valid until the next call
+ *
+ *  sort and sweep on x: bodies are ordered by the left edge of their bounds and each
+ *  is tested only against those starting before its right edge ends. on a torus each
+ *  is also swept against the start of the order shifted a world width right, to
+ *  catch pairs across the seam, so the world should be at least twice the widest
+ *  body across
+ */
+size_t physics_world_contacts
+(
+    struct PhysicsWorld *world, const struct PhysicsContact **contacts
+)
+{
+    *contacts = NULL;
+    if (!world) return 0;
+
+    world->num_contacts = 0;
+    size_t n = 0;
+    for (size_t i = 0; i < world->len; i++) {
+        if (!world->alive[i]) continue;
+        float lo = world->position[i].x - world->radius[i];
+        world->order[n++] = (struct PhysicsInterval) { .lo = lo, .i = i };
+    }
+    if (n > 1) {
+        qsort(
+            world->order, n, sizeof(struct PhysicsInterval), physics_interval_compare
+        );
+    }
+
+    float width = (world->size.y > 0) ? world->size.x : 0;
+    for (size_t k = 0; k < n; k++) {
+        size_t a = world->order[k].i;
+        float hi = world->position[a].x + world->radius[a];
+
+        for (size_t m = k + 1; (m < n) && (world->order[m].lo <= hi); m++) {
+            if (!physics_contact_push(world, a, world->order[m].i)) return 0;
+        }
+
+        /* the images one width to the right of the bodies at the start */
+        if (!(width > 0) || (world->order[0].lo + width > hi)) continue;
+        for (size_t m = 0; (m < k) && (world->order[m].lo + width <= hi); m++) {
+            if (!physics_contact_push(world, a, world->order[m].i)) return 0;
+        }
+    }
+
+    if (world->num_contacts > 1) {
+        qsort(
+            world->contacts, world->num_contacts, sizeof(struct PhysicsContact),
+            physics_contact_compare
+        );
+    }
+
+    *contacts = world->contacts;
+    return world->num_contacts;
+}
+
+
+/* Solver */
+
+
+/* velocity of the point at r from body i's centre */
+static inline Vector2 physics_point_velocity
+(
+    struct PhysicsWorld *world, size_t i, Vector2 r
+)
+{
+    float w = world->spin[i];
+    return Vector2Add(world->velocity[i], (Vector2) { -w * r.y, w * r.x });
+}
+
+
+/* apply impulse p at r from a's centre to a, and its opposite to b */
+static inline void physics_apply_impulse
+(
+    struct PhysicsWorld *world, size_t a, size_t b, Vector2 ra, Vector2 rb, Vector2 p
+)
+{
+    world->velocity[a] = Vector2Subtract(
+        world->velocity[a], Vector2Scale(p, world->inv_mass[a])
+    );
+    world->spin[a] -= world->inv_moi[a] * vector2_cross(ra, p);
+    world->velocity[b] = Vector2Add(
+        world->velocity[b], Vector2Scale(p, world->inv_mass[b])
+    );
+    world->spin[b] += world->inv_moi[b] * vector2_cross(rb, p);
+}
+
+
+/* the first cached manifold for pair (a, b), searching on from *c, or NULL; both
+ * lists are sorted, so matching a whole solve's pairs is one merged pass
+ */
+static const struct PhysicsManifold *physics_cache_find
+(
+    const struct PhysicsWorld *world, size_t *c, size_t a, size_t b
+)
+{
+    for (; *c < world->num_cached; (*c)++) {
+        const struct PhysicsManifold *m = world->cache + *c;
+        if ((m->a > a) || ((m->a == a) && (m->b > b))) return NULL;
+        if ((m->a == a) && (m->b == b)) return m;
+    }
+    return NULL;
+}
+
+
+/* replace the cached contacts with a copy of manifolds, sorted by (a, b) as
+ * physics_world_solve leaves them; false if there was no room, leaving none cached
+ */
+bool physics_world_cache
+(
+    struct PhysicsWorld *world, const struct PhysicsManifold *manifolds, size_t n
+)
+{
+    world->num_cached = 0;
+    if (n > world->max_cached) {
+        void *p = world->cache;
+        if (!physics_realloc(&p, n * sizeof(struct PhysicsManifold))) return false;
+        world->cache = p, world->max_cached = n;
+    }
+
+    if (n) memcpy(world->cache, manifolds, n * sizeof(struct PhysicsManifold));
+    world->num_cached = n;
+    return true;
+}
+
+
+/*  resolve n contacts, sorted by (a, b) with a < b, at the end of a step of dt; a
+ *  pair may have several, as long as their features differ
+ *
+ *      warm start: each point takes the impulse cached for its pair and feature, and
+ *      it is applied up front, so a resting stack starts close to its solution
+ *
+ *      each iteration then visits every point in order, nudging its accumulated
+ *      impulse towards the one which brings the normal speed to the point's bias,
+ *      never below zero. the bias is a bounce, restitution times the approach speed
+ *      when that is above rest_speed, or else a push of baumgarte/dt times the depth
+ *      beyond slop, so overlaps are worked out over a few steps (baumgarte's method)
+ *
+ *      the impulses are left in the manifolds and cached for the next solve; false if
+ *      the cache could not grow, so the next solve starts cold
+ */
+bool physics_world_solve
+(
+    struct PhysicsWorld *world, struct PhysicsManifold *manifolds, size_t n, float dt
+)
+{
+    if (!world) return false;
+    if (!n) return physics_world_cache(world, NULL, 0);
+
+    size_t num_points = n * PHYSICS_MANIFOLD_POINTS;
+    if (num_points > world->max_points) {
+        void *p = world->points;
+        if (!physics_realloc(&p, num_points * sizeof(struct PhysicsPoint))) {
+            return false;
+        }
+        world->points = p, world->max_points = num_points;
+    }
+
+    const struct PhysicsSolver *solver = &world->solver;
+    struct PhysicsPoint *points = world->points;
+
+    size_t c = 0;
+    for (size_t k = 0; k < n; k++) {
+        struct PhysicsManifold *m = manifolds + k;
+        size_t a = m->a, b = m->b;
+        Vector2 centre_b = Vector2Add(world->position[b], m->offset);
+        const struct PhysicsManifold *old = physics_cache_find(world, &c, a, b);
+
+        for (size_t q = 0; q < m->num_points; q++) {
+            struct PhysicsPoint *p = points + k*PHYSICS_MANIFOLD_POINTS + q;
+            p->ra = Vector2Subtract(m->points[q], world->position[a]);
+            p->rb = Vector2Subtract(m->points[q], centre_b);
+
+            float rna = vector2_cross(p->ra, m->normal);
+            float rnb = vector2_cross(p->rb, m->normal);
+            float k_normal = (
+                world->inv_mass[a] + world->inv_mass[b] +
+                world->inv_moi[a] * rna * rna + world->inv_moi[b] * rnb * rnb
+            );
+            p->mass = (k_normal > 0) ? 1 / k_normal : 0;
+
+            Vector2 dv = Vector2Subtract(
+                physics_point_velocity(world, b, p->rb),
+                physics_point_velocity(world, a, p->ra)
+            );
+            float vn = vector2_dot(dv, m->normal);
+            float bounce = (-vn > solver->rest_speed) ? -solver->restitution * vn : 0;
+            float push = (
+                solver->baumgarte / dt * fmaxf(m->depths[q] - solver->slop, 0)
+            );
+            p->bias = fmaxf(bounce, push);
+
+            /* over every manifold the pair had, as a pair may have several */
+            m->impulse[q] = 0;
+            const struct PhysicsManifold *end = world->cache + world->num_cached;
+            for (const struct PhysicsManifold *o = old; o && (o < end); o++) {
+                if ((o->a != a) || (o->b != b)) break;
+                for (size_t r = 0; r < o->num_points; r++) {
+                    if (o->features[r] == m->features[q]) m->impulse[q] = o->impulse[r];
+                }
+            }
+        }
+    }
+
+    /* only once every bias is taken from the velocities as they came in */
+    for (size_t k = 0; k < n; k++) {
+        struct PhysicsManifold *m = manifolds + k;
+        for (size_t q = 0; q < m->num_points; q++) {
+            struct PhysicsPoint *p = points + k*PHYSICS_MANIFOLD_POINTS + q;
+            physics_apply_impulse(
+                world, m->a, m->b, p->ra, p->rb, Vector2Scale(m->normal, m->impulse[q])
+            );
+        }
+    }
+
+    for (size_t it = 0; it < solver->iterations; it++) {
+        for (size_t k = 0; k < n; k++) {
+            struct PhysicsManifold *m = manifolds + k;
+            for (size_t q = 0; q < m->num_points; q++) {
+                struct PhysicsPoint *p = points + k*PHYSICS_MANIFOLD_POINTS + q;
+                Vector2 dv = Vector2Subtract(
+                    physics_point_velocity(world, m->b, p->rb),
+                    physics_point_velocity(world, m->a, p->ra)
+                );
+                float vn = vector2_dot(dv, m->normal);
+
+                float total = fmaxf(m->impulse[q] + p->mass * (p->bias - vn), 0);
+                float delta = total - m->impulse[q];
+                m->impulse[q] = total;
+                physics_apply_impulse(
+                    world, m->a, m->b, p->ra, p->rb, Vector2Scale(m->normal, delta)
+                );
+            }
+        }
+    }
+
+    return physics_world_cache(world, manifolds, n);
+}
@@ -0,0 +1,190 @@
+#ifndef MINIPHYS_H
+#define MINIPHYS_H
+
+#include <raylib.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*  miniphys
+ *      a small rigid body library, built from physics.c into libminiphys.a; games
+ *      include this header and link against it
+ *
+ *      a world keeps its bodies as a structure of arrays, dense in [0, len), so a step
+ *      is one pass over contiguous memory. bodies are named by their dense index: a
+ *      destroyed body stays in place, skipped, until physics_world_compact closes the
+ *      gaps in order, so owners keeping parallel arrays can compact them alongside
+ *
+ *      a world with a size wraps its bodies around that torus, by the rule of
+ *      physics_integrate_wrap_scalar; a size of zero leaves them unbounded
+ *
+ *      contacts found by the owner's narrowphase are resolved by physics_world_solve,
+ *      a sequential impulse solver: each contact point's impulse is accumulated over
+ *      a fixed number of iterations, clamped so it only ever pushes, and kept for the
+ *      next step; a point found again (same pair, same feature) starts from it. a
+ *      pair may have a manifold per pair of convex parts touching, told apart by
+ *      their features
+ */
+
+#define PHYSICS_CAPACITY_MIN 16
+#define PHYSICS_INTEGRATE_TOLERANCE 1e-4f
+#define PHYSICS_MANIFOLD_POINTS 2
+#define PHYSICS_ITERATIONS 8
+#define PHYSICS_BAUMGARTE 0.2f
+
+
+struct Polygon
+{
+    Vector2 *vertices;
+    size_t len;
+};
+
+
+/* a body to create: a hull gives the radius about its centroid, and the mass and
+ * moment of inertia (at unit density) when those are zero; without one radius is used
+ * as is. position is the centroid's
+ */
+struct PhysicsBody
+{
+    struct Polygon *hull;
+    Vector2 position;
+    Vector2 velocity;
+    float   mass;
+    float   rotation;
+    float   spin;
+    float   moi;
+    float   radius;
+};
+
+
+/* a pair whose bounding circles overlap, normal from a to b */
+struct PhysicsContact
+{
+    size_t a;
+    size_t b;
+    Vector2 normal;
+    float depth;
+};
+
+
+/* a body's extent along x, sorted to find contacts */
+struct PhysicsInterval
+{
+    float lo;
+    size_t i;
+};
+
+
+/*  a touching pair from the owner's narrowphase, b displaced by offset (its image
+ *  nearest a on a torus), normal from a to b; points and depths are the contact
+ *  points in world space and how far each is inside the other body
+ *
+ *  features name each point's vertex and edge pairing, stable from step to step
+ *  while the bodies stay in touch, and impulse is the solver's accumulated impulse
+ *  along the normal at each point
+ */
+struct PhysicsManifold
+{
+    size_t a;
+    size_t b;
+    Vector2 offset;
+    Vector2 normal;
+    Vector2 points[PHYSICS_MANIFOLD_POINTS];
+    float depths[PHYSICS_MANIFOLD_POINTS];
+    unsigned int features[PHYSICS_MANIFOLD_POINTS];
+    float impulse[PHYSICS_MANIFOLD_POINTS];
+    size_t num_points;
+};
+
+
+/*  solver settings, owners may change them between steps
+ *      iterations      passes over every contact point per solve
+ *      restitution     fraction of the approach speed kept, bouncing apart
+ *      rest_speed      approach speed below which contacts do not bounce, so resting
+ *                      bodies settle rather than jitter
+ *      baumgarte       fraction of the penetration beyond slop pushed out per step
+ *      slop            penetration left alone, so contacts persist between steps
+ */
+struct PhysicsSolver
+{
+    size_t iterations;
+    float restitution;
+    float rest_speed;
+    float baumgarte;
+    float slop;
+};
+
+
+/* a contact point's terms fixed for one solve: its offsets from the two centres,
+ * effective mass along the normal, and target separating speed
+ */
+struct PhysicsPoint
+{
+    Vector2 ra;
+    Vector2 rb;
+    float mass;
+    float bias;
+};
+
+
+struct PhysicsWorld
+{
+    Vector2 *position;
+    Vector2 *prev_position;
+    Vector2 *velocity;
+    float *rotation;
+    float *spin;
+    float *radius;
+    float *inv_mass;
+    float *inv_moi;
+    bool *alive;
+    size_t len;
+    size_t max;
+    size_t num_dead;
+    Vector2 size;
+
+    struct PhysicsContact *contacts;
+    size_t num_contacts;
+    size_t max_contacts;
+    struct PhysicsInterval *order;
+
+    struct PhysicsSolver solver;
+    struct PhysicsManifold *cache;
+    size_t num_cached;
+    size_t max_cached;
+    struct PhysicsPoint *points;
+    size_t max_points;
+};
+
+
+struct PhysicsWorld *physics_world_create(size_t max, Vector2 size);
+void physics_world_destroy(struct PhysicsWorld *world);
+bool physics_world_reserve(struct PhysicsWorld *world, size_t max);
+
+size_t physics_body_create(struct PhysicsWorld *world, const struct PhysicsBody *def);
+void physics_body_destroy(struct PhysicsWorld *world, size_t i);
+bool physics_body_alive(const struct PhysicsWorld *world, size_t i);
+void physics_world_compact(struct PhysicsWorld *world);
+
+void physics_world_step(struct PhysicsWorld *world, float dt);
+size_t physics_world_contacts(
+    struct PhysicsWorld *world, const struct PhysicsContact **contacts
+);
+bool physics_world_solve(
+    struct PhysicsWorld *world, struct PhysicsManifold *manifolds, size_t n, float dt
+);
+bool physics_world_cache(
+    struct PhysicsWorld *world, const struct PhysicsManifold *manifolds, size_t n
+);
+
+void physics_integrate_wrap_scalar(
+    Vector2 *position, Vector2 *prev_position, const Vector2 *velocity,
+    const float *radius, float *rotation, const float *spin,
+    size_t begin, size_t end, float dt, Vector2 size
+);
+void physics_integrate_wrap(
+    Vector2 *position, Vector2 *prev_position, const Vector2 *velocity,
+    const float *radius, float *rotation, const float *spin,
+    size_t n, float dt, Vector2 size
+);
+
+#endif
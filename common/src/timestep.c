@@ -0,0 +1,75 @@
+#include <stdlib.h>
+
+/*  fixed timestep
+ *      frame time is banked in an accumulator and spent in whole ticks of a fixed
+ *      length, so the simulation behaves the same at any frame rate; what is left over
+ *      (less than a tick) gives the fraction to interpolate rendering by
+ *
+ *      at most max_steps ticks are run per frame: beyond that the backlog is dropped
+ *      rather than carried, so a slow frame cannot snowball into ever slower ones
+ */
+
+#define TIMESTEP_RATE_DEFAULT 60
+#define TIMESTEP_MAX_STEPS_DEFAULT 8
+
+
+struct FixedStep
+{
+    double tick;
+    double accumulator;
+    size_t max_steps;
+    size_t dropped;
+};
+
+
+struct FixedStep fixedstep_create(double rate, size_t max_steps)
+{
+    if (rate <= 0) rate = TIMESTEP_RATE_DEFAULT;
+    if (!max_steps) max_steps = TIMESTEP_MAX_STEPS_DEFAULT;
+
+    return (struct FixedStep) {
+        .tick = 1 / rate,
+        .accumulator = 0,
+        .max_steps = max_steps,
+        .dropped = 0
+    };
+}
+
+
+/* bank frame_time, and return how many ticks to simulate this frame */
+size_t fixedstep_advance(struct FixedStep *fs, double frame_time)
+{
+    if (!fs || frame_time <= 0) return 0;
+
+    fs->accumulator += frame_time;
+    size_t steps = fs->accumulator / fs->tick;
+
+    if (steps > fs->max_steps) {
+        fs->dropped += steps - fs->max_steps;
+        steps = fs->max_steps;
+        fs->accumulator = steps * fs->tick;
+    }
+    fs->accumulator -= steps * fs->tick;
+
+    return steps;
+}
+
+
+/* fraction of a tick between the last simulated state and now, in [0, 1) */
+float fixedstep_alpha(struct FixedStep *fs)
+{
+    if (!fs || fs->tick <= 0) return 1;
+
+    float alpha = fs->accumulator / fs->tick;
+    return (alpha < 0) ? 0 : ((alpha > 1) ? 1 : alpha);
+}
+
+
+/* tick rate from a command line argument, or the default */
+double fixedstep_rate_arg(int argc, char **argv, int index)
+{
+    if (index >= argc) return TIMESTEP_RATE_DEFAULT;
+
+    double rate = strtod(argv[index], NULL);
+    return (rate > 0) ? rate : TIMESTEP_RATE_DEFAULT;
+}
@@ -0,0 +1,306 @@
+#include <stdlib.h>
+
+#include "../src/geometry.c"
+#include "../../common/src/bench.c"
+
+/*  batched predicate benchmark
+ *      first a property check: random primitives, often degenerate, against random
+ *      arrays of points and segments, many placed exactly on a vertex or edge or
+ *      collinear with it, and of every length around the vector widths; each batch
+ *      must agree with its scalar predicate on every element and on the count, and
+ *      any difference fails the bench
+ *
+ *      then each batch over a large array against one primitive (every bullet against
+ *      one triangle, every segment against one edge) timed beside the scalar loop
+ *
+ *      bench_batch [results.json [baseline.json]], see bench_finish
+ */
+
+#define BATCH_POINTS (1 << 20)
+#define BATCH_TRIALS 20000
+#define BATCH_TRIAL_MAX 67
+#define BATCH_REPS 20
+
+
+struct BatchBench
+{
+    Vector2 *points;
+    struct Segment *segments;
+    bool *hit;
+    struct Triangle triangle;
+    struct Segment edge;
+    size_t hits;
+};
+
+
+unsigned int batch_random(unsigned int *rng)
+{
+    unsigned int x = *rng;
+    x ^= x << 13, x ^= x >> 17, x ^= x << 5;
+    return (*rng = x);
+}
+
+
+/* small integer coordinates, so exact hits on vertices and edges are common */
+Vector2 batch_vertex(unsigned int *rng)
+{
+    return (Vector2) {
+        (int) (batch_random(rng) % 33) - 16.0f, (int) (batch_random(rng) % 33) - 16.0f
+    };
+}
+
+
+/* a point near v0 -> v1: one of its ends, a point along it, or anywhere around */
+Vector2 batch_point_near(unsigned int *rng, Vector2 v0, Vector2 v1)
+{
+    switch (batch_random(rng) % 4) {
+    case 0: return v0;
+    case 1: return v1;
+    case 2: return Vector2Lerp(v0, v1, (batch_random(rng) % 5) / 4.0f);
+    default: return batch_vertex(rng);
+    }
+}
+
+
+/* mostly proper, sometimes with corners repeated or in a line */
+struct Triangle batch_triangle(unsigned int *rng)
+{
+    struct Triangle t = { batch_vertex(rng), batch_vertex(rng), batch_vertex(rng) };
+    switch (batch_random(rng) % 8) {
+    case 0: t.v2 = t.v0; break;
+    case 1: t.v2 = Vector2Lerp(t.v0, t.v1, 2); break;
+    default: break;
+    }
+    return t;
+}
+
+
+struct Segment batch_segment(unsigned int *rng)
+{
+    struct Segment s = { batch_vertex(rng), batch_vertex(rng) };
+    if (!(batch_random(rng) % 8)) s.v1 = s.v0;
+    return s;
+}
+
+
+/* a segment near edge: sharing an end, collinear with it, parallel, or anywhere */
+struct Segment batch_segment_near(unsigned int *rng, struct Segment edge)
+{
+    switch (batch_random(rng) % 5) {
+    case 0:
+        return (struct Segment) { edge.v0, batch_vertex(rng) };
+    case 1:
+        return (struct Segment) {
+            batch_point_near(rng, edge.v0, edge.v1),
+            Vector2Lerp(edge.v0, edge.v1, ((int) (batch_random(rng) % 9) - 2) / 4.0f)
+        };
+    case 2: {
+        Vector2 d = batch_vertex(rng);
+        return (struct Segment) { Vector2Add(edge.v0, d), Vector2Add(edge.v1, d) };
+    }
+    default:
+        return batch_segment(rng);
+    }
+}
+
+
+/* number of trials where a batch disagreed with its scalar predicate */
+size_t batch_check(struct BatchBench *bench)
+{
+    unsigned int rng = 7;
+    size_t failures = 0;
+
+    for (size_t trial = 0; trial < BATCH_TRIALS; trial++) {
+        size_t n = batch_random(&rng) % (BATCH_TRIAL_MAX + 1);
+        float eps = (batch_random(&rng) % 2) ? EPSILON : 1e-3f;
+        struct Triangle t = batch_triangle(&rng);
+        struct Segment edge = batch_segment(&rng);
+
+        /* points about the triangle */
+        for (size_t i = 0; i < n; i++) {
+            Vector2 corners[3] = { t.v0, t.v1, t.v2 };
+            size_t k = batch_random(&rng) % 3;
+            bench->points[i] = batch_point_near(&rng, corners[k], corners[(k + 1) % 3]);
+        }
+        size_t count = is_point_on_triangle_batch(bench->points, n, t, eps, bench->hit);
+        size_t expect = 0;
+        bool same = true;
+        for (size_t i = 0; i < n; i++) {
+            bool hit = is_point_on_triangle(bench->points[i], t, eps);
+            same = same && (bench->hit[i] == hit);
+            expect += hit;
+        }
+        failures += !same || (count != expect);
+
+        /* points about the edge */
+        for (size_t i = 0; i < n; i++) {
+            bench->points[i] = batch_point_near(&rng, edge.v0, edge.v1);
+        }
+        count = is_point_on_segment_batch(bench->points, n, edge, eps, bench->hit);
+        expect = 0, same = true;
+        for (size_t i = 0; i < n; i++) {
+            bool hit = is_point_on_segment(bench->points[i], edge, eps);
+            same = same && (bench->hit[i] == hit);
+            expect += hit;
+        }
+        failures += !same || (count != expect);
+
+        /* segments about the edge */
+        for (size_t i = 0; i < n; i++) {
+            bench->segments[i] = batch_segment_near(&rng, edge);
+        }
+        count = is_segment_on_segment_batch(bench->segments, n, edge, bench->hit);
+        expect = 0, same = true;
+        for (size_t i = 0; i < n; i++) {
+            bool hit = is_segment_on_segment(bench->segments[i], edge);
+            same = same && (bench->hit[i] == hit);
+            expect += hit;
+        }
+        failures += !same || (count != expect);
+    }
+
+    return failures;
+}
+
+
+void bench_point_on_triangle(void *ctx)
+{
+    struct BatchBench *bench = ctx;
+    for (size_t i = 0; i < BATCH_POINTS; i++) {
+        bench->hits += is_point_on_triangle(bench->points[i], bench->triangle, EPSILON);
+    }
+}
+
+
+void bench_point_on_triangle_batch(void *ctx)
+{
+    struct BatchBench *bench = ctx;
+    bench->hits += is_point_on_triangle_batch(
+        bench->points, BATCH_POINTS, bench->triangle, EPSILON, bench->hit
+    );
+}
+
+
+void bench_point_on_segment(void *ctx)
+{
+    struct BatchBench *bench = ctx;
+    for (size_t i = 0; i < BATCH_POINTS; i++) {
+        bench->hits += is_point_on_segment(bench->points[i], bench->edge, 1e-3f);
+    }
+}
+
+
+void bench_point_on_segment_batch(void *ctx)
+{
+    struct BatchBench *bench = ctx;
+    bench->hits += is_point_on_segment_batch(
+        bench->points, BATCH_POINTS, bench->edge, 1e-3f, bench->hit
+    );
+}
+
+
+void bench_segment_on_segment(void *ctx)
+{
+    struct BatchBench *bench = ctx;
+    for (size_t i = 0; i < BATCH_POINTS; i++) {
+        bench->hits += is_segment_on_segment(bench->segments[i], bench->edge);
+    }
+}
+
+
+void bench_segment_on_segment_batch(void *ctx)
+{
+    struct BatchBench *bench = ctx;
+    bench->hits += is_segment_on_segment_batch(
+        bench->segments, BATCH_POINTS, bench->edge, bench->hit
+    );
+}
+
+
+/* points over an 800x600 field, short segments from them, and a triangle and an
+ * edge in the middle, large enough that a fair share of them hit
+ */
+void batch_setup(struct BatchBench *bench)
+{
+    unsigned int rng = 1;
+
+    for (size_t i = 0; i < BATCH_POINTS; i++) {
+        bench->points[i] = (Vector2) {
+            batch_random(&rng) % 800, batch_random(&rng) % 600
+        };
+    }
+
+    for (size_t i = 0; i < BATCH_POINTS; i++) {
+        Vector2 p = bench->points[batch_random(&rng) % BATCH_POINTS];
+        float dx = (int) (batch_random(&rng) % 129) - 64.0f;
+        float dy = (int) (batch_random(&rng) % 129) - 64.0f;
+        bench->segments[i] = (struct Segment) { p, { p.x + dx, p.y + dy } };
+    }
+
+    bench->triangle = (struct Triangle) { { 200, 150 }, { 600, 200 }, { 350, 450 } };
+    bench->edge = (struct Segment) { { 100, 100 }, { 700, 500 } };
+}
+
+
+int main(int argc, char **argv)
+{
+    struct BatchBench bench = {
+        .points = malloc(BATCH_POINTS * sizeof(Vector2)),
+        .segments = malloc(BATCH_POINTS * sizeof(struct Segment)),
+        .hit = malloc(BATCH_POINTS * sizeof(bool))
+    };
+    if (!bench.points || !bench.segments || !bench.hit) {
+        fprintf(stderr, "batch: allocation failed\n");
+        return 1;
+    }
+
+#if defined(__AVX__)
+    const char *path = "AVX";
+#elif defined(__SSE2__)
+    const char *path = "SSE2";
+#else
+    const char *path = "scalar";
+#endif
+
+    size_t failures = batch_check(&bench);
+    printf(
+        "batch, %s, %d trials against the scalar predicates: %zu failed\n", path,
+        BATCH_TRIALS, failures
+    );
+    if (failures) {
+        free(bench.points), free(bench.segments), free(bench.hit);
+        return 1;
+    }
+
+    batch_setup(&bench);
+
+    size_t np = BATCH_POINTS, reps = BATCH_REPS;
+    struct BenchResult results[] = {
+        bench_run("  is_point_on_triangle", bench_point_on_triangle, &bench, np, reps),
+        bench_run(
+            "  is_point_on_triangle_batch", bench_point_on_triangle_batch, &bench, np,
+            reps
+        ),
+        bench_run("  is_point_on_segment", bench_point_on_segment, &bench, np, reps),
+        bench_run(
+            "  is_point_on_segment_batch", bench_point_on_segment_batch, &bench, np,
+            reps
+        ),
+        bench_run(
+            "  is_segment_on_segment", bench_segment_on_segment, &bench, np, reps
+        ),
+        bench_run(
+            "  is_segment_on_segment_batch", bench_segment_on_segment_batch, &bench,
+            np, reps
+        )
+    };
+    size_t n = sizeof(results) / sizeof(results[0]);
+
+    printf("batch, %zu points and segments against one primitive\n", np);
+    for (size_t i = 0; i < n; i++) bench_report(results[i]);
+    printf("  (%zu hits)\n", bench.hits);
+
+    free(bench.points), free(bench.segments), free(bench.hit);
+
+    return !bench_finish(argc, argv, results, n);
+}
@@ -0,0 +1,188 @@
+#include <stdlib.h>
+
+#include "../src/geometry.c"
+#include "../../common/src/bench.c"
+
+/*  geometry kernel benchmark
+ *      the predicates and polygon moments from geometry.c over large random inputs,
+ *      matching asteroids/bench/geometry.c so the two sets of kernels compare directly
+ *
+ *      bench_geometry [results.json [baseline.json]], see bench_finish
+ */
+
+#define GEOMETRY_POINTS (1 << 20)
+#define GEOMETRY_POLYGONS (1 << 16)
+#define GEOMETRY_CORNERS 6
+#define GEOMETRY_RADIUS 24
+#define GEOMETRY_SPREAD 64
+#define GEOMETRY_REPS 20
+
+
+struct GeometryBench
+{
+    Vector2 *points;
+    struct Segment *segments;
+    Vector2 (*polygons)[GEOMETRY_CORNERS];
+    size_t hits;
+    float sum;
+};
+
+
+unsigned int geometry_random(unsigned int *rng)
+{
+    unsigned int x = *rng;
+    x ^= x << 13, x ^= x >> 17, x ^= x << 5;
+    return (*rng = x);
+}
+
+
+void bench_point_on_triangle(void *ctx)
+{
+    struct GeometryBench *bench = ctx;
+    for (size_t i = 0; i < GEOMETRY_POINTS; i++) {
+        Vector2 *v = bench->polygons[i % GEOMETRY_POLYGONS];
+        struct Triangle t = { v[0], v[2], v[4] };
+        bench->hits += is_point_on_triangle(bench->points[i], t, EPSILON);
+    }
+}
+
+
+void bench_point_on_segment(void *ctx)
+{
+    struct GeometryBench *bench = ctx;
+    for (size_t i = 0; i < GEOMETRY_POINTS; i++) {
+        bench->hits += is_point_on_segment(bench->points[i], bench->segments[i], 1e-3f);
+    }
+}
+
+
+void bench_segment_on_segment(void *ctx)
+{
+    struct GeometryBench *bench = ctx;
+    for (size_t i = 0; i < GEOMETRY_POINTS; i++) {
+        bench->hits += is_segment_on_segment(
+            bench->segments[i], bench->segments[(i + 1) % GEOMETRY_POINTS]
+        );
+    }
+}
+
+
+void bench_polygon_axis_separate(void *ctx)
+{
+    struct GeometryBench *bench = ctx;
+    for (size_t i = 0; i < GEOMETRY_POLYGONS; i++) {
+        bench->hits += is_polygon_axis_separate(
+            bench->polygons[i], GEOMETRY_CORNERS,
+            bench->polygons[(i + 1) % GEOMETRY_POLYGONS], GEOMETRY_CORNERS
+        );
+    }
+}
+
+
+void bench_polygon_area(void *ctx)
+{
+    struct GeometryBench *bench = ctx;
+    for (size_t i = 0; i < GEOMETRY_POLYGONS; i++) {
+        struct Polygon p = { GEOMETRY_CORNERS, bench->polygons[i] };
+        bench->sum += polygon_area(p);
+    }
+}
+
+
+void bench_polygon_centroid(void *ctx)
+{
+    struct GeometryBench *bench = ctx;
+    for (size_t i = 0; i < GEOMETRY_POLYGONS; i++) {
+        struct Polygon p = { GEOMETRY_CORNERS, bench->polygons[i] };
+        Vector2 c = polygon_centroid(p);
+        bench->sum += c.x + c.y;
+    }
+}
+
+
+void bench_polygon_area_moment_2(void *ctx)
+{
+    struct GeometryBench *bench = ctx;
+    for (size_t i = 0; i < GEOMETRY_POLYGONS; i++) {
+        bench->sum += polygon_area_moment_2(bench->polygons[i], GEOMETRY_CORNERS);
+    }
+}
+
+
+/* points over an 800x600 field, short segments from them, and anticlockwise convex
+ * hexagons (corners jittered around a circle) close enough that neighbours often touch
+ */
+void geometry_setup(struct GeometryBench *bench)
+{
+    unsigned int rng = 1;
+
+    for (size_t i = 0; i < GEOMETRY_POINTS; i++) {
+        bench->points[i] = (Vector2) {
+            geometry_random(&rng) % 800, geometry_random(&rng) % 600
+        };
+    }
+
+    for (size_t i = 0; i < GEOMETRY_POINTS; i++) {
+        Vector2 p = bench->points[geometry_random(&rng) % GEOMETRY_POINTS];
+        float dx = (int) (geometry_random(&rng) % 65) - 32.0f;
+        float dy = (int) (geometry_random(&rng) % 65) - 32.0f;
+        bench->segments[i] = (struct Segment) { p, { p.x + dx, p.y + dy } };
+    }
+
+    float step = 2 * PI / GEOMETRY_CORNERS;
+    for (size_t i = 0; i < GEOMETRY_POLYGONS; i++) {
+        Vector2 centre = {
+            geometry_random(&rng) % GEOMETRY_SPREAD,
+            geometry_random(&rng) % GEOMETRY_SPREAD
+        };
+        for (size_t k = 0; k < GEOMETRY_CORNERS; k++) {
+            float angle = (k + (geometry_random(&rng) % 8) / 16.0f) * step;
+            bench->polygons[i][k] = (Vector2) {
+                centre.x + GEOMETRY_RADIUS * cosf(angle),
+                centre.y + GEOMETRY_RADIUS * sinf(angle)
+            };
+        }
+    }
+}
+
+
+int main(int argc, char **argv)
+{
+    struct GeometryBench bench = {
+        .points = malloc(GEOMETRY_POINTS * sizeof(Vector2)),
+        .segments = malloc(GEOMETRY_POINTS * sizeof(struct Segment)),
+        .polygons = malloc(GEOMETRY_POLYGONS * sizeof(*bench.polygons))
+    };
+    if (!bench.points || !bench.segments || !bench.polygons) {
+        fprintf(stderr, "geometry: allocation failed\n");
+        return 1;
+    }
+
+    geometry_setup(&bench);
+
+    size_t np = GEOMETRY_POINTS, ng = GEOMETRY_POLYGONS, reps = GEOMETRY_REPS;
+    struct BenchResult results[] = {
+        bench_run("  is_point_on_triangle", bench_point_on_triangle, &bench, np, reps),
+        bench_run("  is_point_on_segment", bench_point_on_segment, &bench, np, reps),
+        bench_run(
+            "  is_segment_on_segment", bench_segment_on_segment, &bench, np, reps
+        ),
+        bench_run(
+            "  is_polygon_axis_separate", bench_polygon_axis_separate, &bench, ng, reps
+        ),
+        bench_run("  polygon_area", bench_polygon_area, &bench, ng, reps),
+        bench_run("  polygon_centroid", bench_polygon_centroid, &bench, ng, reps),
+        bench_run(
+            "  polygon_area_moment_2", bench_polygon_area_moment_2, &bench, ng, reps
+        )
+    };
+    size_t n = sizeof(results) / sizeof(results[0]);
+
+    printf("geometry, %zu points and segments, %zu polygons\n", np, ng);
+    for (size_t i = 0; i < n; i++) bench_report(results[i]);
+    printf("  (%zu hits, sum %g)\n", bench.hits, bench.sum);
+
+    free(bench.points), free(bench.segments), free(bench.polygons);
+
+    return !bench_finish(argc, argv, results, n);
+}
@@ -2,10 +2,14 @@
 #include <raymath.h>
 #include <stddef.h>
 
-struct Point { float x, float y };
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+struct Point { float x; float y; };
 struct Segment { Vector2 v0; Vector2 v1; };
 struct Triangle { Vector2 v0; Vector2 v1; Vector2 v2; };
-struct Polygon { size_t n, Vector2 *v };
+struct Polygon { size_t n; Vector2 *v; };
 
 /*
  *  VECTOR
@@ -58,7 +62,9 @@ struct Triangle triangle_translate(const struct Triangle t, const Vector2 v)
 float polygon_area(const struct Polygon p)
 {
     float area = 0;
-    for (size_t i = 0; i < p.n; i++) { area += vector2_cross(p.v[i], p.v[(i+1) % p.n]) }
+    for (size_t i = 0; i < p.n; i++) {
+        area += vector2_cross(p.v[i], p.v[(i+1) % p.n]);
+    }
     return 0.5 * fabsf(area);
 }
 
@@ -67,8 +73,8 @@ Vector2 polygon_centroid(const struct Polygon p)
 {
     Vector2 centroid = { 0 };
 
-    float denom = 0;
-    Vector2 curr = { 0 }, p.v[0];
+    float factor = 0, denom = 0;
+    Vector2 curr = { 0 }, next = p.v[0];
     for (size_t i = 0; i < p.n; i++) {
         curr = next, next = p.v[(i+1) % p.n];
         factor = vector2_cross(curr, next);
@@ -112,9 +118,11 @@ bool is_point_on_triangle(const Vector2 p, const struct Triangle t, const float
     const Vector2 dt2 = Vector2Subtract(t.v2, t.v0);
     const Vector2 dp = Vector2Subtract(p, t.v0);
 
-    const float det = fabsf(vector2_cross(dt1, dt2));
-    const float x = fabsf(vector2_cross(dp, dt2));
-    const float y = fabsf(vector2_cross(dt1, dp));
+    /* barycentric coordinates scaled by det, signs flipped for clockwise triangles */
+    const float sign = (vector2_cross(dt1, dt2) < 0) ? -1 : 1;
+    const float det = sign * vector2_cross(dt1, dt2);
+    const float x = sign * vector2_cross(dp, dt2);
+    const float y = sign * vector2_cross(dt1, dp);
 
     return (
         (det > EPSILON) && (x > -eps*det) && (y > -eps*det) && ((x+y) < (1+eps)*det)
@@ -143,11 +151,9 @@ bool is_segment_on_segment(const struct Segment s1, const struct Segment s2)
      * check that the solution has a, b in [0, 1]
      */
 
-    const Vector2
-
-    Vector2 dp = Vector2Subtract(p1, p0);
-    Vector2 dq = Vector2Subtract(q1, q0);
-    Vector2 r = Vector2Subtract(q0, p0);
+    Vector2 dp = Vector2Subtract(s1.v1, s1.v0);
+    Vector2 dq = Vector2Subtract(s2.v1, s2.v0);
+    Vector2 r = Vector2Subtract(s2.v0, s1.v0);
 
     float s = vector2_cross(r, dq);
     float t = vector2_cross(r, dp);
@@ -158,46 +164,36 @@ bool is_segment_on_segment(const struct Segment s1, const struct Segment s2)
 }
 
 
-bool is_polygon_is_axis_separate
+/*  separating axis theorem
+ *      convex polygons, anticlockwise (positive signed area) vertex lists
+ *      two polygons are disjoint iff some edge normal of one of them separates them
+ */
+bool is_polygon_axis_separate
 (
     Vector2 *vertices1, size_t n1, Vector2 *vertices2, size_t n2
 )
-{    
-    /*  separating axis theorem
-     *      two polygons intersect iff every edge-normal projection intersects
+{
+    /* perp of an anticlockwise edge points inward, so polygon 1 lies at or above
+     * base along it; polygon 2 is separated if it lies wholly below
      */
     Vector2 curr, next, norm;
-    float min, max, base, proj;
-    bool intersect;
+    float base, max;
 
     curr = (Vector2) { 0, 0 }, next = vertices1[0];
     for (size_t i = 0; i < n1; i++) {
-        intersect = false; 
-
         curr = next, next = vertices1[(i+1) % n1];
         norm = vector2_perp(Vector2Subtract(next, curr));
-
-        /* base axis *min* assuming anticlockwise points */
         base = vector2_dot(norm, curr);
 
-        proj = vector2_dot(norm, vertices2[0]);
-        min = proj, max = proj;
-        for (size_t j = 0; j < n2; j++) {
-            proj = vector2_dot(norm, vertices2[j]);
-
-            if (proj < min) min = proj;
+        max = vector2_dot(norm, vertices2[0]);
+        for (size_t j = 1; j < n2; j++) {
+            float proj = vector2_dot(norm, vertices2[j]);
             if (proj > max) max = proj;
-
-            /* we know intersection as soon as max and min are on opposite sides */
-            if (((min < base) && (max > base)) || ((min > base) && (max < base))) {
-                intersect = true;
-                break;
-            }
         }
 
-        if (!intersect) return false;
+        if (max < base) return true;
     }
-    return true;
+    return false;
 }
 
 
@@ -207,7 +203,319 @@ bool is_polygon_on_polygon
 )
 {
     return (
-        polygon_is_axis_separate(vertices1, n1, vertices2, n2) ||
-        polygon_is_axis_separate(vertices2, n2, vertices1, n1)
+        !is_polygon_axis_separate(vertices1, n1, vertices2, n2) &&
+        !is_polygon_axis_separate(vertices2, n2, vertices1, n1)
     );
 }
+
+
+/*
+ * BATCHED INTERSECTIONS
+ */
+
+
+/*  one primitive against an array of points or segments
+ *      hit[i] is set to whether the scalar predicate holds for the ith, and the
+ *      number of hits is returned. the arrays stay interleaved as the scalar
+ *      predicates take them, and are split into lanes of xs and ys as they load
+ *
+ *      with AVX 8 are tested per iteration, with SSE2 4, and the remainder (or
+ *      everything, on other targets) by the scalar predicate. the vector paths do the
+ *      same operations in the same order, with the same ordered comparisons, so the
+ *      results match the scalar ones exactly unless the compiler contracts the scalar
+ *      multiply-adds into FMAs (-mfma)
+ */
+
+
+/* hit[0 .. width) from the low bits of mask, returns how many are set */
+static inline size_t batch_store(int mask, size_t width, bool *hit)
+{
+    size_t count = 0;
+    for (size_t k = 0; k < width; k++) {
+        hit[k] = (mask >> k) & 1;
+        count += hit[k];
+    }
+    return count;
+}
+
+
+#if defined(__AVX__)
+
+/* 8 interleaved points as their xs and ys, in order */
+static inline void batch_points_avx(const Vector2 *p, __m256 *x, __m256 *y)
+{
+    const float *f = (const float *) p;
+    __m256 lo = _mm256_insertf128_ps(
+        _mm256_castps128_ps256(_mm_loadu_ps(f)), _mm_loadu_ps(f + 8), 1
+    );
+    __m256 hi = _mm256_insertf128_ps(
+        _mm256_castps128_ps256(_mm_loadu_ps(f + 4)), _mm_loadu_ps(f + 12), 1
+    );
+    *x = _mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+    *y = _mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+}
+
+
+/* 8 segments as the xs and ys of their ends, in order: segments k and k + 4 share
+ * a load, so the in-lane transpose leaves them in place
+ */
+static inline void batch_segments_avx(const struct Segment *s, __m256 *v)
+{
+    const float *f = (const float *) s;
+    __m256 r[4];
+    for (size_t k = 0; k < 4; k++) {
+        r[k] = _mm256_insertf128_ps(
+            _mm256_castps128_ps256(_mm_loadu_ps(f + 4*k)), _mm_loadu_ps(f + 4*k + 16), 1
+        );
+    }
+
+    __m256 t0 = _mm256_unpacklo_ps(r[0], r[1]), t1 = _mm256_unpackhi_ps(r[0], r[1]);
+    __m256 t2 = _mm256_unpacklo_ps(r[2], r[3]), t3 = _mm256_unpackhi_ps(r[2], r[3]);
+    v[0] = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+    v[1] = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+    v[2] = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+    v[3] = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+}
+
+#elif defined(__SSE2__)
+
+/* 4 interleaved points as their xs and ys, in order */
+static inline void batch_points_sse(const Vector2 *p, __m128 *x, __m128 *y)
+{
+    const float *f = (const float *) p;
+    __m128 lo = _mm_loadu_ps(f), hi = _mm_loadu_ps(f + 4);
+    *x = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+    *y = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+}
+
+
+/* 4 segments as the xs and ys of their ends */
+static inline void batch_segments_sse(const struct Segment *s, __m128 *v)
+{
+    const float *f = (const float *) s;
+    for (size_t k = 0; k < 4; k++) v[k] = _mm_loadu_ps(f + 4*k);
+    _MM_TRANSPOSE4_PS(v[0], v[1], v[2], v[3]);
+}
+
+#endif
+
+
+size_t is_point_on_triangle_batch
+(
+    const Vector2 *points, size_t n, const struct Triangle t, const float eps,
+    bool *hit
+)
+{
+    const Vector2 dt1 = Vector2Subtract(t.v1, t.v0);
+    const Vector2 dt2 = Vector2Subtract(t.v2, t.v0);
+    const float sign = (vector2_cross(dt1, dt2) < 0) ? -1 : 1;
+    const float det = sign * vector2_cross(dt1, dt2);
+
+    /* degenerate: nothing is inside */
+    if (!(det > EPSILON)) {
+        for (size_t i = 0; i < n; i++) hit[i] = false;
+        return 0;
+    }
+
+    size_t i = 0, count = 0;
+
+#if defined(__AVX__)
+    const __m256 v0x = _mm256_set1_ps(t.v0.x), v0y = _mm256_set1_ps(t.v0.y);
+    const __m256 d1x = _mm256_set1_ps(dt1.x), d1y = _mm256_set1_ps(dt1.y);
+    const __m256 d2x = _mm256_set1_ps(dt2.x), d2y = _mm256_set1_ps(dt2.y);
+    const __m256 s = _mm256_set1_ps(sign);
+    const __m256 lo = _mm256_set1_ps(-eps*det), hi = _mm256_set1_ps((1+eps)*det);
+
+    for (; i + 8 <= n; i += 8) {
+        __m256 px, py;
+        batch_points_avx(points + i, &px, &py);
+        __m256 dx = _mm256_sub_ps(px, v0x), dy = _mm256_sub_ps(py, v0y);
+
+        __m256 x = _mm256_mul_ps(s, _mm256_sub_ps(
+            _mm256_mul_ps(dx, d2y), _mm256_mul_ps(dy, d2x)
+        ));
+        __m256 y = _mm256_mul_ps(s, _mm256_sub_ps(
+            _mm256_mul_ps(d1x, dy), _mm256_mul_ps(d1y, dx)
+        ));
+        __m256 in = _mm256_and_ps(
+            _mm256_and_ps(
+                _mm256_cmp_ps(x, lo, _CMP_GT_OQ), _mm256_cmp_ps(y, lo, _CMP_GT_OQ)
+            ),
+            _mm256_cmp_ps(_mm256_add_ps(x, y), hi, _CMP_LT_OQ)
+        );
+        count += batch_store(_mm256_movemask_ps(in), 8, hit + i);
+    }
+#elif defined(__SSE2__)
+    const __m128 v0x = _mm_set1_ps(t.v0.x), v0y = _mm_set1_ps(t.v0.y);
+    const __m128 d1x = _mm_set1_ps(dt1.x), d1y = _mm_set1_ps(dt1.y);
+    const __m128 d2x = _mm_set1_ps(dt2.x), d2y = _mm_set1_ps(dt2.y);
+    const __m128 s = _mm_set1_ps(sign);
+    const __m128 lo = _mm_set1_ps(-eps*det), hi = _mm_set1_ps((1+eps)*det);
+
+    for (; i + 4 <= n; i += 4) {
+        __m128 px, py;
+        batch_points_sse(points + i, &px, &py);
+        __m128 dx = _mm_sub_ps(px, v0x), dy = _mm_sub_ps(py, v0y);
+
+        __m128 x = _mm_mul_ps(s, _mm_sub_ps(_mm_mul_ps(dx, d2y), _mm_mul_ps(dy, d2x)));
+        __m128 y = _mm_mul_ps(s, _mm_sub_ps(_mm_mul_ps(d1x, dy), _mm_mul_ps(d1y, dx)));
+        __m128 in = _mm_and_ps(
+            _mm_and_ps(_mm_cmpgt_ps(x, lo), _mm_cmpgt_ps(y, lo)),
+            _mm_cmplt_ps(_mm_add_ps(x, y), hi)
+        );
+        count += batch_store(_mm_movemask_ps(in), 4, hit + i);
+    }
+#endif
+
+    for (; i < n; i++) {
+        hit[i] = is_point_on_triangle(points[i], t, eps);
+        count += hit[i];
+    }
+    return count;
+}
+
+
+size_t is_point_on_segment_batch
+(
+    const Vector2 *points, size_t n, const struct Segment s, const float eps,
+    bool *hit
+)
+{
+    const Vector2 ds = Vector2Subtract(s.v1, s.v0);
+    const float det = Vector2LengthSqr(ds);
+
+    /* degenerate: nothing is on it */
+    if (!(det > EPSILON)) {
+        for (size_t i = 0; i < n; i++) hit[i] = false;
+        return 0;
+    }
+
+    size_t i = 0, count = 0;
+
+#if defined(__AVX__)
+    const __m256 v0x = _mm256_set1_ps(s.v0.x), v0y = _mm256_set1_ps(s.v0.y);
+    const __m256 dsx = _mm256_set1_ps(ds.x), dsy = _mm256_set1_ps(ds.y);
+    const __m256 lo = _mm256_set1_ps(-eps*det), hi = _mm256_set1_ps((1 + eps)*det);
+    const __m256 off = _mm256_set1_ps(eps*det), sign_bit = _mm256_set1_ps(-0.0f);
+
+    for (; i + 8 <= n; i += 8) {
+        __m256 px, py;
+        batch_points_avx(points + i, &px, &py);
+        __m256 dx = _mm256_sub_ps(px, v0x), dy = _mm256_sub_ps(py, v0y);
+
+        __m256 x = _mm256_add_ps(_mm256_mul_ps(dx, dsx), _mm256_mul_ps(dy, dsy));
+        __m256 y = _mm256_andnot_ps(sign_bit, _mm256_sub_ps(
+            _mm256_mul_ps(dx, dsy), _mm256_mul_ps(dy, dsx)
+        ));
+        __m256 on = _mm256_and_ps(
+            _mm256_and_ps(
+                _mm256_cmp_ps(x, lo, _CMP_GT_OQ), _mm256_cmp_ps(x, hi, _CMP_LT_OQ)
+            ),
+            _mm256_cmp_ps(y, off, _CMP_LT_OQ)
+        );
+        count += batch_store(_mm256_movemask_ps(on), 8, hit + i);
+    }
+#elif defined(__SSE2__)
+    const __m128 v0x = _mm_set1_ps(s.v0.x), v0y = _mm_set1_ps(s.v0.y);
+    const __m128 dsx = _mm_set1_ps(ds.x), dsy = _mm_set1_ps(ds.y);
+    const __m128 lo = _mm_set1_ps(-eps*det), hi = _mm_set1_ps((1 + eps)*det);
+    const __m128 off = _mm_set1_ps(eps*det), sign_bit = _mm_set1_ps(-0.0f);
+
+    for (; i + 4 <= n; i += 4) {
+        __m128 px, py;
+        batch_points_sse(points + i, &px, &py);
+        __m128 dx = _mm_sub_ps(px, v0x), dy = _mm_sub_ps(py, v0y);
+
+        __m128 x = _mm_add_ps(_mm_mul_ps(dx, dsx), _mm_mul_ps(dy, dsy));
+        __m128 y = _mm_andnot_ps(
+            sign_bit, _mm_sub_ps(_mm_mul_ps(dx, dsy), _mm_mul_ps(dy, dsx))
+        );
+        __m128 on = _mm_and_ps(
+            _mm_and_ps(_mm_cmpgt_ps(x, lo), _mm_cmplt_ps(x, hi)),
+            _mm_cmplt_ps(y, off)
+        );
+        count += batch_store(_mm_movemask_ps(on), 4, hit + i);
+    }
+#endif
+
+    for (; i < n; i++) {
+        hit[i] = is_point_on_segment(points[i], s, eps);
+        count += hit[i];
+    }
+    return count;
+}
+
+
+/* each of segments as s1 against edge as s2, the order is_segment_on_segment takes */
+size_t is_segment_on_segment_batch
+(
+    const struct Segment *segments, size_t n, const struct Segment edge, bool *hit
+)
+{
+    size_t i = 0, count = 0;
+
+#if defined(__AVX__)
+    const Vector2 dq = Vector2Subtract(edge.v1, edge.v0);
+    const __m256 q0x = _mm256_set1_ps(edge.v0.x), q0y = _mm256_set1_ps(edge.v0.y);
+    const __m256 dqx = _mm256_set1_ps(dq.x), dqy = _mm256_set1_ps(dq.y);
+    const __m256 zero = _mm256_setzero_ps(), sign_bit = _mm256_set1_ps(-0.0f);
+
+    for (; i + 8 <= n; i += 8) {
+        __m256 v[4];
+        batch_segments_avx(segments + i, v);
+        __m256 dpx = _mm256_sub_ps(v[2], v[0]), dpy = _mm256_sub_ps(v[3], v[1]);
+        __m256 rx = _mm256_sub_ps(q0x, v[0]), ry = _mm256_sub_ps(q0y, v[1]);
+
+        __m256 s = _mm256_sub_ps(_mm256_mul_ps(rx, dqy), _mm256_mul_ps(ry, dqx));
+        __m256 t = _mm256_sub_ps(_mm256_mul_ps(rx, dpy), _mm256_mul_ps(ry, dpx));
+        __m256 u = _mm256_sub_ps(_mm256_mul_ps(dpx, dqy), _mm256_mul_ps(dpy, dqx));
+
+        /* negate all three where u < 0, as the scalar branch does */
+        __m256 flip = _mm256_and_ps(_mm256_cmp_ps(u, zero, _CMP_LT_OQ), sign_bit);
+        s = _mm256_xor_ps(s, flip), t = _mm256_xor_ps(t, flip);
+        u = _mm256_xor_ps(u, flip);
+
+        __m256 on = _mm256_and_ps(
+            _mm256_and_ps(
+                _mm256_cmp_ps(s, zero, _CMP_GE_OQ), _mm256_cmp_ps(t, zero, _CMP_GE_OQ)
+            ),
+            _mm256_and_ps(
+                _mm256_cmp_ps(s, u, _CMP_LE_OQ), _mm256_cmp_ps(t, u, _CMP_LE_OQ)
+            )
+        );
+        count += batch_store(_mm256_movemask_ps(on), 8, hit + i);
+    }
+#elif defined(__SSE2__)
+    const Vector2 dq = Vector2Subtract(edge.v1, edge.v0);
+    const __m128 q0x = _mm_set1_ps(edge.v0.x), q0y = _mm_set1_ps(edge.v0.y);
+    const __m128 dqx = _mm_set1_ps(dq.x), dqy = _mm_set1_ps(dq.y);
+    const __m128 zero = _mm_setzero_ps(), sign_bit = _mm_set1_ps(-0.0f);
+
+    for (; i + 4 <= n; i += 4) {
+        __m128 v[4];
+        batch_segments_sse(segments + i, v);
+        __m128 dpx = _mm_sub_ps(v[2], v[0]), dpy = _mm_sub_ps(v[3], v[1]);
+        __m128 rx = _mm_sub_ps(q0x, v[0]), ry = _mm_sub_ps(q0y, v[1]);
+
+        __m128 s = _mm_sub_ps(_mm_mul_ps(rx, dqy), _mm_mul_ps(ry, dqx));
+        __m128 t = _mm_sub_ps(_mm_mul_ps(rx, dpy), _mm_mul_ps(ry, dpx));
+        __m128 u = _mm_sub_ps(_mm_mul_ps(dpx, dqy), _mm_mul_ps(dpy, dqx));
+
+        /* negate all three where u < 0, as the scalar branch does */
+        __m128 flip = _mm_and_ps(_mm_cmplt_ps(u, zero), sign_bit);
+        s = _mm_xor_ps(s, flip), t = _mm_xor_ps(t, flip), u = _mm_xor_ps(u, flip);
+
+        __m128 on = _mm_and_ps(
+            _mm_and_ps(_mm_cmpge_ps(s, zero), _mm_cmpge_ps(t, zero)),
+            _mm_and_ps(_mm_cmple_ps(s, u), _mm_cmple_ps(t, u))
+        );
+        count += batch_store(_mm_movemask_ps(on), 4, hit + i);
+    }
+#endif
+
+    for (; i < n; i++) {
+        hit[i] = is_segment_on_segment(segments[i], edge);
+        count += hit[i];
+    }
+    return count;
+}
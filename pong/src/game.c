@@ -0,0 +1,54 @@
+#include <stdbool.h>
+
+/*  pong rules
+ *      the court, the paddles and ball, and the ai which plays a paddle, shared by the
+ *      game and the headless simulator; nothing here opens a window or needs raylib
+ */
+
+#define AI_LOOKAHEAD_SEC 0.3f
+#define AI_BAND (1.0f / 6)
+
+const int WINDOW_W = 800;
+const int WINDOW_H = 600;
+const float BALL_SPEED = 360.0f;
+const float BALL_RADIUS = 6.0f;
+const int PADDLE_H = 90;
+const int PADDLE_W = 6;
+const float PADDLE_INSET = 6.0f;
+const float PADDLE_SPEED = 360.0f;
+
+enum PLAYER_MOVE { MOVE_NONE, MOVE_UP, MOVE_DOWN };
+
+
+/*  ai parameters
+ *      lookahead   how long before the ball would reach its wall the ai starts to move
+ *      band        half the height of the dead zone about the paddle's centre, as a
+ *                  fraction of the paddle; the ai only moves to keep the ball inside it
+ */
+struct PongAi
+{
+    float lookahead;
+    float band;
+};
+
+
+const struct PongAi PONG_AI_DEFAULT = { AI_LOOKAHEAD_SEC, AI_BAND };
+
+
+/* the move the ai makes for the paddle with its top at top, on side -1 (left) or +1
+ * (right), given the ball's position and horizontal speed
+ */
+enum PLAYER_MOVE pong_ai_move
+(
+    const struct PongAi *ai, float side, float top, float x, float y, float vx
+)
+{
+    /* still for a ball going away, or not yet within lookahead of its wall */
+    float reach = (side > 0) ? WINDOW_W - x : x;
+    if ((side * vx <= 0) || (reach / (side * vx) > ai->lookahead)) return MOVE_NONE;
+
+    float centre = top + PADDLE_H / 2.0f, band = ai->band * PADDLE_H;
+    if (centre + band < y) return MOVE_DOWN;
+    if (centre - band > y) return MOVE_UP;
+    return MOVE_NONE;
+}
@@ -0,0 +1,184 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "game.c"
+#include "sim.c"
+
+/*  headless rally runner
+ *      plays ai against ai with no window, to see how the ai's parameters play: the
+ *      left paddle keeps PONG_AI_DEFAULT and the right one is swept over a grid of
+ *      lookaheads and bands, each configuration playing the same serves
+ *
+ *      pong-headless [--rallies N] [--lanes N] [--seed S] [--lookahead A:B:N]
+ *                    [--band A:B:N] [--tick HZ]
+ *
+ *      A:B:N is N values from A to B, or a single value. each configuration plays
+ *      --lanes rallies side by side, --rallies times over, and reports the right
+ *      paddle's share of the points, the returns per rally and the seconds per rally
+ *
+ *      the run goes event to event (see sim.c); --tick HZ steps it at a fixed rate by
+ *      the game's own rules instead, to compare results and throughput
+ */
+
+struct HeadlessSweep
+{
+    float from;
+    float to;
+    size_t steps;
+};
+
+
+struct HeadlessOptions
+{
+    size_t rallies;
+    size_t lanes;
+    unsigned int seed;
+    struct HeadlessSweep lookahead;
+    struct HeadlessSweep band;
+    float tick;
+};
+
+
+void headless_usage(const char *name)
+{
+    fprintf(
+        stderr,
+        "usage: %s [--rallies N] [--lanes N] [--seed S] [--lookahead A:B:N] "
+        "[--band A:B:N] [--tick HZ]\n",
+        name
+    );
+}
+
+
+/* A:B:N, or A alone for a single value */
+bool headless_parse_sweep(const char *val, struct HeadlessSweep *sweep)
+{
+    char *end;
+    sweep->from = sweep->to = strtof(val, &end);
+    sweep->steps = 1;
+    if (!*end) return true;
+
+    if (*end != ':') return false;
+    sweep->to = strtof(end + 1, &end);
+    if (*end != ':') return false;
+    sweep->steps = strtoul(end + 1, &end, 10);
+    return !*end && (sweep->steps > 0);
+}
+
+
+bool headless_parse(int argc, char **argv, struct HeadlessOptions *opt)
+{
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i], *val = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (!val) return false;
+
+        if (!strcmp(arg, "--rallies")) opt->rallies = strtoul(val, NULL, 10);
+        else if (!strcmp(arg, "--lanes")) opt->lanes = strtoul(val, NULL, 10);
+        else if (!strcmp(arg, "--seed")) opt->seed = strtoul(val, NULL, 10);
+        else if (!strcmp(arg, "--lookahead")) {
+            if (!headless_parse_sweep(val, &opt->lookahead)) return false;
+        }
+        else if (!strcmp(arg, "--band")) {
+            if (!headless_parse_sweep(val, &opt->band)) return false;
+        }
+        else if (!strcmp(arg, "--tick")) opt->tick = strtof(val, NULL);
+        else return false;
+
+        i++;
+    }
+
+    return (opt->rallies > 0) && (opt->lanes > 0) && !(opt->tick < 0);
+}
+
+
+float headless_sweep_value(const struct HeadlessSweep *sweep, size_t k)
+{
+    if (sweep->steps < 2) return sweep->from;
+    return sweep->from + (sweep->to - sweep->from) * k / (sweep->steps - 1);
+}
+
+
+double headless_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+
+int main(int argc, char **argv)
+{
+    struct HeadlessOptions opt = {
+        .rallies = 100,
+        .lanes = 1000,
+        .seed = 1,
+        .lookahead = { AI_LOOKAHEAD_SEC, AI_LOOKAHEAD_SEC, 1 },
+        .band = { AI_BAND, AI_BAND, 1 },
+        .tick = 0
+    };
+    if (!headless_parse(argc, argv, &opt)) {
+        headless_usage(argv[0]);
+        return 1;
+    }
+
+    size_t num_configs = opt.lookahead.steps * opt.band.steps;
+    struct PongAi (*ai)[PONG_SIDES] = malloc(num_configs * sizeof(*ai));
+    if (!ai) return 1;
+    for (size_t c = 0; c < num_configs; c++) {
+        ai[c][0] = PONG_AI_DEFAULT;
+        ai[c][1] = (struct PongAi) {
+            .lookahead = headless_sweep_value(&opt.lookahead, c / opt.band.steps),
+            .band = headless_sweep_value(&opt.band, c % opt.band.steps)
+        };
+    }
+
+    struct PongBatch *batch = pongbatch_create(
+        (const struct PongAi (*)[PONG_SIDES]) ai, num_configs, opt.lanes, opt.rallies,
+        opt.seed
+    );
+    free(ai);
+    if (!batch) {
+        fprintf(stderr, "%s: could not set up the run\n", argv[0]);
+        return 1;
+    }
+
+    printf(
+        "%zu configurations of %zu x %zu rallies, seed %u, ", num_configs, opt.lanes,
+        opt.rallies, opt.seed
+    );
+    if (opt.tick > 0) printf("ticked at %g Hz\n", opt.tick);
+    else printf("event driven\n");
+
+    double t0 = headless_now();
+    if (opt.tick > 0) while (pongbatch_tick(batch, 1 / opt.tick));
+    else while (pongbatch_advance(batch));
+    double elapsed = headless_now() - t0;
+
+    printf(
+        "%9s %6s %7s %9s %9s %7s %9s %8s\n", "lookahead", "band", "right%",
+        "rallies", "hits", "max", "seconds", "timeouts"
+    );
+    size_t rallies = 0;
+    for (size_t c = 0; c < num_configs; c++) {
+        const struct PongStats *s = batch->stats + c;
+        size_t points = s->points[0] + s->points[1];
+        printf(
+            "%9.3f %6.3f %6.1f%% %9zu %9.2f %7zu %9.2f %8zu\n",
+            batch->ai[c][1].lookahead, batch->ai[c][1].band,
+            (points) ? 100.0 * s->points[1] / points : 0.0, s->rallies,
+            (double) s->hits / s->rallies, s->hits_max, s->seconds / s->rallies,
+            s->timeouts
+        );
+        rallies += s->rallies;
+    }
+
+    printf(
+        "%.3f s, %.0f rallies/sec, %.2fM rallies/minute, %.1f %s per rally\n",
+        elapsed, rallies / elapsed, 60e-6 * rallies / elapsed,
+        (double) batch->events / rallies, (opt.tick > 0) ? "ticks" : "events"
+    );
+
+    pongbatch_destroy(batch);
+    return 0;
+}
@@ -7,22 +7,15 @@
 #define CLAY_IMPLEMENTATION
 #include "lib/clay/clay.h"
 
+#include "../../common/src/timestep.c"
+#include "game.c"
 
-const int WINDOW_W = 800;
-const int WINDOW_H = 600;
-const float BALL_SPEED = 360.0f;
-const float BALL_RADIUS = 6.0f;
-const int PADDLE_H = 90;
-const int PADDLE_W = 6;
-const float PADDLE_SPEED = 360.0f;
-const float AI_LOOKAHEAD_SEC = 0.3f;
 
 enum GAME_SCREEN { SCREEN_MAIN, SCREEN_PLAY };
 enum GAME_SCREEN game_screen = SCREEN_MAIN;
 
-enum PLAYER_MOVE { MOVE_NONE, MOVE_UP, MOVE_DOWN };
-struct Player { Vector2 pos; enum PLAYER_MOVE dir; };
-struct Ball { Vector2 pos; Vector2 vel; };
+struct Player { Vector2 pos; Vector2 prev; enum PLAYER_MOVE dir; };
+struct Ball { Vector2 pos; Vector2 prev; Vector2 vel; };
 
 struct Player player1 = { .pos = { 0.0f, 0.0f }, .dir = MOVE_NONE };
 struct Player player2 = { .pos = { 0.0f, 0.0f }, .dir = MOVE_NONE };
@@ -30,6 +23,8 @@ struct Ball ball = { .pos = { 0.0f, 0.0f }, .vel = { 0.0f, 0.0f } };
 
 bool ball_is_out = false;
 
+struct FixedStep timestep = { 0 };
+
 
 /* INTERFACE */
 
@@ -43,6 +38,7 @@ bool ball_is_out = false;
 
 void update_player(struct Player *player, float dt)
 {
+    player->prev = player->pos;
     switch (player->dir) {
         case MOVE_UP:
             player->pos.y -= PADDLE_SPEED * dt;
@@ -57,44 +53,60 @@ void update_player(struct Player *player, float dt)
 }
 
 
+/* the ball's path over the step against a paddle's face, the line its centre meets
+ * the paddle on, with side +1 if the court is to the right of the face and -1 if to
+ * the left. only a path which crosses the face towards the paddle is tested, at the
+ * time it crosses, against where the paddle had moved to by then; the ball then
+ * bounces back off the face for the rest of the step, so no speed is too high for
+ * it to be caught
+ */
+bool ball_sweep_paddle(struct Ball *ball, struct Player *player, float face, float side)
+{
+    float x0 = side * (ball->prev.x - face), x1 = side * (ball->pos.x - face);
+    if ((x0 < 0) || (x1 >= 0)) return false;
+
+    float t = x0 / (x0 - x1);
+    float y = Lerp(ball->prev.y, ball->pos.y, t);
+    float top = Lerp(player->prev.y, player->pos.y, t);
+    if ((y < top) || (y > top + PADDLE_H)) return false;
+
+    ball->pos.x = 2*face - ball->pos.x;
+    ball->vel.x *= -1;
+    return true;
+}
+
+
 void update_ball(struct Ball *ball, float dt)
 {
+    ball->prev = ball->pos;
     ball->pos = Vector2Add(ball->pos, Vector2Scale(ball->vel, dt));
 
     if ((ball->pos.y < 0) || (ball->pos.y > WINDOW_H)) ball->vel.y *= -1;
-    if (
-        (ball->pos.x < BALL_RADIUS) || (ball->pos.x > WINDOW_W - BALL_RADIUS)
-    ) ball_is_out = true;
 
-    if (ball->pos.x <= player1.pos.x + PADDLE_W + BALL_RADIUS) {
-        if ((ball->pos.y < player1.pos.y) || (ball->pos.y > player1.pos.y + PADDLE_H)) return;
-        ball->vel.x *= -1;
-    }
-    if (ball->pos.x >= player2.pos.x - BALL_RADIUS) {
-        if ((ball->pos.y < player2.pos.y) || (ball->pos.y > player2.pos.y + PADDLE_H)) return;
-        ball->vel.x *= -1;
+    if (!ball_sweep_paddle(ball, &player1, player1.pos.x + PADDLE_W + BALL_RADIUS, 1)) {
+        ball_sweep_paddle(ball, &player2, player2.pos.x - BALL_RADIUS, -1);
     }
 
-    ball->pos.x = Clamp(
-            ball->pos.x,
-            player1.pos.x + PADDLE_W + BALL_RADIUS + EPSILON,
-            player2.pos.x - BALL_RADIUS - EPSILON
-    );
+    if (
+        (ball->pos.x < BALL_RADIUS) || (ball->pos.x > WINDOW_W - BALL_RADIUS)
+    ) ball_is_out = true;
 }
 
 
 /* draw fns */
 
 
-void draw_player(struct Player *player)
+void draw_player(struct Player *player, float alpha)
 {
-    DrawRectangle(player->pos.x, player->pos.y, PADDLE_W, PADDLE_H, WHITE);
+    Vector2 pos = Vector2Lerp(player->prev, player->pos, alpha);
+    DrawRectangle(pos.x, pos.y, PADDLE_W, PADDLE_H, WHITE);
 }
 
 
-void draw_ball(struct Ball *ball)
+void draw_ball(struct Ball *ball, float alpha)
 {
-    DrawCircle(ball->pos.x, ball->pos.y, BALL_RADIUS, WHITE);
+    Vector2 pos = Vector2Lerp(ball->prev, ball->pos, alpha);
+    DrawCircle(pos.x, pos.y, BALL_RADIUS, WHITE);
 }
 
 
@@ -106,19 +118,23 @@ void pong_reset(void)
     ball_is_out = false;
 
     player1 = (struct Player) {
-        .pos = (Vector2) { 6.0f, (WINDOW_H - PADDLE_H) / 2 },
+        .pos = (Vector2) { PADDLE_INSET, (WINDOW_H - PADDLE_H) / 2 },
         .dir = MOVE_NONE
     };
     player2 = (struct Player) {
-        .pos = (Vector2) { (WINDOW_W - 6.0f - PADDLE_W), (WINDOW_H - PADDLE_H) / 2 },
+        .pos = (Vector2) {
+            (WINDOW_W - PADDLE_INSET - PADDLE_W), (WINDOW_H - PADDLE_H) / 2
+        },
         .dir = MOVE_NONE
     };
+    player1.prev = player1.pos, player2.prev = player2.pos;
 
     float theta = GetRandomValue(0, 360);
     ball = (struct Ball) {
         .pos = { WINDOW_W / 2, WINDOW_H / 2 },
         .vel = { BALL_SPEED * cosf(theta), BALL_SPEED * sinf(theta) }
     };
+    ball.prev = ball.pos;
 }
 
 
@@ -136,28 +152,14 @@ void pong_input(void)
 
 void pong_ai(void)
 {
-    if ((ball.vel.x < 0) || ((WINDOW_W - ball.pos.x) / ball.vel.x > AI_LOOKAHEAD_SEC)) {
-        player2.dir = MOVE_NONE;
-        return;
-    }
-
-    if ((player2.pos.y + 2*PADDLE_H/3) < ball.pos.y) {
-        player2.dir = MOVE_DOWN;
-        return;
-    }
-    if ((player2.pos.y + PADDLE_H/3) > ball.pos.y) {
-        player2.dir = MOVE_UP;
-        return;
-    }
-
-    player2.dir = MOVE_NONE;
+    player2.dir = pong_ai_move(
+        &PONG_AI_DEFAULT, 1, player2.pos.y, ball.pos.x, ball.pos.y, ball.vel.x
+    );
 }
 
 
-void pong_update()
+void pong_step(float dt)
 {
-    float dt = GetFrameTime();
-    pong_input();
     pong_ai();
     update_player(&player1, dt);
     update_player(&player2, dt);
@@ -167,21 +169,34 @@ void pong_update()
 }
 
 
+/* spend the frame time in fixed ticks, see common/src/timestep.c */
+void pong_update()
+{
+    pong_input();
+
+    size_t steps = fixedstep_advance(&timestep, GetFrameTime());
+    for (size_t s = 0; s < steps; s++) pong_step(timestep.tick);
+}
+
+
 void pong_draw(void)
 {
     BeginDrawing();
     ClearBackground(SKYBLUE);
 
-    draw_player(&player1);
-    draw_player(&player2);
-    draw_ball(&ball);
+    float alpha = fixedstep_alpha(&timestep);
+    draw_player(&player1, alpha);
+    draw_player(&player2, alpha);
+    draw_ball(&ball, alpha);
 
     EndDrawing();
 }
 
 
-void pong_initialise(void)
+void pong_initialise(double tick_rate)
 {
+    timestep = fixedstep_create(tick_rate, TIMESTEP_MAX_STEPS_DEFAULT);
+
     InitWindow(WINDOW_W, WINDOW_H, "pong");
     SetExitKey(KEY_Q);
     SetRandomSeed(1 + GetMouseX()*GetMouseX() + GetMouseY()*GetMouseY());
@@ -195,13 +210,14 @@ void pong_deinitialise(void)
 }
 
 
-int main(void)
+/* pong [tick rate] */
+int main(int argc, char **argv)
 {
-    pong_initialise();
+    pong_initialise(fixedstep_rate_arg(argc, argv, 1));
 
     while (!WindowShouldClose()) {
-        pong_draw();
         pong_update();
+        pong_draw();
     }
 
     pong_deinitialise();
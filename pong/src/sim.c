@@ -0,0 +1,416 @@
+#include <math.h>
+#include <stdlib.h>
+
+/*  rally simulator
+ *      many independent rallies between two ais at once, with no window. a batch runs
+ *      a set of configurations (a pair of ais each), with a number of lanes apiece; a
+ *      lane plays its rallies one after another, each served as pong_reset serves,
+ *      and adds its results to its configuration's stats
+ *
+ *      lanes are kept as a structure of arrays, dense in [0, live), so every pass over
+ *      the batch walks contiguous memory; a lane which has played all its rallies
+ *      swaps with the last live one
+ *
+ *      pongbatch_advance moves every live lane straight to its next event, found
+ *      analytically as the earliest of
+ *          the ball reaching the top or bottom wall, a paddle's face, or out
+ *          an ai starting to move, as the ball comes within its lookahead
+ *          the ball reaching an edge of an ai's band, or a paddle the end of its travel
+ *          the rally running out of time (PONG_RALLY_SEC, for serves so steep that
+ *          neither side is ever reached)
+ *      and everything moves in straight lines in between, so a rally which takes
+ *      hundreds of ticks in the game is a few dozen events here
+ *
+ *      the ais play by pong_ai_move in continuous time. the game decides once a tick,
+ *      so a paddle keeping the ball at the edge of its band flickers between moving and
+ *      stopping; here it follows the ball at the ball's speed instead, which is what
+ *      that flicker tends to as ticks get shorter. pongbatch_tick steps the same lanes
+ *      at a fixed dt by the game's rules, to check against and to time
+ */
+
+#define PONG_SIDES 2
+#define PONG_RALLY_SEC 60
+#define PONG_EPSILON 1e-3f
+
+
+enum PONG_EVENT
+{
+    EVENT_WALL,
+    EVENT_FACE,
+    EVENT_OUT,
+    EVENT_BAND,
+    EVENT_TRAVEL,
+    EVENT_TIMEOUT
+};
+
+
+/* per configuration: points won by each side, rallies ended by a point or by running
+ * out of time, and the paddle returns and seconds played over them
+ */
+struct PongStats
+{
+    size_t points[PONG_SIDES];
+    size_t rallies;
+    size_t timeouts;
+    size_t hits;
+    size_t hits_max;
+    double seconds;
+};
+
+
+struct PongBatch
+{
+    float *x;
+    float *y;
+    float *vx;
+    float *vy;
+    float *top[PONG_SIDES];
+    float *speed[PONG_SIDES];
+    float *time;
+    unsigned int *hits;
+    unsigned int *rallies_left;
+    unsigned int *rng;
+    size_t *config;
+    size_t live;
+    size_t len;
+
+    struct PongAi (*ai)[PONG_SIDES];
+    struct PongStats *stats;
+    size_t num_configs;
+
+    size_t events;
+};
+
+
+/* where the ball's centre meets each paddle's face, and where it is out */
+static const float PONG_FACE[PONG_SIDES] = {
+    PADDLE_INSET + PADDLE_W + BALL_RADIUS,
+    WINDOW_W - PADDLE_INSET - PADDLE_W - BALL_RADIUS
+};
+static const float PONG_OUT[PONG_SIDES] = { BALL_RADIUS, WINDOW_W - BALL_RADIUS };
+static const float PONG_SIDE[PONG_SIDES] = { -1, 1 };
+
+
+unsigned int pong_random(unsigned int *rng)
+{
+    unsigned int x = *rng;
+    x ^= x << 13, x ^= x >> 17, x ^= x << 5;
+    return (*rng = x);
+}
+
+
+void pongbatch_destroy(struct PongBatch *b)
+{
+    if (!b) return;
+
+    void *arrays[] = {
+        b->x, b->y, b->vx, b->vy, b->top[0], b->top[1], b->speed[0], b->speed[1],
+        b->time, b->hits, b->rallies_left, b->rng, b->config, b->ai, b->stats
+    };
+    for (size_t k = 0; k < sizeof(arrays) / sizeof(arrays[0]); k++) {
+        if (arrays[k]) free(arrays[k]);
+    }
+    free(b);
+}
+
+
+/* the speed the ai on side s sets its paddle to, in continuous time (see above) */
+float pongbatch_decide(const struct PongBatch *b, size_t i, size_t s)
+{
+    const struct PongAi *ai = b->ai[b->config[i]] + s;
+    float side = PONG_SIDE[s], top = b->top[s][i];
+
+    /* still, as pong_ai_move, unless the ball is coming and within lookahead */
+    float reach = (side > 0) ? WINDOW_W - b->x[i] : b->x[i];
+    float approach = side * b->vx[i];
+    if ((approach <= 0) || (reach > ai->lookahead * approach + PONG_EPSILON)) return 0;
+
+    /* after it across the band, or with it along an edge it is leaving by */
+    float d = b->y[i] - (top + PADDLE_H / 2.0f), band = ai->band * PADDLE_H;
+    float vy = b->vy[i], speed = 0;
+    if (d > band + PONG_EPSILON) speed = PADDLE_SPEED;
+    else if (d < -band - PONG_EPSILON) speed = -PADDLE_SPEED;
+    else if ((d >= band - PONG_EPSILON) && (vy > 0)) speed = fminf(vy, PADDLE_SPEED);
+    else if ((d <= -band + PONG_EPSILON) && (vy < 0)) speed = fmaxf(vy, -PADDLE_SPEED);
+
+    /* never past either end of its travel */
+    if ((speed < 0) && (top <= PONG_EPSILON)) speed = 0;
+    if ((speed > 0) && (top >= WINDOW_H - PADDLE_H - PONG_EPSILON)) speed = 0;
+    return speed;
+}
+
+
+/* a fresh rally on lane i: both paddles centred and the ball served from the middle
+ * at a whole number of radians in [0, 360], as pong_reset serves it
+ */
+void pongbatch_serve(struct PongBatch *b, size_t i)
+{
+    float theta = pong_random(b->rng + i) % 361;
+
+    b->x[i] = WINDOW_W / 2, b->y[i] = WINDOW_H / 2;
+    b->vx[i] = BALL_SPEED * cosf(theta), b->vy[i] = BALL_SPEED * sinf(theta);
+    b->time[i] = 0, b->hits[i] = 0;
+    for (size_t s = 0; s < PONG_SIDES; s++) {
+        b->top[s][i] = (WINDOW_H - PADDLE_H) / 2;
+        b->speed[s][i] = 0;
+    }
+    for (size_t s = 0; s < PONG_SIDES; s++) b->speed[s][i] = pongbatch_decide(b, i, s);
+}
+
+
+/* move lane i into slot j, over whatever was there */
+void pongbatch_move(struct PongBatch *b, size_t i, size_t j)
+{
+    b->x[j] = b->x[i], b->y[j] = b->y[i];
+    b->vx[j] = b->vx[i], b->vy[j] = b->vy[i];
+    for (size_t s = 0; s < PONG_SIDES; s++) {
+        b->top[s][j] = b->top[s][i], b->speed[s][j] = b->speed[s][i];
+    }
+    b->time[j] = b->time[i], b->hits[j] = b->hits[i];
+    b->rallies_left[j] = b->rallies_left[i], b->rng[j] = b->rng[i];
+    b->config[j] = b->config[i];
+}
+
+
+/* end lane i's rally, won by side winner or by nobody (PONG_SIDES) in time; returns
+ * whether the lane is still live, if not the last live lane has taken its place
+ */
+bool pongbatch_finish(struct PongBatch *b, size_t i, size_t winner)
+{
+    struct PongStats *stats = b->stats + b->config[i];
+    if (winner < PONG_SIDES) stats->points[winner]++;
+    else stats->timeouts++;
+    stats->rallies++;
+    stats->hits += b->hits[i];
+    if (b->hits[i] > stats->hits_max) stats->hits_max = b->hits[i];
+    stats->seconds += b->time[i];
+
+    if (--b->rallies_left[i]) {
+        pongbatch_serve(b, i);
+        return true;
+    }
+    pongbatch_move(b, --b->live, i);
+    return false;
+}
+
+
+/* num_configs pairs of ais (left, right), each given lanes lanes playing rallies
+ * rallies between them, so lanes * rallies in all; seed fixes every serve
+ */
+struct PongBatch *pongbatch_create
+(
+    const struct PongAi (*ai)[PONG_SIDES], size_t num_configs, size_t lanes,
+    size_t rallies, unsigned int seed
+)
+{
+    if (!ai || !num_configs || !lanes || !rallies) return NULL;
+
+    struct PongBatch *b = malloc(sizeof(struct PongBatch));
+    if (!b) return NULL;
+
+    size_t len = num_configs * lanes;
+    *b = (struct PongBatch) { .live = len, .len = len, .num_configs = num_configs };
+    b->x = malloc(len * sizeof(float)), b->y = malloc(len * sizeof(float));
+    b->vx = malloc(len * sizeof(float)), b->vy = malloc(len * sizeof(float));
+    for (size_t s = 0; s < PONG_SIDES; s++) {
+        b->top[s] = malloc(len * sizeof(float));
+        b->speed[s] = malloc(len * sizeof(float));
+    }
+    b->time = malloc(len * sizeof(float));
+    b->hits = malloc(len * sizeof(unsigned int));
+    b->rallies_left = malloc(len * sizeof(unsigned int));
+    b->rng = malloc(len * sizeof(unsigned int));
+    b->config = malloc(len * sizeof(size_t));
+    b->ai = malloc(num_configs * sizeof(*b->ai));
+    b->stats = calloc(num_configs, sizeof(struct PongStats));
+    if (
+        !b->x || !b->y || !b->vx || !b->vy || !b->top[0] || !b->top[1] ||
+        !b->speed[0] || !b->speed[1] || !b->time || !b->hits || !b->rallies_left ||
+        !b->rng || !b->config || !b->ai || !b->stats
+    ) {
+        pongbatch_destroy(b);
+        return NULL;
+    }
+
+    for (size_t c = 0; c < num_configs; c++) {
+        for (size_t s = 0; s < PONG_SIDES; s++) b->ai[c][s] = ai[c][s];
+    }
+
+    /* every lane its own stream, so results do not depend on the order lanes run in */
+    for (size_t i = 0; i < len; i++) {
+        b->config[i] = i / lanes;
+        b->rallies_left[i] = rallies;
+        b->rng[i] = seed + i * 0x9e3779b9u;
+        if (!b->rng[i]) b->rng[i] = 1;
+        pongbatch_serve(b, i);
+    }
+
+    return b;
+}
+
+
+/* the time to lane i's next event, and which (with its side, for the paddles') */
+float pongbatch_next
+(
+    const struct PongBatch *b, size_t i, enum PONG_EVENT *event, size_t *side
+)
+{
+    float x = b->x[i], y = b->y[i], vx = b->vx[i], vy = b->vy[i];
+    float dt = PONG_RALLY_SEC - b->time[i];
+    *event = EVENT_TIMEOUT, *side = 0;
+
+    if (vy != 0) {
+        float t = ((vy > 0) ? WINDOW_H - y : -y) / vy;
+        if (t < dt) dt = t, *event = EVENT_WALL;
+    }
+
+    /* the face of the paddle the ball heads for, or out once past it */
+    if (vx != 0) {
+        size_t s = (vx > 0);
+        bool before = (PONG_SIDE[s] * (PONG_FACE[s] - x) > 0);
+        float t = (((before) ? PONG_FACE[s] : PONG_OUT[s]) - x) / vx;
+        if (t < dt) dt = t, *event = (before) ? EVENT_FACE : EVENT_OUT, *side = s;
+    }
+
+    for (size_t s = 0; s < PONG_SIDES; s++) {
+        const struct PongAi *ai = b->ai[b->config[i]] + s;
+        float top = b->top[s][i], speed = b->speed[s][i];
+
+        /* coming within lookahead, at a constant approach speed */
+        float reach = (s) ? WINDOW_W - x : x, approach = PONG_SIDE[s] * vx;
+        float late = reach - ai->lookahead * approach;
+        if ((approach > 0) && (late > PONG_EPSILON)) {
+            float t = late / approach;
+            if (t < dt) dt = t, *event = EVENT_BAND, *side = s;
+        }
+        if (!(approach > 0) || (late > PONG_EPSILON)) continue;
+
+        /* the ball reaching an edge of the band ahead of it, relative to the paddle;
+         * one it is already at was decided on, and would only fire again and again
+         */
+        float d = y - (top + PADDLE_H / 2.0f), band = ai->band * PADDLE_H;
+        float rate = vy - speed;
+        float edge = (rate > 0)
+            ? ((d < -band - PONG_EPSILON) ? -band : band)
+            : ((d > band + PONG_EPSILON) ? band : -band);
+        if ((rate != 0) && ((edge - d) * ((rate > 0) ? 1 : -1) > PONG_EPSILON)) {
+            float t = (edge - d) / rate;
+            if (t < dt) dt = t, *event = EVENT_BAND, *side = s;
+        }
+
+        /* the paddle reaching the end of its travel */
+        if (speed != 0) {
+            float t = (((speed > 0) ? WINDOW_H - PADDLE_H : 0) - top) / speed;
+            if (t < dt) dt = t, *event = EVENT_TRAVEL, *side = s;
+        }
+    }
+
+    return fmaxf(dt, 0);
+}
+
+
+/* move every live lane on to its next event and handle it; returns how many lanes
+ * are still live
+ */
+size_t pongbatch_advance(struct PongBatch *b)
+{
+    for (size_t i = 0; i < b->live; i++) {
+        enum PONG_EVENT event;
+        size_t s;
+        float dt = pongbatch_next(b, i, &event, &s);
+
+        b->x[i] += b->vx[i] * dt, b->y[i] += b->vy[i] * dt;
+        for (size_t p = 0; p < PONG_SIDES; p++) b->top[p][i] += b->speed[p][i] * dt;
+        b->time[i] += dt;
+        b->events++;
+
+        switch (event) {
+        case EVENT_WALL:
+            b->y[i] = (b->vy[i] > 0) ? WINDOW_H : 0;
+            b->vy[i] *= -1;
+            break;
+        case EVENT_FACE: {
+            /* the face is crossed here, so a paddle covering the ball returns it */
+            float top = b->top[s][i];
+            b->x[i] = PONG_FACE[s];
+            if ((b->y[i] >= top) && (b->y[i] <= top + PADDLE_H)) {
+                b->vx[i] *= -1;
+                b->hits[i]++;
+            }
+            break;
+        }
+        case EVENT_OUT:
+            /* the lane now holds another, which is yet to move this pass */
+            if (!pongbatch_finish(b, i, !s)) i--;
+            continue;
+        case EVENT_TIMEOUT:
+            if (!pongbatch_finish(b, i, PONG_SIDES)) i--;
+            continue;
+        case EVENT_TRAVEL:
+            b->top[s][i] = (b->speed[s][i] > 0) ? WINDOW_H - PADDLE_H : 0;
+            break;
+        case EVENT_BAND:
+            break;
+        }
+
+        for (size_t p = 0; p < PONG_SIDES; p++) {
+            b->speed[p][i] = pongbatch_decide(b, i, p);
+        }
+    }
+
+    return b->live;
+}
+
+
+/* one tick of dt for every live lane by the game's rules: both ais decide by
+ * pong_ai_move, the paddles move, and the ball moves and is swept against them as
+ * update_ball does; returns how many lanes are still live
+ */
+size_t pongbatch_tick(struct PongBatch *b, float dt)
+{
+    for (size_t i = 0; i < b->live; i++) {
+        float top0[PONG_SIDES];
+        for (size_t s = 0; s < PONG_SIDES; s++) {
+            const struct PongAi *ai = b->ai[b->config[i]] + s;
+            enum PLAYER_MOVE move = pong_ai_move(
+                ai, PONG_SIDE[s], b->top[s][i], b->x[i], b->y[i], b->vx[i]
+            );
+            float speed = (move == MOVE_DOWN) ? PADDLE_SPEED
+                : (move == MOVE_UP) ? -PADDLE_SPEED : 0;
+
+            top0[s] = b->top[s][i];
+            b->top[s][i] = fminf(fmaxf(top0[s] + speed * dt, 0), WINDOW_H - PADDLE_H);
+        }
+
+        float x0 = b->x[i], y0 = b->y[i];
+        b->x[i] += b->vx[i] * dt, b->y[i] += b->vy[i] * dt;
+        b->time[i] += dt;
+        b->events++;
+        if ((b->y[i] < 0) || (b->y[i] > WINDOW_H)) b->vy[i] *= -1;
+
+        /* as ball_sweep_paddle: crossing a face towards its paddle, while covered */
+        for (size_t s = 0; s < PONG_SIDES; s++) {
+            float side = -PONG_SIDE[s], face = PONG_FACE[s];
+            float d0 = side * (x0 - face), d1 = side * (b->x[i] - face);
+            if ((d0 < 0) || (d1 >= 0)) continue;
+
+            float t = d0 / (d0 - d1);
+            float y = y0 + (b->y[i] - y0) * t;
+            float top = top0[s] + (b->top[s][i] - top0[s]) * t;
+            if ((y < top) || (y > top + PADDLE_H)) continue;
+
+            b->x[i] = 2*face - b->x[i];
+            b->vx[i] *= -1;
+            b->hits[i]++;
+            break;
+        }
+
+        size_t winner = PONG_SIDES + 1;
+        if (b->x[i] < PONG_OUT[0]) winner = 1;
+        else if (b->x[i] > PONG_OUT[1]) winner = 0;
+        else if (b->time[i] >= PONG_RALLY_SEC) winner = PONG_SIDES;
+        if ((winner <= PONG_SIDES) && !pongbatch_finish(b, i, winner)) i--;
+    }
+
+    return b->live;
+}